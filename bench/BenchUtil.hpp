@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Shared helpers for the FlowVk benchmarks (FLOWVK_BUILD_BENCHMARKS).
+namespace flow_bench {
+
+// Median wall time of `runs` calls in milliseconds; `prepare` runs untimed before each call.
+inline double median_ms(int runs, const std::function<void()>& prepare, const std::function<void()>& body)
+{
+	std::vector<double> times;
+	times.reserve(runs);
+	for (int run = 0; run < runs; ++run)
+	{
+		if (prepare)
+			prepare();
+		const auto start = std::chrono::steady_clock::now();
+		body();
+		const auto stop = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+// Element counts from the command line, or `defaults` when none are given.
+inline std::vector<std::size_t> sizes_from_args(int argc, char* argv[], std::vector<std::size_t> defaults)
+{
+	if (argc < 2)
+		return defaults;
+	std::vector<std::size_t> sizes;
+	for (int i = 1; i < argc; ++i)
+		sizes.push_back(static_cast<std::size_t>(std::strtoull(argv[i], nullptr, 10)));
+	return sizes;
+}
+
+// Deterministic pseudo-random words (xorshift64*), so every run sorts and scans the same data.
+inline std::vector<uint64_t> random_words(std::size_t count, uint64_t seed)
+{
+	std::vector<uint64_t> out(count);
+	uint64_t state = seed ? seed : 0x9E3779B97F4A7C15ull;
+	for (auto& word : out)
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		word = state * 0x2545F4914F6CDD1Dull;
+	}
+	return out;
+}
+
+} // namespace flow_bench
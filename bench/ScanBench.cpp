@@ -0,0 +1,55 @@
+// Flow::ops::scan against std::exclusive_scan on u32 data.
+// Usage: FlowVk_ScanBench [element counts...]   (default 1K .. 64M)
+// GPU times include the submit and wait of each call; data stays on the device.
+
+#include "BenchUtil.hpp"
+
+#include <FlowVk.hpp>
+
+#include <cstdio>
+#include <numeric>
+
+static bool run_size(Flow::Instance& instance, std::size_t count)
+{
+	const auto words = flow_bench::random_words(count, count);
+	std::vector<uint32_t> input(count);
+	for (std::size_t i = 0; i < count; ++i)
+		input[i] = static_cast<uint32_t>(words[i] & 0xFF); // small values; the sums wrap like the GPU's
+
+	std::vector<uint32_t> expected(count);
+	const double cpuMs = flow_bench::median_ms(5, {}, [&] {
+		std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+	});
+
+	auto in = instance.makeReadWrite("scan_in").fromVector(input);
+	auto out = instance.makeReadWrite("scan_out").withSizeBytes(count * sizeof(uint32_t));
+
+	bool ok = true;
+	for (auto algorithm : {Flow::ops::ScanAlgorithm::DecoupledLookback, Flow::ops::ScanAlgorithm::ReduceThenScan})
+	{
+		const char* name = (algorithm == Flow::ops::ScanAlgorithm::DecoupledLookback) ? "lookback" : "reduce-then-scan";
+		const auto scan = [&] { Flow::ops::scan<uint32_t>(in, out, Flow::ops::ScanKind::Exclusive, algorithm); };
+
+		scan(); // warm-up: pipelines and scratch
+		const bool match = (out.getValues<uint32_t>() == expected);
+		ok = ok && match;
+
+		const double gpuMs = flow_bench::median_ms(9, {}, scan);
+		std::printf("%12zu  %-16s  gpu %9.3f ms (%8.1f M/s)  cpu %9.3f ms (%8.1f M/s)  x%5.2f  %s\n",
+		            count, name,
+		            gpuMs, count / gpuMs / 1e3, cpuMs, count / cpuMs / 1e3, cpuMs / gpuMs,
+		            match ? "ok" : "MISMATCH");
+	}
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	const auto sizes = flow_bench::sizes_from_args(argc, argv, {1u << 10, 1u << 14, 1u << 18, 1u << 20, 1u << 22, 1u << 24, 1u << 26});
+
+	Flow::Instance instance = Flow::makeInstance();
+	bool ok = true;
+	for (std::size_t count : sizes)
+		ok = run_size(instance, count) && ok;
+	return ok ? 0 : 1;
+}
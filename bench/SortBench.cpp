@@ -0,0 +1,98 @@
+// Flow::ops::radix_sort throughput against std::stable_sort.
+// Usage: FlowVk_SortBench [key counts...]   (default 1K .. 100M)
+// The keys are re-uploaded before every timed sort; GPU times cover the sort's submit and wait only.
+
+#include "BenchUtil.hpp"
+
+#include <FlowVk.hpp>
+
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+
+// Keys are kept below `range` so larger sizes contain duplicates and the payload check covers stability.
+template<class K>
+static std::vector<K> make_keys(std::size_t count, uint64_t range)
+{
+	const auto words = flow_bench::random_words(count, count * 31 + sizeof(K));
+	std::vector<K> keys(count);
+	for (std::size_t i = 0; i < count; ++i)
+		keys[i] = static_cast<K>(range ? words[i] % range : words[i]);
+	return keys;
+}
+
+static void print_row(std::size_t count, const char* mode, double gpuMs, double cpuMs, bool match)
+{
+	std::printf("%12zu  %-12s  gpu %10.3f ms (%8.1f Mkeys/s)  std::stable_sort %10.3f ms (%8.1f Mkeys/s)  x%6.2f  %s\n",
+	            count, mode,
+	            gpuMs, count / gpuMs / 1e3, cpuMs, count / cpuMs / 1e3, cpuMs / gpuMs,
+	            match ? "ok" : "MISMATCH");
+}
+
+template<class K>
+static bool bench_keys(Flow::Instance& instance, std::size_t count, const char* mode, int runs)
+{
+	const auto input = make_keys<K>(count, 0);
+
+	std::vector<K> expected;
+	const double cpuMs = flow_bench::median_ms(runs, [&] { expected = input; }, [&] {
+		std::stable_sort(expected.begin(), expected.end());
+	});
+
+	Flow::Buffer keys = instance.makeReadWrite("sort_keys").fromVector(input);
+	Flow::ops::radix_sort<K>(keys); // warm-up: pipelines and scratch
+	const bool match = (keys.getValues<K>() == expected);
+
+	const double gpuMs = flow_bench::median_ms(runs, [&] { keys.setValues(input); }, [&] {
+		Flow::ops::radix_sort<K>(keys);
+	});
+	print_row(count, mode, gpuMs, cpuMs, match);
+	return match;
+}
+
+// u32 keys with their original index as payload; the expected order is a stable sort of the indices by key.
+static bool bench_pairs(Flow::Instance& instance, std::size_t count, int runs)
+{
+	const auto input = make_keys<uint32_t>(count, count / 4 + 1);
+	std::vector<uint32_t> indices(count);
+	std::iota(indices.begin(), indices.end(), 0u);
+
+	std::vector<uint32_t> expected;
+	const double cpuMs = flow_bench::median_ms(runs, [&] { expected = indices; }, [&] {
+		std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return input[a] < input[b]; });
+	});
+
+	Flow::Buffer keys = instance.makeReadWrite("sort_keys").fromVector(input);
+	Flow::Buffer payload = instance.makeReadWrite("sort_payload").fromVector(indices);
+	Flow::ops::radix_sort<uint32_t>(keys, payload);
+	const bool match = (payload.getValues<uint32_t>() == expected);
+
+	const double gpuMs = flow_bench::median_ms(runs, [&] { keys.setValues(input); payload.setValues(indices); }, [&] {
+		Flow::ops::radix_sort<uint32_t>(keys, payload);
+	});
+	print_row(count, "u32+index", gpuMs, cpuMs, match);
+	return match;
+}
+
+int main(int argc, char* argv[])
+{
+	const auto sizes = flow_bench::sizes_from_args(argc, argv, {1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000});
+
+	Flow::Instance instance = Flow::makeInstance();
+	bool ok = true;
+	for (std::size_t count : sizes)
+	{
+		const int runs = (count >= 10'000'000) ? 3 : 7;
+		ok = bench_keys<uint32_t>(instance, count, "u32", runs) && ok;
+		ok = bench_pairs(instance, count, runs) && ok;
+		try
+		{
+			ok = bench_keys<uint64_t>(instance, count, "u64", runs) && ok;
+		}
+		catch (const std::runtime_error& error) // devices without shaderInt64
+		{
+			std::printf("%12zu  %-12s  skipped: %s\n", count, "u64", error.what());
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+include_guard(GLOBAL)
+
+# -----------------------------------------------------------------------------
+# Built-in kernels (Flow::ops) are compiled with glslc at library build time and
+# embedded into FlowVk as SPIR-V word arrays: <NAME>.spv.inc holds a C
+# initializer list that the op's translation unit #includes.
+# -----------------------------------------------------------------------------
+
+set(_FLOWVK_KERNEL_TYPE_IDS u32 0 i32 1 f32 2 u64 3)
+
+# -----------------------------------------------------------------------------
+# Internal: embed one kernel variant into TARGET.
+# -----------------------------------------------------------------------------
+function(_flowvk_embed_builtin_kernel)
+  set(oneValueArgs TARGET NAME SOURCE)
+  set(multiValueArgs DEFINES)
+  cmake_parse_arguments(ARG "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+  if(NOT ARG_TARGET OR NOT ARG_NAME OR NOT ARG_SOURCE)
+    message(FATAL_ERROR "_flowvk_embed_builtin_kernel: TARGET, NAME and SOURCE are required")
+  endif()
+
+  _flowvk_require_glslc()
+
+  set(_dir "${CMAKE_CURRENT_BINARY_DIR}/builtinKernels")
+  set(_inc "${_dir}/${ARG_NAME}.spv.inc")
+  get_filename_component(_src_dir "${ARG_SOURCE}" DIRECTORY)
+
+  set(_defines "")
+  foreach(DEFINE IN LISTS ARG_DEFINES)
+    list(APPEND _defines "-D${DEFINE}")
+  endforeach()
+
+  add_custom_command(
+    OUTPUT "${_inc}"
+    COMMAND ${CMAKE_COMMAND} -E make_directory "${_dir}"
+    COMMAND "${Vulkan_GLSLC_EXECUTABLE}"
+            -c
+            -fshader-stage=compute
+            --target-env=vulkan1.3
+            -O
+            -mfmt=c
+            -MD -MF "${_inc}.d"
+            -I "${_src_dir}"
+            ${_defines}
+            -o "${_inc}"
+            "${ARG_SOURCE}"
+    DEPENDS "${ARG_SOURCE}"
+    DEPFILE "${_inc}.d"
+    VERBATIM
+  )
+
+  target_sources("${ARG_TARGET}" PRIVATE "${_inc}")
+  target_include_directories("${ARG_TARGET}" PRIVATE "${_dir}")
+endfunction()
+
+# -----------------------------------------------------------------------------
+# Internal: embed <stem>_<type> for each of TYPES (u32 i32 f32 u64).
+# SUBGROUP also adds <stem>_<type>_sg built with FLOW_SUBGROUP=1 for 32-bit types.
+# -----------------------------------------------------------------------------
+function(_flowvk_embed_typed_kernels)
+  set(options SUBGROUP)
+  set(oneValueArgs TARGET SOURCE)
+  set(multiValueArgs TYPES DEFINES)
+  cmake_parse_arguments(ARG "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+  get_filename_component(_stem "${ARG_SOURCE}" NAME_WE)
+
+  foreach(TYPE IN LISTS ARG_TYPES)
+    list(FIND _FLOWVK_KERNEL_TYPE_IDS "${TYPE}" _idx)
+    if(_idx EQUAL -1)
+      message(FATAL_ERROR "_flowvk_embed_typed_kernels: unknown type '${TYPE}'")
+    endif()
+    math(EXPR _idx "${_idx} + 1")
+    list(GET _FLOWVK_KERNEL_TYPE_IDS ${_idx} _type_id)
+
+    _flowvk_embed_builtin_kernel(
+      TARGET "${ARG_TARGET}"
+      NAME "${_stem}_${TYPE}"
+      SOURCE "${ARG_SOURCE}"
+      DEFINES FLOW_TYPE=${_type_id} FLOW_SUBGROUP=0 ${ARG_DEFINES}
+    )
+    if(ARG_SUBGROUP AND NOT TYPE STREQUAL "u64")
+      _flowvk_embed_builtin_kernel(
+        TARGET "${ARG_TARGET}"
+        NAME "${_stem}_${TYPE}_sg"
+        SOURCE "${ARG_SOURCE}"
+        DEFINES FLOW_TYPE=${_type_id} FLOW_SUBGROUP=1 ${ARG_DEFINES}
+      )
+    endif()
+  endforeach()
+endfunction()
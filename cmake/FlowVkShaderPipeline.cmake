@@ -62,6 +62,22 @@ function(_flowvk_validate_unique_stems SHADERS)
   endforeach()
 endfunction()
 
+# -----------------------------------------------------------------------------
+# Internal: validate BUFFERS (how kernels reach their buffers) and default it.
+#   descriptors    - descriptor sets (default)
+#   device_address - buffer device addresses passed in push constants
+#   bindless       - handles into the instance-wide buffer table, passed in push constants
+# -----------------------------------------------------------------------------
+function(_flowvk_buffer_model OUT_VAR FUNCTION_NAME VALUE)
+  if(NOT VALUE)
+    set(VALUE "descriptors")
+  endif()
+  if(NOT VALUE MATCHES "^(descriptors|device_address|bindless)$")
+    message(FATAL_ERROR "${FUNCTION_NAME}: BUFFERS must be descriptors, device_address or bindless, got '${VALUE}'")
+  endif()
+  set(${OUT_VAR} "${VALUE}" PARENT_SCOPE)
+endfunction()
+
 # -----------------------------------------------------------------------------
 # Internal: add commands for one shader.
 # Outputs:
@@ -69,7 +85,7 @@ endfunction()
 #   <HPP_DIR>/<stem>.bindings.hpp
 #   <SPV_DIR>/<stem>.spv
 # -----------------------------------------------------------------------------
-function(_flowvk_add_one_shader OUT_GLSL OUT_HPP OUT_SPV SHADER GLSL_DIR HPP_DIR SPV_DIR)
+function(_flowvk_add_one_shader OUT_GLSL OUT_HPP OUT_SPV SHADER GLSL_DIR HPP_DIR SPV_DIR BUFFERS)
   _flowvk_ensure_shaderpp_tool()
   _flowvk_require_glslc()
 
@@ -80,6 +96,12 @@ function(_flowvk_add_one_shader OUT_GLSL OUT_HPP OUT_SPV SHADER GLSL_DIR HPP_DIR
   set(_hpp  "${HPP_DIR}/${_stem}.bindings.hpp")    
   set(_spv  "${SPV_DIR}/${_stem}.spv")             
 
+  # buffer_reference and runtime descriptor arrays are core in Vulkan 1.2 / SPIR-V 1.5.
+  set(_target_env "")
+  if(NOT BUFFERS STREQUAL "descriptors")
+    set(_target_env "--target-env=vulkan1.2")
+  endif()
+
   add_custom_command(
     OUTPUT "${_glsl}" "${_hpp}"
     COMMAND ${CMAKE_COMMAND} -E make_directory "${GLSL_DIR}"
@@ -88,6 +110,7 @@ function(_flowvk_add_one_shader OUT_GLSL OUT_HPP OUT_SPV SHADER GLSL_DIR HPP_DIR
             --in "${SHADER}"
             --out-glsl "${_glsl}"
             --out-hpp "${_hpp}"
+            --buffers "${BUFFERS}"
     DEPENDS "${SHADER}" FlowVk_ShaderPP
     VERBATIM
   )
@@ -98,6 +121,7 @@ function(_flowvk_add_one_shader OUT_GLSL OUT_HPP OUT_SPV SHADER GLSL_DIR HPP_DIR
     COMMAND "${Vulkan_GLSLC_EXECUTABLE}"
             -c
             -fshader-stage=compute
+            ${_target_env}
             -o "${_spv}"
             "${_glsl}"
     DEPENDS "${_glsl}" "${_hpp}"
@@ -173,7 +197,7 @@ endfunction()
 # Public API #3: emit only HPPs (and aggregator)
 # -----------------------------------------------------------------------------
 function(flowvk_emit_kernel_hpps)
-  set(oneValueArgs TARGET)
+  set(oneValueArgs TARGET BUFFERS)
   set(multiValueArgs SHADERS)
   cmake_parse_arguments(ARG "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
 
@@ -185,6 +209,7 @@ function(flowvk_emit_kernel_hpps)
 	endif()
 
   _flowvk_validate_unique_stems("${ARG_SHADERS}")
+  _flowvk_buffer_model(_buffers flowvk_emit_kernel_hpps "${ARG_BUFFERS}")
 
   set(_hpp_dir  "${CMAKE_CURRENT_BINARY_DIR}/shaderInclude/$<CONFIG>")
   set(_glsl_dir "${CMAKE_CURRENT_BINARY_DIR}/shaders/$<CONFIG>")
@@ -207,6 +232,7 @@ function(flowvk_emit_kernel_hpps)
               --in "${SHADER}"
               --out-glsl "${_glsl}"
               --out-hpp "${_hpp}"
+              --buffers "${_buffers}"
       DEPENDS "${SHADER}" FlowVk_ShaderPP
       VERBATIM
     )
@@ -228,7 +254,7 @@ endfunction()
 # Public API #2: build full shader artifacts (GLSL+HPP+SPV) but do NOT link FlowVk
 # -----------------------------------------------------------------------------
 function(flowvk_build_kernels)
-  set(oneValueArgs TARGET)
+  set(oneValueArgs TARGET BUFFERS)
   set(multiValueArgs SHADERS)
   cmake_parse_arguments(ARG "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
 
@@ -240,6 +266,7 @@ function(flowvk_build_kernels)
 	endif()
 
   _flowvk_validate_unique_stems("${ARG_SHADERS}")
+  _flowvk_buffer_model(_buffers flowvk_build_kernels "${ARG_BUFFERS}")
 
   set(_glsl_dir "${CMAKE_CURRENT_BINARY_DIR}/shaders/$<CONFIG>")
   set(_spv_dir  "${CMAKE_CURRENT_BINARY_DIR}/shaders/$<CONFIG>")
@@ -250,7 +277,7 @@ function(flowvk_build_kernels)
   set(all_spv  "")
 
   foreach(SHADER IN LISTS ARG_SHADERS)
-    _flowvk_add_one_shader(_glsl _hpp _spv "${SHADER}" "${_glsl_dir}" "${_hpp_dir}" "${_spv_dir}")
+    _flowvk_add_one_shader(_glsl _hpp _spv "${SHADER}" "${_glsl_dir}" "${_hpp_dir}" "${_spv_dir}" "${_buffers}")
     list(APPEND all_glsl "${_glsl}")
     list(APPEND all_hpps "${_hpp}")
     list(APPEND all_spv  "${_spv}")
@@ -278,7 +305,7 @@ endfunction()
 # Public API #1: main - build kernels AND link FlowVk
 # -----------------------------------------------------------------------------
 function(flowvk_add_kernels)
-  set(oneValueArgs TARGET)
+  set(oneValueArgs TARGET BUFFERS)
   set(multiValueArgs SHADERS)
   cmake_parse_arguments(ARG "" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
 
@@ -289,6 +316,6 @@ function(flowvk_add_kernels)
 		message(FATAL_ERROR "flowvk_add_kernels: SHADERS is required")
 	endif()
 
-  flowvk_build_kernels(TARGET "${ARG_TARGET}" SHADERS ${ARG_SHADERS})
+  flowvk_build_kernels(TARGET "${ARG_TARGET}" SHADERS ${ARG_SHADERS} BUFFERS "${ARG_BUFFERS}")
   target_link_libraries("${ARG_TARGET}" PRIVATE FlowVk::FlowVk)
 endfunction()
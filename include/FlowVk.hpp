@@ -3,6 +3,9 @@
 #include "flowVk/ShaderMeta.hpp"
 #include "flowVk/Instance.hpp"
 #include "flowVk/Buffer.hpp"
+#include "flowVk/Graph.hpp"
+#include "flowVk/Replay.hpp"
+#include "flowVk/Ops.hpp"
 
 
 #if defined(__has_include)
@@ -49,4 +49,8 @@ struct Buffer {
 	void zeroFill();
 };
 
+// Exchanges the storage behind two buffers of one instance without copying, so
+// kernels binding them by name see each other's data (ping-pong between steps).
+void swapStorage(const Buffer& a, const Buffer& b);
+
 } // namespace Flow
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Instance.hpp"
+
+namespace Flow {
+
+struct GraphImpl;
+
+// A set of kernel dispatches ordered only by the buffers they share. A node waits
+// for earlier nodes that write a buffer it reads or writes, and for earlier readers
+// of a buffer it writes (access comes from the kernel's shader metadata); nodes
+// without such a dependency share a level and may run concurrently. run() records
+// every level into one command buffer with a single barrier between levels.
+struct Graph {
+	std::shared_ptr<GraphImpl> impl;
+
+	Graph() = default;
+	explicit Graph(const Instance& instance);
+
+	explicit operator bool() const noexcept { return static_cast<bool>(impl); }
+
+	// Appends a dispatch of a kernel added with Instance::addKernel; returns the node index.
+	uint32_t addKernel(const std::string& kernelName, uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+	// As above with some shader buffers bound to other buffers; dependencies follow the bound buffers.
+	uint32_t addKernel(const std::string& kernelName, const std::vector<BindingOverride>& bindings, uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+	uint32_t nodeCount() const;
+	// Levels in the schedule; each one after the first costs a barrier.
+	uint32_t levelCount() const;
+	// Level `node` was scheduled into.
+	uint32_t levelOf(uint32_t node) const;
+
+	// Submits every node and waits. The first run records a command buffer that later
+	// runs resubmit as is; it is re-recorded after addKernel or once a bound buffer
+	// was reallocated (e.g. by resizeBytes).
+	void run();
+};
+
+} // namespace Flow
@@ -19,10 +19,81 @@ struct InstanceConfig {
 	std::string prefer_device_name_contains{};
 
 	bool enable_validation = false;
+
+	// Enable VK_KHR_push_descriptor when the device has it; kernels with one descriptor set
+	// then push their bindings at dispatch instead of allocating sets from pools.
+	bool use_push_descriptors = true;
+
+	// Record runSingleKernel(Indirect) and Buffer::zeroFill into one pending command
+	// buffer instead of submitting each call. The work is submitted by Instance::flush(),
+	// by getBytes/setBytes/resizeBytes on a buffer it uses, and before any other submission.
+	bool deferred_submission = false;
+
+	// Slots in the instance-wide table that kernels built with BUFFERS bindless index;
+	// clamped to the device's update-after-bind storage buffer limit.
+	uint32_t max_bindless_buffers = 4096;
 };
 
 struct BufferBuilder;
 
+// Binds `buffer` to the shader buffer `shaderName` for one dispatch, in place of
+// the buffer named `shaderName`. Lets one kernel ping-pong between buffers.
+struct BindingOverride {
+	std::string shaderName;
+	Buffer buffer;
+};
+
+// Options for Instance::runIterations.
+struct IterationOptions {
+	// Push the iteration number (firstIndex + i) as a uint at byte `indexOffset` of the
+	// kernel's push constant block, e.g. layout(push_constant) uniform Step { uint index; };
+	// Only for kernels built with BUFFERS descriptors; others throw.
+	bool pushIndex = false;
+	uint32_t indexOffset = 0;
+	uint32_t firstIndex = 0;
+
+	// Overrides for every iteration; entries of `oddBindings` replace them on odd iterations (ping-pong).
+	std::vector<BindingOverride> bindings{};
+	std::vector<BindingOverride> oddBindings{};
+
+	// Dispatches per command buffer; longer runs are split into back-to-back submissions.
+	uint32_t iterationsPerSubmit = 1024;
+};
+
+// Options for Instance::runUntil. The kernel reports progress through 4 bytes of
+// `value`: a uint flag/counter or a float residual.
+struct ConvergenceOptions {
+	enum struct Stop : uint8_t {
+		WhenZero,          // uint == 0, e.g. number of elements that still changed
+		WhenNonZero,       // uint != 0, e.g. a "done" flag
+		WhenBelowTolerance // float <= tolerance, e.g. an accumulated residual
+	};
+
+	Buffer value{};
+	std::size_t offsetBytes = 0;
+	Stop stop = Stop::WhenZero;
+	float tolerance = 0.0f;
+
+	// Zero the value before each checked iteration, so it only reflects that iteration.
+	bool resetBeforeCheck = true;
+
+	uint32_t maxIterations = 100000;
+	// Bounds for the number of iterations between checks, which adapts as the run goes.
+	uint32_t minInterval = 4;
+	uint32_t maxInterval = 4096;
+
+	IterationOptions iteration{};
+};
+
+struct ConvergenceResult {
+	uint32_t iterations = 0;
+	uint32_t checks = 0;
+	bool converged = false;
+	// The value at the last check, as uint and as float.
+	uint32_t flag = 0;
+	float residual = 0.0f;
+};
+
 struct Instance {
 	struct Impl;
 	std::shared_ptr<InstanceImpl> pimpl{};
@@ -30,9 +101,27 @@ struct Instance {
 	explicit operator bool() const noexcept { return static_cast<bool>(pimpl); }
 	void addKernel(const std::string& kernelName, const std::filesystem::path& spvPath);
 	void runSingleKernel(const std::string& kernelName, uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+	// As runSingleKernel, with some shader buffers bound to other allocated buffers for this dispatch only.
+	void runSingleKernel(const std::string& kernelName, const std::vector<BindingOverride>& bindings, uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+	// Dispatches the kernel `iterations` times with a compute barrier between consecutive
+	// dispatches, in as few submissions as `options.iterationsPerSubmit` allows, and waits.
+	void runIterations(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+	                   uint32_t iterations, const IterationOptions& options = {});
+	// Runs iterations as runIterations until `options.value` reports convergence or
+	// maxIterations is reached. The value is read back only every K iterations.
+	ConvergenceResult runUntil(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+	                           const ConvergenceOptions& options);
+	// As runSingleKernel, reading the group counts from a VkDispatchIndirectCommand in `args` on the device.
+	void runSingleKernelIndirect(const std::string& kernelName, const Buffer& args, std::size_t offsetBytes = 0);
 	BufferBuilder makeReadOnly(const std::string& name);
 	BufferBuilder makeWriteOnly(const std::string& name);
 	BufferBuilder makeReadWrite(const std::string& name);
+
+	// Submits work queued in deferred mode (InstanceConfig::deferred_submission) and waits.
+	void flush();
+
+	// Frees the scratch buffers built-in ops keep pooled between calls.
+	void trimScratch();
 };
 
 Instance makeInstance(const InstanceConfig& config = {});
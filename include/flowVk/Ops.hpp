@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ops/Scalar.hpp"
+#include "ops/Reduce.hpp"
+#include "ops/Scan.hpp"
+#include "ops/Sort.hpp"
+#include "ops/Gemm.hpp"
+#include "ops/Histogram.hpp"
+#include "ops/Compact.hpp"
+#include "ops/Transfer.hpp"
+#include "ops/Fft.hpp"
+#include "ops/Spmv.hpp"
+#include "ops/SegmentedReduce.hpp"
+#include "ops/Conv2d.hpp"
+#include "ops/TopK.hpp"
+#include "ops/Gather.hpp"
+#include "ops/Random.hpp"
+#include "ops/Layout.hpp"
+#include "ops/Elementwise.hpp"
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Instance.hpp"
+
+namespace Flow {
+
+struct ReplayImpl;
+
+// A fixed sequence of kernel dispatches recorded once into a command buffer and
+// resubmitted with one call. Dispatches run in the order they were added, each
+// separated from the previous one by a compute barrier. The recording tracks the
+// buffers it bound and is redone by the next submit once one of them has been
+// reallocated (e.g. by Buffer::resizeBytes).
+struct Replay {
+	std::shared_ptr<ReplayImpl> impl;
+
+	Replay() = default;
+	explicit Replay(const Instance& instance);
+
+	explicit operator bool() const noexcept { return static_cast<bool>(impl); }
+
+	// Appends a dispatch of a kernel added with Instance::addKernel.
+	Replay& addKernel(const std::string& kernelName, uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+	// As above with some shader buffers bound to other buffers (e.g. the two halves of a ping-pong step).
+	Replay& addKernel(const std::string& kernelName, const std::vector<BindingOverride>& bindings, uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+	// Whether the next submit can reuse the existing recording.
+	bool isRecorded() const;
+
+	// Records if needed, submits and waits.
+	void submit();
+};
+
+} // namespace Flow
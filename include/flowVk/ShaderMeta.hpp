@@ -7,6 +7,18 @@ namespace Flow::shader_meta {
 
 enum class Access : uint8_t { ReadOnly, WriteOnly, ReadWrite };
 enum class Layout : uint8_t { Std430, Std140, Scalar, Unknown };
+// How a kernel reaches its buffers: its own descriptor sets, 64-bit buffer device
+// addresses, or handles into the instance-wide bindless table (set 0, binding 0).
+// FlowVk writes addresses and handles into the push constant block at dispatch.
+enum class BufferModel : uint8_t { Descriptors, DeviceAddress, Bindless };
+
+// One top-level member of a buffer's element struct, at its offset under the buffer's layout.
+struct ElementField {
+	std::string_view name;
+	std::string_view type_name;
+	uint32_t offset;
+	uint32_t size;
+};
 
 struct BufferBinding {
 	std::string_view name;
@@ -15,11 +27,25 @@ struct BufferBinding {
 	Layout layout;
 	uint32_t set;
 	uint32_t binding;
+
+	// Distance between consecutive elements in bytes; 0 when FlowVk_ShaderPP could not lay out the type.
+	uint32_t element_stride = 0;
+	// Members of the element struct; empty for non-struct element types.
+	std::span<const ElementField> element_fields = {};
+	// DeviceAddress / Bindless: byte offset of the buffer's address (8 bytes) or table
+	// handle (4 bytes) in the push constant block.
+	uint32_t push_offset = 0;
+	// DeviceAddress: byte offset of the buffer's element count (uint) in the push constant
+	// block; shaders read it in place of name.data.length().
+	uint32_t count_offset = 0;
 };
 
 struct Module {
 	std::string_view kernel_name;
 	std::span<const BufferBinding> buffers;
+	BufferModel buffer_model = BufferModel::Descriptors;
+	// Bytes at the start of the push constant block written by FlowVk; kernels' own push values go after.
+	uint32_t push_bytes = 0;
 };
 
 } // namespace Flow::shader_meta
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+enum struct CompareOp : uint8_t { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+// Keeps elements e for which `e op value` holds.
+template<Scalar T>
+struct Predicate {
+	CompareOp op = CompareOp::NotEqual;
+	T value{};
+};
+
+enum struct CompactOutput : uint8_t { Values, Indices };
+
+// What compact() leaves in its count buffer: a VkDispatchIndirectCommand covering
+// the kept elements, then the count itself. Pass the buffer straight to
+// Instance::runSingleKernelIndirect to process exactly the selected elements.
+// groupCountX is clamped to the device's X group limit; when more elements are kept than
+// that many groups cover, the consumer must loop over `count` with a grid stride.
+struct CompactCount {
+	uint32_t groupCountX;
+	uint32_t groupCountY;
+	uint32_t groupCountZ;
+	uint32_t count;
+};
+
+namespace detail {
+void compact(const Buffer& input, const Buffer* flags, ScalarType type, CompareOp op, uint64_t valueBits,
+             const Buffer& output, const Buffer& count, CompactOutput mode, uint32_t indirectGroupSize);
+}
+
+// Writes the elements of `input` (interpreted as T[]) matching `keep`, in order, to the front of
+// `output` (or their uint32_t indices with CompactOutput::Indices). `count` (at least a CompactCount)
+// receives the number kept plus group counts for a follow-up kernel with `indirectGroupSize` invocations.
+template<Scalar T>
+void compact(const Buffer& input, const Predicate<T>& keep, const Buffer& output, const Buffer& count,
+             CompactOutput mode = CompactOutput::Values, uint32_t indirectGroupSize = 256)
+{
+	detail::compact(input, nullptr, scalar_type_v<T>, keep.op, detail::scalar_bits(keep.value), output, count, mode, indirectGroupSize);
+}
+
+// As above, keeping element i where `flags` (uint32_t[]) holds a non-zero value, e.g. written by an own kernel.
+template<Scalar T>
+void compact(const Buffer& input, const Buffer& flags, const Buffer& output, const Buffer& count,
+             CompactOutput mode = CompactOutput::Values, uint32_t indirectGroupSize = 256)
+{
+	detail::compact(input, &flags, scalar_type_v<T>, CompareOp::NotEqual, 0, output, count, mode, indirectGroupSize);
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../Buffer.hpp"
+
+namespace Flow::ops {
+
+// How pixels outside the image read. Mirror reflects without repeating the edge pixel.
+enum struct BorderMode : uint8_t { Zero, Clamp, Wrap, Mirror };
+
+// `batch` row-major float images of width x height, back to back, filtered by a
+// kernelWidth x kernelHeight (both odd, at most 33) row-major weights buffer.
+struct Conv2dDesc {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t batch = 1;
+	uint32_t kernelWidth = 3;
+	uint32_t kernelHeight = 3;
+	BorderMode border = BorderMode::Clamp;
+
+	// Applies the filter this many times, ping-ponging in one submission (e.g. PDE steps).
+	uint32_t steps = 1;
+
+	// The weights are the two 1D factors of a rank-1 kernel, kernelWidth row weights followed by
+	// kernelHeight column weights (see factor_separable), and run as a horizontal then a vertical pass.
+	bool separable = false;
+};
+
+// Splits row-major kernelWidth x kernelHeight `weights` into the factors Conv2dDesc::separable
+// expects (row weights, then column weights). Returns false when the weights are not rank 1.
+bool factor_separable(const std::vector<float>& weights, uint32_t kernelWidth, uint32_t kernelHeight, std::vector<float>& factors);
+
+// Convolution: the weights are mirrored, out(x, y) = sum w(i, j) * in(x - i, y - j).
+void conv2d(const Buffer& input, const Buffer& output, const Buffer& weights, const Conv2dDesc& desc);
+
+// Stencil (correlation): out(x, y) = sum w(i, j) * in(x + i, y + j), weights as written.
+void stencil2d(const Buffer& input, const Buffer& output, const Buffer& weights, const Conv2dDesc& desc);
+
+} // namespace Flow::ops
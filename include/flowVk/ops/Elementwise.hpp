@@ -0,0 +1,158 @@
+#pragma once
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include "../Buffer.hpp"
+
+namespace Flow::ops {
+
+// Instructions of a fused elementwise program. Must match OP_* in elementwise.comp.
+enum struct ExprOp : uint8_t {
+	Buffer, Constant,
+	Add, Sub, Mul, Div, Min, Max, Pow, Less, Greater,
+	Select,
+	Neg, Abs, Sqrt, Exp, Log, Sin, Cos, Tanh, Relu, Sigmoid, Floor,
+};
+
+namespace detail {
+
+// Postfix program built from an expression; its instructions are the cache key of the fused kernel.
+struct ExprProgram {
+	static constexpr uint32_t kMaxInstructions = 32;
+	static constexpr uint32_t kMaxInputs = 7;
+	static constexpr uint32_t kMaxConstants = 16;
+	static constexpr uint32_t kMaxStack = 8;
+
+	std::array<uint32_t, kMaxInstructions> code{};
+	uint32_t length = 0;
+	std::array<const Buffer*, kMaxInputs> inputs{};
+	uint32_t inputCount = 0;
+	std::array<float, kMaxConstants> constants{};
+	uint32_t constantCount = 0;
+	uint32_t depth = 0;
+
+	void load(const Buffer& buffer);
+	void constant(float value);
+	void apply(ExprOp op, uint32_t operands);
+
+private:
+	void emit(ExprOp op, uint32_t operand);
+};
+
+void evaluate(const Buffer& output, const ExprProgram& program);
+
+} // namespace detail
+
+// ----- Expression terms -----
+
+template<class T>
+concept ExprTerm = requires(const T& term, detail::ExprProgram& program) { term.emit(program); };
+
+struct BufferTerm {
+	const Buffer* buffer;
+	void emit(detail::ExprProgram& program) const { program.load(*buffer); }
+};
+
+struct ConstantTerm {
+	float value;
+	void emit(detail::ExprProgram& program) const { program.constant(value); }
+};
+
+template<ExprOp Op, ExprTerm... Args>
+struct ExprNode {
+	std::tuple<Args...> args;
+	void emit(detail::ExprProgram& program) const
+	{
+		std::apply([&](const auto&... arg) { (arg.emit(program), ...); }, args);
+		program.apply(Op, sizeof...(Args));
+	}
+};
+
+// Anything usable as an operand: expressions, float Buffers and arithmetic constants.
+template<class T>
+concept ExprOperand = ExprTerm<std::remove_cvref_t<T>> ||
+                      std::same_as<std::remove_cvref_t<T>, Buffer> ||
+                      std::is_arithmetic_v<std::remove_cvref_t<T>>;
+
+// Operators need at least one non-constant side, so plain arithmetic is untouched.
+template<class L, class R>
+concept ExprOperands = ExprOperand<L> && ExprOperand<R> &&
+                       !(std::is_arithmetic_v<std::remove_cvref_t<L>> && std::is_arithmetic_v<std::remove_cvref_t<R>>);
+
+// Unary functions take no plain constants, so std::sqrt(x) and friends keep winning for
+// arithmetic arguments under `using namespace Flow::ops`.
+template<class T>
+concept ExprFunctionOperand = ExprOperand<T> && !std::is_arithmetic_v<std::remove_cvref_t<T>>;
+
+template<ExprOperand T>
+auto as_term(const T& operand)
+{
+	if constexpr (ExprTerm<T>)
+		return operand;
+	else if constexpr (std::same_as<T, Buffer>)
+		return BufferTerm{&operand};
+	else
+		return ConstantTerm{static_cast<float>(operand)};
+}
+
+template<ExprOp Op, class... Args>
+auto make_expr(const Args&... args)
+{
+	return ExprNode<Op, decltype(as_term(args))...>{{as_term(args)...}};
+}
+
+// ----- Operators and functions -----
+
+template<class L, class R> requires ExprOperands<L, R> auto operator+(const L& l, const R& r) { return make_expr<ExprOp::Add>(l, r); }
+template<class L, class R> requires ExprOperands<L, R> auto operator-(const L& l, const R& r) { return make_expr<ExprOp::Sub>(l, r); }
+template<class L, class R> requires ExprOperands<L, R> auto operator*(const L& l, const R& r) { return make_expr<ExprOp::Mul>(l, r); }
+template<class L, class R> requires ExprOperands<L, R> auto operator/(const L& l, const R& r) { return make_expr<ExprOp::Div>(l, r); }
+template<class A> requires (ExprOperand<A> && !std::is_arithmetic_v<A>) auto operator-(const A& a) { return make_expr<ExprOp::Neg>(a); }
+
+template<class L, class R> requires ExprOperands<L, R> auto min(const L& l, const R& r) { return make_expr<ExprOp::Min>(l, r); }
+template<class L, class R> requires ExprOperands<L, R> auto max(const L& l, const R& r) { return make_expr<ExprOp::Max>(l, r); }
+template<class L, class R> requires ExprOperands<L, R> auto pow(const L& l, const R& r) { return make_expr<ExprOp::Pow>(l, r); }
+// 1 where the comparison holds, 0 elsewhere.
+template<class L, class R> requires ExprOperands<L, R> auto less(const L& l, const R& r) { return make_expr<ExprOp::Less>(l, r); }
+template<class L, class R> requires ExprOperands<L, R> auto greater(const L& l, const R& r) { return make_expr<ExprOp::Greater>(l, r); }
+// a where `condition` is non-zero, b elsewhere.
+template<ExprOperand C, ExprOperand A, ExprOperand B>
+	requires (!(std::is_arithmetic_v<C> && std::is_arithmetic_v<A> && std::is_arithmetic_v<B>))
+auto select(const C& condition, const A& a, const B& b) { return make_expr<ExprOp::Select>(condition, a, b); }
+
+template<class A> requires ExprFunctionOperand<A> auto abs(const A& a)     { return make_expr<ExprOp::Abs>(a); }
+template<class A> requires ExprFunctionOperand<A> auto sqrt(const A& a)    { return make_expr<ExprOp::Sqrt>(a); }
+template<class A> requires ExprFunctionOperand<A> auto exp(const A& a)     { return make_expr<ExprOp::Exp>(a); }
+template<class A> requires ExprFunctionOperand<A> auto log(const A& a)     { return make_expr<ExprOp::Log>(a); }
+template<class A> requires ExprFunctionOperand<A> auto sin(const A& a)     { return make_expr<ExprOp::Sin>(a); }
+template<class A> requires ExprFunctionOperand<A> auto cos(const A& a)     { return make_expr<ExprOp::Cos>(a); }
+template<class A> requires ExprFunctionOperand<A> auto tanh(const A& a)    { return make_expr<ExprOp::Tanh>(a); }
+template<class A> requires ExprFunctionOperand<A> auto relu(const A& a)    { return make_expr<ExprOp::Relu>(a); }
+template<class A> requires ExprFunctionOperand<A> auto sigmoid(const A& a) { return make_expr<ExprOp::Sigmoid>(a); }
+template<class A> requires ExprFunctionOperand<A> auto floor(const A& a)   { return make_expr<ExprOp::Floor>(a); }
+
+// Computes `expr` for every element of `output` (float[]) in one dispatch, e.g.
+// evaluate(out, relu(a * b + c)). Buffers in the expression are read as float[] and must
+// hold at least as many elements as `output`; `output` may also appear as an input.
+// Each distinct expression shape is specialized into its own pipeline once and cached;
+// constants are passed at dispatch time and do not trigger new pipelines.
+template<ExprOperand E>
+void evaluate(const Buffer& output, const E& expr)
+{
+	detail::ExprProgram program;
+	as_term(expr).emit(program);
+	detail::evaluate(output, program);
+}
+
+} // namespace Flow::ops
+
+namespace Flow {
+// Found by argument-dependent lookup when an operand is a plain Flow::Buffer.
+using ops::operator+;
+using ops::operator-;
+using ops::operator*;
+using ops::operator/;
+} // namespace Flow
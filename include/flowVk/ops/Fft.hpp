@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "../Instance.hpp"
+
+namespace Flow::ops {
+
+// ComplexToComplex transforms interleaved (re, im) floats of the same shape both ways.
+// RealToComplex maps nx real floats per row to nx / 2 + 1 complex values forward,
+// and that half spectrum back to nx real floats inverse.
+enum struct FftKind : uint8_t { ComplexToComplex, RealToComplex };
+
+enum struct FftDirection : uint8_t { Forward, Inverse };
+
+// `batch` independent nx (1D, ny == 1) or nx * ny (2D, row-major) transforms stored back to back.
+struct FftDesc {
+	uint32_t nx = 0;
+	uint32_t ny = 1;
+	uint32_t batch = 1;
+	FftKind kind = FftKind::ComplexToComplex;
+};
+
+struct FftPlanImpl;
+
+// Factorizes the sizes once and creates the specialized pipelines for every pass.
+// Lengths must factor into 2, 3, 5, 7, 11 and 13. Inverse transforms are unnormalized
+// (a round trip scales by nx * ny), as in FFTW and cuFFT.
+struct FftPlan {
+	std::shared_ptr<const FftPlanImpl> impl;
+
+	FftPlan() = default;
+	FftPlan(const Instance& instance, const FftDesc& desc);
+
+	explicit operator bool() const noexcept { return static_cast<bool>(impl); }
+	const FftDesc& desc() const;
+
+	// Bytes the input/output of a forward transform hold; swapped for inverse transforms.
+	std::size_t spatialBytes() const;
+	std::size_t spectrumBytes() const;
+
+	void forward(const Buffer& input, const Buffer& output) const;
+	void inverse(const Buffer& input, const Buffer& output) const;
+};
+
+// One-off transform; plans are cheap to rebuild since their pipelines stay cached on the instance.
+void fft(const Buffer& input, const Buffer& output, const FftDesc& desc, FftDirection direction = FftDirection::Forward);
+
+} // namespace Flow::ops
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+// output[i] = input[indices[i]] for every uint32_t index, moving elements of `elementBytes`
+// (1, 2 or any multiple of 4). Indices past the end of `input` produce zeroed elements.
+void gather(const Buffer& input, const Buffer& indices, const Buffer& output, std::size_t elementBytes);
+
+// output[indices[i]] = input[i]. Indices past the end of `output` are skipped; when an index
+// repeats, which element lands there is unspecified.
+void scatter(const Buffer& input, const Buffer& indices, const Buffer& output, std::size_t elementBytes);
+
+namespace detail {
+void scatter_add(const Buffer& input, const Buffer& indices, const Buffer& output, ScalarType type, uint32_t components);
+}
+
+// output[indices[i]] += input[i] with atomics, so repeated indices accumulate. Elements are
+// `components` consecutive T values. 64-bit elements require shaderBufferInt64Atomics.
+template<Scalar T>
+void scatter_add(const Buffer& input, const Buffer& indices, const Buffer& output, uint32_t components = 1)
+{
+	detail::scatter_add(input, indices, output, scalar_type_v<T>, components);
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+
+namespace Flow::ops {
+
+enum struct MatrixLayout : uint8_t {
+	RowMajor,
+	ColumnMajor
+};
+
+// Shape of C = alpha * A * B + beta * C with A: m x k, B: k x n, C: m x n.
+// With batch > 1 the buffers hold `batch` matrices back to back (no padding).
+struct GemmDesc {
+	uint32_t m = 0;
+	uint32_t n = 0;
+	uint32_t k = 0;
+
+	MatrixLayout layoutA = MatrixLayout::RowMajor;
+	MatrixLayout layoutB = MatrixLayout::RowMajor;
+	MatrixLayout layoutC = MatrixLayout::RowMajor;
+
+	float alpha = 1.0f;
+	float beta = 0.0f;
+
+	uint32_t batch = 1;
+};
+
+// Multiplies float matrices stored in `a` and `b` into `c`.
+// `c` is only read when beta != 0.
+void gemm(const Buffer& a, const Buffer& b, const Buffer& c, const GemmDesc& desc);
+
+} // namespace Flow::ops
@@ -0,0 +1,48 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+// SharedAtomics counts into per-workgroup bins in shared memory; Sort sorts the
+// bin indices and measures runs, which scales to any bin count.
+// Auto uses shared atomics while the bins fit comfortably in shared memory.
+enum struct HistogramAlgorithm : uint8_t { Auto, SharedAtomics, Sort };
+
+// `count` equal-width bins spanning [lower, upper].
+template<Scalar T>
+struct UniformBins {
+	T lower{};
+	T upper{};
+	uint32_t count = 0;
+};
+
+namespace detail {
+void histogram(const Buffer& input, const Buffer& counts, const Buffer* edges, ScalarType type,
+               uint32_t lowerBits, uint32_t upperBits, uint32_t binCount, HistogramAlgorithm algorithm);
+}
+
+// Counts the elements of `input` (interpreted as T[]) per bin into `counts` (uint32_t[bins.count]).
+// Bins are half open except the last, which includes `upper`; other values are ignored.
+template<Scalar T>
+	requires (sizeof(T) == sizeof(uint32_t))
+void histogram(const Buffer& input, const Buffer& counts, const UniformBins<T>& bins,
+               HistogramAlgorithm algorithm = HistogramAlgorithm::Auto)
+{
+	detail::histogram(input, counts, nullptr, scalar_type_v<T>,
+	                  std::bit_cast<uint32_t>(bins.lower), std::bit_cast<uint32_t>(bins.upper), bins.count, algorithm);
+}
+
+// As above with custom bins: `edges` holds N + 1 ascending T values delimiting N bins.
+template<Scalar T>
+	requires (sizeof(T) == sizeof(uint32_t))
+void histogram(const Buffer& input, const Buffer& counts, const Buffer& edges,
+               HistogramAlgorithm algorithm = HistogramAlgorithm::Auto)
+{
+	detail::histogram(input, counts, &edges, scalar_type_v<T>, 0, 0, 0, algorithm);
+}
+
+} // namespace Flow::ops
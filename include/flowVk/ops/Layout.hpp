@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "../Buffer.hpp"
+#include "../ShaderMeta.hpp"
+
+namespace Flow::ops {
+
+// Transposes `batch` row-major rows x cols matrices stored back to back in `input` into
+// cols x rows matrices in `output`. Elements are 4, 8 or 16 bytes.
+void transpose(const Buffer& input, const Buffer& output, uint32_t rows, uint32_t cols,
+               std::size_t elementBytes = 4, uint32_t batch = 1);
+
+// Splits an array of structs into one array per field: fields[i] receives member
+// `layout[i]` of every element of `aos`, which holds aos.sizeBytes() / stride elements.
+// Offsets, sizes and the stride must be multiples of 4 bytes. Empty Buffers skip a field.
+void aos_to_soa(const Buffer& aos, uint32_t stride, std::span<const shader_meta::ElementField> layout,
+                std::span<const Buffer> fields);
+
+// The inverse: writes each field array back into its member of every element of `aos`,
+// leaving members without a Buffer (and padding) untouched.
+void soa_to_aos(std::span<const Buffer> fields, uint32_t stride, std::span<const shader_meta::ElementField> layout,
+                const Buffer& aos);
+
+// As above, with the element layout FlowVk_ShaderPP generated for a @buffer, e.g.
+// aos_to_soa(particles, Flow::shader_meta::step::module.buffers[0], soaBuffers).
+inline void aos_to_soa(const Buffer& aos, const shader_meta::BufferBinding& element, std::span<const Buffer> fields)
+{
+	aos_to_soa(aos, element.element_stride, element.element_fields, fields);
+}
+
+inline void soa_to_aos(std::span<const Buffer> fields, const shader_meta::BufferBinding& element, const Buffer& aos)
+{
+	soa_to_aos(fields, element.element_stride, element.element_fields, aos);
+}
+
+} // namespace Flow::ops
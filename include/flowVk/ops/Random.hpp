@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+// Must match DISTRIBUTION_* in random.comp.
+enum struct Distribution : uint8_t { Uniform, Normal };
+
+// Element i of the buffer receives stream element `offset + i` of the generator keyed by `seed`.
+// Float elements are uniform in [lower, upper) or normal with `mean` and `stddev`; integer
+// elements are uniform over all their values (Distribution::Uniform only).
+struct RandomDesc {
+	uint64_t seed = 0;
+	uint64_t offset = 0;
+	Distribution distribution = Distribution::Uniform;
+	float lower = 0.0f;
+	float upper = 1.0f;
+	float mean = 0.0f;
+	float stddev = 1.0f;
+};
+
+namespace detail {
+void random(const Buffer& buffer, ScalarType type, const RandomDesc& desc);
+}
+
+// Fills `buffer` (interpreted as T[]) from the counter-based Philox4x32-10 generator, on the
+// device. The same seed and offset give the same values on every run, however the stream is
+// split: filling n elements at offset 0 equals filling k at offset 0 and n - k at offset k.
+template<Scalar T>
+void random(const Buffer& buffer, const RandomDesc& desc = {})
+{
+	detail::random(buffer, scalar_type_v<T>, desc);
+}
+
+} // namespace Flow::ops
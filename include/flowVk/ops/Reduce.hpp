@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+enum struct ReduceOp : uint8_t { Sum, Min, Max, ArgMin, ArgMax };
+
+template<class T>
+struct ReduceResult {
+	T value{};
+	uint32_t index = 0; // ArgMin/ArgMax only; first occurrence wins ties
+};
+
+namespace detail {
+void reduce(const Buffer& input, ScalarType type, ReduceOp op, void* outValue, uint32_t* outIndex);
+}
+
+// Reduces every element of `input` (interpreted as T[]) on the device.
+// Only the final value crosses back to the host.
+template<Scalar T>
+ReduceResult<T> reduce(const Buffer& input, ReduceOp op = ReduceOp::Sum)
+{
+	ReduceResult<T> result{};
+	detail::reduce(input, scalar_type_v<T>, op, &result.value, &result.index);
+	return result;
+}
+
+} // namespace Flow::ops
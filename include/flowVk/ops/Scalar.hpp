@@ -0,0 +1,40 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Flow::ops {
+
+// Element types the built-in kernels are compiled for.
+enum struct ScalarType : uint8_t { U32, I32, F32, U64 };
+
+template<class T>
+struct scalar_type_of;
+
+template<> struct scalar_type_of<uint32_t> : std::integral_constant<ScalarType, ScalarType::U32> {};
+template<> struct scalar_type_of<int32_t>  : std::integral_constant<ScalarType, ScalarType::I32> {};
+template<> struct scalar_type_of<float>    : std::integral_constant<ScalarType, ScalarType::F32> {};
+template<> struct scalar_type_of<uint64_t> : std::integral_constant<ScalarType, ScalarType::U64> {};
+
+template<class T>
+inline constexpr ScalarType scalar_type_v = scalar_type_of<T>::value;
+
+template<class T>
+concept Scalar = requires { scalar_type_of<T>::value; };
+
+constexpr std::size_t scalar_size(ScalarType type) noexcept
+{
+	return type == ScalarType::U64 ? 8u : 4u;
+}
+
+namespace detail {
+// Bit pattern of a scalar, zero-extended to 64 bits, for passing values through push constants.
+template<Scalar T>
+constexpr uint64_t scalar_bits(T value) noexcept
+{
+	return std::bit_cast<std::conditional_t<sizeof(T) == sizeof(uint64_t), uint64_t, uint32_t>>(value);
+}
+}
+
+} // namespace Flow::ops
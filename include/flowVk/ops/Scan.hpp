@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+enum struct ScanKind : uint8_t { Exclusive, Inclusive };
+
+// DecoupledLookback is a single pass but relies on workgroups making forward
+// progress while others spin; ReduceThenScan needs three passes and no such guarantee.
+// Auto picks lookback on vendors known to provide it.
+enum struct ScanAlgorithm : uint8_t { Auto, DecoupledLookback, ReduceThenScan };
+
+namespace detail {
+void scan(const Buffer& input, const Buffer& output, ScalarType type, ScanKind kind, ScanAlgorithm algorithm);
+}
+
+// Prefix sum of `input` (interpreted as T[]) into `output`, which must be at least as large.
+// `output` may be the same buffer as `input`.
+template<Scalar T>
+void scan(const Buffer& input, const Buffer& output, ScanKind kind = ScanKind::Exclusive, ScanAlgorithm algorithm = ScanAlgorithm::Auto)
+{
+	detail::scan(input, output, scalar_type_v<T>, kind, algorithm);
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+#include "Reduce.hpp"
+#include "Compact.hpp"
+
+namespace Flow::ops {
+
+namespace detail {
+void segmented_reduce(const Buffer& values, const Buffer& offsets, const Buffer& output, ScalarType type, ReduceOp op);
+void reduce_by_key(const Buffer& keys, const Buffer& values, const Buffer& keysOut, const Buffer& valuesOut,
+                   const Buffer& count, ScalarType type, ReduceOp op, uint32_t indirectGroupSize);
+}
+
+// Reduces `values` (interpreted as T[]) per segment: segment s covers [offsets[s], offsets[s + 1])
+// of the uint32_t `offsets` (segments + 1 ascending entries, the last at most the value count). `output` receives one T per segment;
+// empty segments get the identity (0, the type's maximum or its lowest value). Sum, Min and Max only.
+template<Scalar T>
+void segmented_reduce(const Buffer& values, const Buffer& offsets, const Buffer& output, ReduceOp op = ReduceOp::Sum)
+{
+	detail::segmented_reduce(values, offsets, output, scalar_type_v<T>, op);
+}
+
+// Reduces `values` (interpreted as T[]) over every run of equal consecutive uint32_t `keys`
+// (sort first for a full group-by). Run keys go to `keysOut` and results to `valuesOut`,
+// both sized for the worst case of one run per element. `count` receives a CompactCount
+// with the number of runs, which stays on the device.
+template<Scalar T>
+void reduce_by_key(const Buffer& keys, const Buffer& values, const Buffer& keysOut, const Buffer& valuesOut,
+                   const Buffer& count, ReduceOp op = ReduceOp::Sum, uint32_t indirectGroupSize = 256)
+{
+	detail::reduce_by_key(keys, values, keysOut, valuesOut, count, scalar_type_v<T>, op, indirectGroupSize);
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+namespace detail {
+void radix_sort(const Buffer& keys, const Buffer* payload, ScalarType keyType);
+}
+
+// Sorts `keys` (interpreted as K[]) ascending, in place and stable.
+// Signed and float keys are ordered numerically (negative floats before positive).
+template<Scalar K>
+void radix_sort(const Buffer& keys)
+{
+	detail::radix_sort(keys, nullptr, scalar_type_v<K>);
+}
+
+// As above, moving `payload` along with the keys. The payload holds one element per key;
+// its element size is sizeBytes() / key count and must be a multiple of 4 bytes.
+template<Scalar K>
+void radix_sort(const Buffer& keys, const Buffer& payload)
+{
+	detail::radix_sort(keys, &payload, scalar_type_v<K>);
+}
+
+} // namespace Flow::ops
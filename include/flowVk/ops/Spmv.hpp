@@ -0,0 +1,53 @@
+#pragma once
+#include <span>
+#include <string>
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "../Instance.hpp"
+
+namespace Flow::ops {
+
+// Csr keeps the host layout. Sell stores slices of `sliceHeight` rows padded to the
+// slice's longest row, column-major, so neighbouring rows read neighbouring memory.
+// Ell is Sell with a single slice spanning all rows.
+enum struct SparseFormat : uint8_t { Csr, Ell, Sell };
+
+// Host CSR input: rowOffsets has rows + 1 entries, columns/values one per nonzero.
+struct CsrView {
+	uint32_t rows = 0;
+	uint32_t cols = 0;
+	std::span<const uint32_t> rowOffsets;
+	std::span<const uint32_t> columns;
+	std::span<const float> values;
+};
+
+// Float matrix in named device buffers "<name>.offsets", "<name>.columns" and "<name>.values".
+// offsets holds CSR row offsets, or slice offsets for Ell/Sell.
+struct SparseMatrix {
+	SparseFormat format = SparseFormat::Csr;
+	uint32_t rows = 0;
+	uint32_t cols = 0;
+	uint32_t nnz = 0;
+	uint32_t maxRowLength = 0;
+	uint32_t sliceHeight = 0; // Ell/Sell only
+
+	Buffer offsets;
+	Buffer columns;
+	Buffer values;
+};
+
+// Uploads `csr` once in `format`; the returned matrix can be multiplied any number of times.
+SparseMatrix makeSparseMatrix(Instance& instance, const std::string& name, const CsrView& csr,
+                              SparseFormat format = SparseFormat::Csr, uint32_t sliceHeight = 32);
+
+// RowSplit gives every row a power-of-two number of invocations sized to the average row.
+// MergePath splits rows plus nonzeros evenly over invocations, whatever the row lengths.
+// Auto picks merge path for CSR matrices whose longest row dwarfs the average.
+enum struct SpmvAlgorithm : uint8_t { Auto, RowSplit, MergePath };
+
+// y = alpha * A * x + beta * y; `x` holds cols floats and `y` rows floats. With beta == 0, y is not read.
+void spmv(const SparseMatrix& matrix, const Buffer& x, const Buffer& y, float alpha = 1.0f, float beta = 0.0f,
+          SpmvAlgorithm algorithm = SpmvAlgorithm::Auto);
+
+} // namespace Flow::ops
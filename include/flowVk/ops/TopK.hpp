@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+enum struct TopKOrder : uint8_t { Largest, Smallest };
+
+namespace detail {
+void top_k(const Buffer& input, ScalarType type, uint32_t k, const Buffer& values, const Buffer& indices, TopKOrder order);
+}
+
+// Writes the k largest (or smallest) elements of `input` (interpreted as T[]) to `values`,
+// best first, and their uint32_t positions to `indices`. Equal values keep index order.
+// Everything stays on the device; reading back the results moves only k elements.
+template<Scalar T>
+void top_k(const Buffer& input, uint32_t k, const Buffer& values, const Buffer& indices, TopKOrder order = TopKOrder::Largest)
+{
+	detail::top_k(input, scalar_type_v<T>, k, values, indices, order);
+}
+
+} // namespace Flow::ops
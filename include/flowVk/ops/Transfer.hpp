@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "../Buffer.hpp"
+#include "Scalar.hpp"
+
+namespace Flow::ops {
+
+inline constexpr std::size_t WholeBuffer = std::numeric_limits<std::size_t>::max();
+
+// Element encodings convert() understands. F16 is IEEE half, packed two per 32-bit word.
+enum struct ElementFormat : uint8_t { U32, I32, F32, F16, F64 };
+
+constexpr std::size_t element_format_size(ElementFormat format)
+{
+	switch (format)
+	{
+		case ElementFormat::F16: return 2;
+		case ElementFormat::F64: return 8;
+		default:                 return 4;
+	}
+}
+
+namespace detail {
+void fill(const Buffer& buffer, ScalarType type, uint64_t valueBits);
+void iota(const Buffer& buffer, ScalarType type, uint64_t startBits, uint64_t stepBits);
+}
+
+// Sets every element of `buffer` (interpreted as T[]) to `value` without a host upload.
+template<Scalar T>
+void fill(const Buffer& buffer, T value)
+{
+	detail::fill(buffer, scalar_type_v<T>, detail::scalar_bits(value));
+}
+
+// Writes start, start + step, start + 2 * step, ... into `buffer` (interpreted as T[]).
+template<Scalar T>
+void iota(const Buffer& buffer, T start = T(0), T step = T(1))
+{
+	detail::iota(buffer, scalar_type_v<T>, detail::scalar_bits(start), detail::scalar_bits(step));
+}
+
+// Copies `bytes` (default: all of `src` after `srcOffset`) between named buffers on the device.
+void copy(const Buffer& src, const Buffer& dst, std::size_t srcOffset = 0, std::size_t dstOffset = 0, std::size_t bytes = WholeBuffer);
+
+// Converts every element of `src` from `from` to `to` into `dst`, e.g. F64 -> F32 or F32 -> F16.
+// Conversions follow GLSL constructor rules; F64 on either side requires shaderFloat64.
+void convert(const Buffer& src, ElementFormat from, const Buffer& dst, ElementFormat to);
+
+} // namespace Flow::ops
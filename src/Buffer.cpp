@@ -1,6 +1,7 @@
 #include "../include/flowVk/Buffer.hpp"
 #include "../include/flowVk/Instance.hpp"
 #include "internal/InstanceImpl.hpp"
+#include "internal/Dispatch.hpp"
 
 #include <stdexcept>
 #include <cstring>
@@ -9,11 +10,16 @@
 
 namespace Flow {
 
-static VkBufferUsageFlags ssbo_usage()
+static VkBufferUsageFlags ssbo_usage(const InstanceImpl& impl)
 {
-	return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
         VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+	// Any named buffer may be bound to a device-address kernel.
+	if (impl.caps.bufferDeviceAddress)
+		usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+	return usage;
 }
 
 static InstanceImpl::BufferState& get_state(const Buffer& buffer)
@@ -47,6 +53,8 @@ void Buffer::setBytes(const void* data, std::size_t bytes)
 		throw std::runtime_error("FlowVk: setBytes on unallocated buffer");
 	if (bytes > state.sizeBytes)
 		throw std::runtime_error("FlowVk: setBytes exceeds buffer size");
+	if (owner->is_pending(name))
+		owner->flush();
 
 	void* mapped = nullptr;
 	vmaMapMemory(owner->allocator, state.allocation, &mapped);
@@ -61,6 +69,8 @@ void Buffer::getBytes(void* out, std::size_t bytes) const
 		throw std::runtime_error("FlowVk: getBytes on unallocated buffer");
 	if (bytes > state.sizeBytes)
 		throw std::runtime_error("FlowVk: getBytes exceeds buffer size");
+	if (owner->is_pending(name))
+		owner->flush();
 
 	void* mapped = nullptr;
 	vmaMapMemory(owner->allocator, state.allocation, &mapped);
@@ -77,15 +87,19 @@ static void alloc_or_resize(InstanceImpl* pimpl, InstanceImpl::BufferState& stat
 
 	if (state.buffer)
 	{
+		if (pimpl->is_pending(state.name))
+			pimpl->flush();
+		detail::forget_cached_sets(*pimpl, state.buffer);
 		vmaDestroyBuffer(pimpl->allocator, state.buffer, state.allocation);
 		state.buffer = VK_NULL_HANDLE;
 		state.allocation = VK_NULL_HANDLE;
+		state.address = 0;
 	}
 
 	VkBufferCreateInfo bufferCreateInfo{};
 	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferCreateInfo.size = bytes;
-	bufferCreateInfo.usage = ssbo_usage();
+	bufferCreateInfo.usage = ssbo_usage(*pimpl);
 	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 	VmaAllocationCreateInfo allocationCreateInfo{};
@@ -97,6 +111,17 @@ static void alloc_or_resize(InstanceImpl* pimpl, InstanceImpl::BufferState& stat
 	if (r != VK_SUCCESS)
 		throw std::runtime_error("FlowVk: vmaCreateBuffer failed");
 	state.sizeBytes = bytes;
+	++state.generation;
+
+	if (pimpl->caps.bufferDeviceAddress)
+	{
+		VkBufferDeviceAddressInfo addressInfo{};
+		addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+		addressInfo.buffer = state.buffer;
+		state.address = vkGetBufferDeviceAddress(pimpl->device, &addressInfo);
+	}
+	if (pimpl->bindless.set)
+		detail::write_bindless_slot(*pimpl, state);
 }
 
 static void ensure_buffer_state(InstanceImpl* pimpl, const std::string& name, BufferAccess access)
@@ -141,7 +166,7 @@ void Buffer::zeroFill()
 	if (!state.buffer)
 		throw std::runtime_error("FlowVk: zeroFill requires allocated buffer");
 
-	owner->submit_one_time([&](VkCommandBuffer cmd) {
+	auto record = [&](VkCommandBuffer cmd) {
 		vkCmdFillBuffer(cmd, state.buffer, 0, state.sizeBytes, 0);
 
 		VkBufferMemoryBarrier barrier{};
@@ -158,7 +183,15 @@ void Buffer::zeroFill()
 		  VK_PIPELINE_STAGE_TRANSFER_BIT,
 		  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
 		  0, 0, nullptr, 1, &barrier, 0, nullptr);
-	});
+	};
+
+	if (owner->deferSubmission)
+	{
+		owner->pendingBuffers.insert(name);
+		owner->defer(record);
+	}
+	else
+		owner->submit_one_time(record);
 }
 
 void Buffer::resizeBytes(std::size_t newSizeBytes, bool zeroInit)
@@ -171,4 +204,36 @@ void Buffer::resizeBytes(std::size_t newSizeBytes, bool zeroInit)
 		zeroFill();
 }
 
+void swapStorage(const Buffer& a, const Buffer& b)
+{
+	if (!a.owner || a.owner != b.owner)
+		throw std::runtime_error("FlowVk: swapStorage needs two buffers of the same instance");
+	auto& x = get_state(a);
+	auto& y = get_state(b);
+	if (&x == &y)
+		return;
+
+	// Pending deferred work recorded the VkBuffers themselves, so it needs no flush; the
+	// names trade their membership in pendingBuffers along with the storage.
+	InstanceImpl* pimpl = a.owner.get();
+	const bool aPending = pimpl->is_pending(a.name);
+	const bool bPending = pimpl->is_pending(b.name);
+	if (aPending != bPending)
+	{
+		pimpl->pendingBuffers.erase(aPending ? a.name : b.name);
+		pimpl->pendingBuffers.insert(aPending ? b.name : a.name);
+	}
+
+	// Only the storage moves; names and access stay. Cached descriptor sets are keyed
+	// by VkBuffer and stay valid, recordings bound by name re-resolve. Addresses and
+	// bindless slots describe the storage and move with it.
+	std::swap(x.buffer, y.buffer);
+	std::swap(x.allocation, y.allocation);
+	std::swap(x.sizeBytes, y.sizeBytes);
+	std::swap(x.address, y.address);
+	std::swap(x.bindlessSlot, y.bindlessSlot);
+	++x.generation;
+	++y.generation;
+}
+
 } // namespace Flow
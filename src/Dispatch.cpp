@@ -0,0 +1,520 @@
+#include "internal/Dispatch.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace Flow::detail {
+
+static void vkCheck(VkResult result, const char* msg)
+{
+	if (result != VK_SUCCESS)
+		throw std::runtime_error(std::string("FlowVk Vulkan error: ") + msg + " (VkResult=" + std::to_string((int)result) + ")");
+}
+
+static constexpr uint32_t kSetsPerPool = 64;
+static constexpr uint32_t kDescriptorsPerPool = 512;
+// Cached sets orphaned by reallocations before the cache is rebuilt from scratch.
+static constexpr uint32_t kMaxDroppedCachedSets = 256;
+
+// ----- User kernels -----
+
+const InstanceImpl::KernelState& find_kernel(const InstanceImpl& impl, const std::string& kernelName)
+{
+	auto kernelItterator = impl.kernels.find(kernelName);
+	if (kernelItterator == impl.kernels.end())
+		throw std::runtime_error("FlowVk: unknown kernel: " + kernelName);
+	return kernelItterator->second;
+}
+
+BindingMap make_binding_map(const InstanceImpl& impl, const std::string& kernelName,
+                            const std::vector<BindingOverride>& overrides, const char* op)
+{
+	const auto& module = *find_kernel(impl, kernelName).module;
+
+	BindingMap map;
+	map.reserve(overrides.size());
+	for (const auto& entry : overrides)
+	{
+		const bool declared = std::any_of(module.buffers.begin(), module.buffers.end(),
+			[&](const auto& buffer) { return buffer.name == entry.shaderName; });
+		if (!declared)
+			throw std::runtime_error(std::string("FlowVk: ") + op + ": kernel '" + kernelName + "' has no buffer '" + entry.shaderName + "'");
+		if (entry.buffer.owner.get() != &impl)
+			throw std::runtime_error(std::string("FlowVk: ") + op + ": buffer '" + entry.buffer.name + "' belongs to another instance");
+		for (const auto& [shaderName, bufferName] : map)
+			if (shaderName == entry.shaderName)
+				throw std::runtime_error(std::string("FlowVk: ") + op + ": buffer '" + entry.shaderName + "' is overridden twice");
+		map.emplace_back(entry.shaderName, entry.buffer.name);
+	}
+	return map;
+}
+
+std::string bound_name(const BindingMap& overrides, std::string_view shaderName)
+{
+	for (const auto& [name, bufferName] : overrides)
+		if (name == shaderName)
+			return bufferName;
+	return std::string(shaderName);
+}
+
+KernelBinding resolve_kernel(const InstanceImpl& impl, const std::string& kernelName, const BindingMap& overrides)
+{
+	KernelBinding binding;
+	binding.kernelName = kernelName;
+	binding.kernel = &find_kernel(impl, kernelName);
+
+	const auto& module = *binding.kernel->module;
+	binding.buffers.reserve(module.buffers.size());
+	binding.generations.reserve(module.buffers.size());
+
+	for (const auto& buffer : module.buffers)
+	{
+		const std::string name = bound_name(overrides, buffer.name);
+		auto bufferItterator = impl.buffers.find(name);
+		if (bufferItterator == impl.buffers.end())
+			throw std::runtime_error("FlowVk: missing required buffer '" + name + "' for kernel '" + kernelName + "'");
+
+		const auto& state = bufferItterator->second;
+		if (!state.buffer)
+			throw std::runtime_error("FlowVk: buffer '" + name + "' not allocated");
+
+		binding.buffers.push_back(&state);
+		binding.generations.push_back(state.generation);
+	}
+	return binding;
+}
+
+bool is_stale(const KernelBinding& binding)
+{
+	for (std::size_t i = 0; i < binding.buffers.size(); ++i)
+		if (binding.buffers[i]->generation != binding.generations[i])
+			return true;
+	return false;
+}
+
+// ----- Descriptor sets -----
+
+DescriptorArena::~DescriptorArena()
+{
+	reset();
+}
+
+void DescriptorArena::reset()
+{
+	for (auto pool : pools)
+		vkDestroyDescriptorPool(impl.device, pool, nullptr);
+	pools.clear();
+	setsLeft = 0;
+	descriptorsLeft = 0;
+}
+
+std::vector<VkDescriptorSet> DescriptorArena::allocate(const KernelBinding& binding)
+{
+	const auto& layouts = binding.kernel->setLayouts;
+	const uint32_t setCount = static_cast<uint32_t>(layouts.size());
+	const uint32_t descriptorCount = static_cast<uint32_t>(binding.buffers.size());
+
+	std::vector<VkDescriptorSet> sets;
+	if (setCount == 0 || binding.kernel->pushDescriptors)
+		return sets;
+	sets.resize(setCount, VK_NULL_HANDLE);
+
+	if (setsLeft < setCount || descriptorsLeft < descriptorCount)
+	{
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSize.descriptorCount = std::max(kDescriptorsPerPool, descriptorCount);
+
+		VkDescriptorPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCreateInfo.maxSets = std::max(kSetsPerPool, setCount);
+		poolCreateInfo.poolSizeCount = 1;
+		poolCreateInfo.pPoolSizes = &poolSize;
+
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		vkCheck(vkCreateDescriptorPool(impl.device, &poolCreateInfo, nullptr, &pool), "vkCreateDescriptorPool");
+		pools.push_back(pool);
+		setsLeft = poolCreateInfo.maxSets;
+		descriptorsLeft = poolSize.descriptorCount;
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = pools.back();
+	allocInfo.descriptorSetCount = setCount;
+	allocInfo.pSetLayouts = layouts.data();
+	vkCheck(vkAllocateDescriptorSets(impl.device, &allocInfo, sets.data()), "vkAllocateDescriptorSets");
+	setsLeft -= setCount;
+	descriptorsLeft -= descriptorCount;
+
+	write_sets(impl, binding, sets);
+	return sets;
+}
+
+// One write per metadata binding; `sets` is empty for push descriptors, which ignore dstSet.
+static void make_writes(const KernelBinding& binding, std::span<const VkDescriptorSet> sets,
+                        std::vector<VkDescriptorBufferInfo>& bufferInfos, std::vector<VkWriteDescriptorSet>& writes)
+{
+	const auto& module = *binding.kernel->module;
+
+	bufferInfos.assign(module.buffers.size(), VkDescriptorBufferInfo{});
+	writes.assign(module.buffers.size(), VkWriteDescriptorSet{});
+
+	for (std::size_t i = 0; i < module.buffers.size(); ++i)
+	{
+		bufferInfos[i].buffer = binding.buffers[i]->buffer;
+		bufferInfos[i].offset = 0;
+		bufferInfos[i].range = VK_WHOLE_SIZE;
+
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = sets.empty() ? VK_NULL_HANDLE : sets[module.buffers[i].set];
+		writes[i].dstBinding = module.buffers[i].binding;
+		writes[i].dstArrayElement = 0;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].descriptorCount = 1;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+}
+
+void write_sets(InstanceImpl& impl, const KernelBinding& binding, std::span<const VkDescriptorSet> sets)
+{
+	std::vector<VkDescriptorBufferInfo> bufferInfos;
+	std::vector<VkWriteDescriptorSet> writes;
+	make_writes(binding, sets, bufferInfos, writes);
+
+	if (!writes.empty())
+		vkUpdateDescriptorSets(impl.device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+const std::vector<VkDescriptorSet>& cached_sets(InstanceImpl& impl, const KernelBinding& binding)
+{
+	static const std::vector<VkDescriptorSet> kNoSets;
+	if (binding.kernel->pushDescriptors || binding.kernel->setLayouts.empty())
+		return kNoSets;
+
+	std::string key = binding.kernelName;
+	key.push_back('\0');
+	for (const auto* buffer : binding.buffers)
+		key.append(reinterpret_cast<const char*>(&buffer->buffer), sizeof(VkBuffer));
+
+	auto found = impl.setCache.find(key);
+	if (found != impl.setCache.end())
+		return found->second.sets;
+
+	if (impl.droppedCachedSets >= kMaxDroppedCachedSets)
+	{
+		// Pending work may still reference sets from the arena.
+		impl.flush();
+		impl.setCache.clear();
+		impl.setCacheArena.reset();
+		impl.droppedCachedSets = 0;
+	}
+	if (!impl.setCacheArena)
+		impl.setCacheArena = std::make_unique<DescriptorArena>(impl);
+
+	InstanceImpl::CachedSets entry;
+	entry.buffers.reserve(binding.buffers.size());
+	for (const auto* buffer : binding.buffers)
+		entry.buffers.push_back(buffer->buffer);
+	entry.sets = impl.setCacheArena->allocate(binding);
+
+	return impl.setCache.emplace(std::move(key), std::move(entry)).first->second.sets;
+}
+
+void forget_cached_sets(InstanceImpl& impl, VkBuffer buffer)
+{
+	for (auto entry = impl.setCache.begin(); entry != impl.setCache.end();)
+	{
+		if (std::find(entry->second.buffers.begin(), entry->second.buffers.end(), buffer) != entry->second.buffers.end())
+		{
+			entry = impl.setCache.erase(entry);
+			++impl.droppedCachedSets;
+		}
+		else
+			++entry;
+	}
+}
+
+// ----- Recording -----
+
+void ensure_bindless_table(InstanceImpl& impl)
+{
+	auto& table = impl.bindless;
+	if (table.set)
+		return;
+	if (!impl.caps.bindless || impl.bindlessCapacity == 0)
+		throw std::runtime_error("FlowVk: bindless kernels need runtime descriptor arrays with update-after-bind storage buffers");
+
+	table.capacity = impl.bindlessCapacity;
+
+	// Partially bound: unused slots stay empty. Update-after-bind: registering a buffer
+	// does not invalidate command buffers already recorded with the table bound.
+	const VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+	                                              VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+	                                              VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+	flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	flagsInfo.bindingCount = 1;
+	flagsInfo.pBindingFlags = &bindingFlags;
+
+	VkDescriptorSetLayoutBinding layoutBinding{};
+	layoutBinding.binding = 0;
+	layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	layoutBinding.descriptorCount = table.capacity;
+	layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &flagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &layoutBinding;
+	vkCheck(vkCreateDescriptorSetLayout(impl.device, &layoutInfo, nullptr, &table.layout), "vkCreateDescriptorSetLayout(bindless)");
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = table.capacity;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	vkCheck(vkCreateDescriptorPool(impl.device, &poolInfo, nullptr, &table.pool), "vkCreateDescriptorPool(bindless)");
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = table.pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &table.layout;
+	vkCheck(vkAllocateDescriptorSets(impl.device, &allocInfo, &table.set), "vkAllocateDescriptorSets(bindless)");
+
+	// Buffers allocated before the first bindless kernel.
+	for (auto& [name, state] : impl.buffers)
+		if (state.buffer)
+			write_bindless_slot(impl, state);
+}
+
+void write_bindless_slot(InstanceImpl& impl, InstanceImpl::BufferState& state)
+{
+	auto& table = impl.bindless;
+	if (state.bindlessSlot == UINT32_MAX)
+	{
+		if (table.nextSlot == table.capacity)
+			throw std::runtime_error("FlowVk: bindless table is full (" + std::to_string(table.capacity) +
+			                         " buffers); raise InstanceConfig::max_bindless_buffers");
+		state.bindlessSlot = table.nextSlot++;
+	}
+
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = state.buffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = VK_WHOLE_SIZE;
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = table.set;
+	write.dstBinding = 0;
+	write.dstArrayElement = state.bindlessSlot;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.descriptorCount = 1;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(impl.device, 1, &write, 0, nullptr);
+}
+
+void record_bind(const InstanceImpl& impl, VkCommandBuffer cmd, const KernelBinding& binding, std::span<const VkDescriptorSet> sets)
+{
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, binding.kernel->pipeline);
+
+	const auto& module = *binding.kernel->module;
+	if (module.buffer_model != shader_meta::BufferModel::Descriptors)
+	{
+		// DeviceAddress and Bindless kernels own no set layouts. Every address or table handle goes
+		// into the first module.push_bytes in one push, whose cost does not grow with descriptor
+		// writes; Bindless kernels also bind the instance's table. DeviceAddress kernels also get
+		// each buffer's element count, which stands in for data.length().
+		const bool bindless = (module.buffer_model == shader_meta::BufferModel::Bindless);
+		uint8_t values[InstanceImpl::KernelState::pushConstantBytes] = {};
+		for (std::size_t i = 0; i < module.buffers.size(); ++i)
+		{
+			const auto& buffer = module.buffers[i];
+			const auto& state = *binding.buffers[i];
+			if (bindless)
+			{
+				std::memcpy(values + buffer.push_offset, &state.bindlessSlot, sizeof(uint32_t));
+				continue;
+			}
+			std::memcpy(values + buffer.push_offset, &state.address, sizeof(VkDeviceAddress));
+			const uint32_t count = buffer.element_stride
+				? static_cast<uint32_t>(std::min<std::size_t>(state.sizeBytes / buffer.element_stride, UINT32_MAX))
+				: 0;
+			std::memcpy(values + buffer.count_offset, &count, sizeof(uint32_t));
+		}
+
+		if (module.push_bytes > 0)
+			vkCmdPushConstants(cmd, binding.kernel->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+			                   0, module.push_bytes, values);
+		if (bindless)
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, binding.kernel->pipelineLayout,
+			                        0, 1, &impl.bindless.set, 0, nullptr);
+	}
+	else if (binding.kernel->pushDescriptors)
+	{
+		std::vector<VkDescriptorBufferInfo> bufferInfos;
+		std::vector<VkWriteDescriptorSet> writes;
+		make_writes(binding, {}, bufferInfos, writes);
+
+		impl.cmdPushDescriptorSet(
+			cmd,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			binding.kernel->pipelineLayout,
+			0,
+			static_cast<uint32_t>(writes.size()),
+			writes.data()
+		);
+	}
+	else if (!sets.empty())
+	{
+		vkCmdBindDescriptorSets(
+			cmd,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			binding.kernel->pipelineLayout,
+			0,
+			static_cast<uint32_t>(sets.size()),
+			sets.data(),
+			0,
+			nullptr
+		);
+	}
+}
+
+void record_barrier(VkCommandBuffer cmd,
+                    VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+	VkMemoryBarrier memBarrier{};
+	memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memBarrier.srcAccessMask = srcAccess;
+	memBarrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(
+		cmd,
+		srcStage,
+		dstStage,
+		0,
+		1, &memBarrier,
+		0, nullptr,
+		0, nullptr
+	);
+}
+
+void record_host_to_compute(VkCommandBuffer cmd)
+{
+	record_barrier(cmd,
+		VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+void record_compute_to_compute(VkCommandBuffer cmd)
+{
+	record_barrier(cmd,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+void record_compute_to_host(VkCommandBuffer cmd)
+{
+	record_barrier(cmd,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+}
+
+// ----- Reusable submissions -----
+
+RecordedDispatches::~RecordedDispatches()
+{
+	if (fence)	vkDestroyFence(impl->device, fence, nullptr);
+	if (cmd)	vkFreeCommandBuffers(impl->device, impl->cmdPool, 1, &cmd);
+}
+
+bool RecordedDispatches::is_current() const
+{
+	if (!recorded)
+		return false;
+	for (const auto& step : steps)
+		if (is_stale(step.binding))
+			return false;
+	return true;
+}
+
+void RecordedDispatches::record()
+{
+	arena = std::make_unique<DescriptorArena>(*impl);
+	for (auto& step : steps)
+	{
+		step.binding = resolve_kernel(*impl, step.kernelName, step.overrides);
+		step.sets = arena->allocate(step.binding);
+	}
+
+	if (!cmd)
+	{
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = impl->cmdPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+		vkCheck(vkAllocateCommandBuffers(impl->device, &allocateInfo, &cmd), "vkAllocateCommandBuffers");
+	}
+
+	// The pool allows per-buffer reset, so beginning again discards the previous recording.
+	VkCommandBufferBeginInfo bufferBeginInfo{};
+	bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	vkCheck(vkBeginCommandBuffer(cmd, &bufferBeginInfo), "vkBeginCommandBuffer");
+
+	record_host_to_compute(cmd);
+	for (const auto& step : steps)
+	{
+		if (step.barrierBefore)
+			record_compute_to_compute(cmd);
+		record_bind(*impl, cmd, step.binding, step.sets);
+		vkCmdDispatch(cmd, step.groupCount[0], step.groupCount[1], step.groupCount[2]);
+	}
+	record_compute_to_host(cmd);
+
+	vkCheck(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
+	recorded = true;
+}
+
+void RecordedDispatches::submit()
+{
+	if (steps.empty())
+		return;
+	// Work deferred before this submission must run first.
+	impl->flush();
+	if (!is_current())
+	{
+		recorded = false;
+		record();
+	}
+
+	if (!fence)
+	{
+		VkFenceCreateInfo fenceCreateInfo{};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		vkCheck(vkCreateFence(impl->device, &fenceCreateInfo, nullptr, &fence), "vkCreateFence");
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmd;
+
+	vkCheck(vkQueueSubmit(impl->computeQueue, 1, &submitInfo, fence), "vkQueueSubmit");
+	vkCheck(vkWaitForFences(impl->device, 1, &fence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+	vkCheck(vkResetFences(impl->device, 1, &fence), "vkResetFences");
+}
+
+} // namespace Flow::detail
@@ -12,6 +12,8 @@
 #include <array>
 #include <span>
 #include <cctype>
+#include <cstdlib>
+#include <functional>
 
 #include "../include/flowVk/ShaderMeta.hpp"
 
@@ -30,13 +32,15 @@ struct Args {
   std::filesystem::path in_file;
   std::filesystem::path out_glsl;
   std::filesystem::path out_hpp;
+  std::string buffers = "descriptors"; // descriptors | device_address | bindless
 };
 
 static void print_usage() {
   std::cout
     << "FlowVk_ShaderPP\n"
     << "Usage:\n"
-    << "  FlowVk_ShaderPP --in <input.comp> --out-glsl <output.glsl> --out-hpp <output.hpp>\n";
+    << "  FlowVk_ShaderPP --in <input.comp> --out-glsl <output.glsl> --out-hpp <output.hpp>\n"
+    << "                  [--buffers descriptors|device_address|bindless]\n";
 }
 
 static Args parse_args(int argc, char* argv[])
@@ -77,6 +81,16 @@ static Args parse_args(int argc, char* argv[])
 			i += 2;
 			continue;
 		}
+		else if (arg == "--buffers")
+		{
+			if (i + 1 >= argc)
+				throw std::runtime_error("FlowVk_ShaderPP: --buffers missing a value");
+			arguments.buffers = argv[i + 1];
+			if (arguments.buffers != "descriptors" && arguments.buffers != "device_address" && arguments.buffers != "bindless")
+				throw std::runtime_error("FlowVk_ShaderPP: --buffers must be descriptors, device_address or bindless");
+			i += 2;
+			continue;
+		}
 		else
 		  throw std::runtime_error(std::string("FlowVk_ShaderPP: Unknown argument: ") + std::string(arg));
 	}
@@ -329,6 +343,13 @@ static std::string pascal_case(std::string_view s)
   	return out;
 }
 
+struct FieldInfo {
+	std::string name;
+	std::string type;
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
 struct BufferInfo {
 	std::string name;
 	std::string access;
@@ -336,8 +357,268 @@ struct BufferInfo {
 	std::string layout;
 	uint32_t set = 0;
 	uint32_t binding = 0;
+	uint32_t push_offset = 0;        // device_address / bindless: offset of the address or handle in the push block
+	uint32_t count_offset = 0;       // device_address: offset of the element count in the push block
+
+	uint32_t stride = 0;             // 0 when the element type could not be laid out
+	std::vector<FieldInfo> fields;   // top-level members when the element type is a struct
+};
+
+// ------------------------------------------------------------------
+// Element layouts: offsets of struct members under std430 / std140 / scalar rules,
+// so hosts and built-in ops can address fields of array-of-struct buffers.
+
+struct TypeLayout {
+	uint32_t size = 0;
+	uint32_t align = 1;
 };
 
+struct MemberDecl {
+	std::string type;
+	std::string name;
+	uint32_t arrayLength = 0; // 0: not an array
+};
+
+using StructTable = std::unordered_map<std::string, std::vector<MemberDecl>>;
+
+static uint32_t round_up(uint32_t value, uint32_t align)
+{
+	return (value + align - 1) / align * align;
+}
+
+// Same text with comments blanked out, so offsets into it stay valid.
+static std::string strip_comments(const std::string& text)
+{
+	std::string out = text;
+	for (std::size_t i = 0; i + 1 < out.size(); ++i)
+	{
+		if (out[i] == '/' && out[i + 1] == '/')
+		{
+			while (i < out.size() && out[i] != '\n')
+				out[i++] = ' ';
+		}
+		else if (out[i] == '/' && out[i + 1] == '*')
+		{
+			const std::size_t end = out.find("*/", i + 2);
+			const std::size_t stop = (end == std::string::npos) ? out.size() : end + 2;
+			for (; i < stop; ++i)
+				if (out[i] != '\n')
+					out[i] = ' ';
+			--i;
+		}
+	}
+	return out;
+}
+
+static std::vector<std::string> split_tokens(std::string_view text)
+{
+	std::vector<std::string> tokens;
+	std::size_t i = 0;
+	while (i < text.size())
+	{
+		if (std::isspace(static_cast<unsigned char>(text[i])))
+		{
+			++i;
+			continue;
+		}
+		const std::size_t start = i;
+		if (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')
+		{
+			while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_'))
+				++i;
+		}
+		else
+			++i;
+		tokens.emplace_back(text.substr(start, i - start));
+	}
+	return tokens;
+}
+
+// Collects `struct Name { type member[N]; ... };` definitions.
+static StructTable parse_structs(const std::string& text)
+{
+	StructTable table;
+	const std::vector<std::string> tokens = split_tokens(strip_comments(text));
+
+	for (std::size_t i = 0; i + 2 < tokens.size(); ++i)
+	{
+		if (tokens[i] != "struct" || tokens[i + 2] != "{")
+			continue;
+
+		const std::string& structName = tokens[i + 1];
+		std::vector<MemberDecl> members;
+		std::vector<std::string> declaration;
+		std::size_t j = i + 3;
+		bool valid = true;
+		for (; j < tokens.size() && tokens[j] != "}"; ++j)
+		{
+			if (tokens[j] != ";")
+			{
+				declaration.push_back(tokens[j]);
+				continue;
+			}
+
+			// [qualifiers] type name [N] {, name [N]}
+			std::size_t k = 0;
+			while (k < declaration.size() && (declaration[k] == "highp" || declaration[k] == "mediump" ||
+			                                  declaration[k] == "lowp" || declaration[k] == "precise"))
+				++k;
+			if (k >= declaration.size())
+			{
+				valid = false;
+				break;
+			}
+			const std::string type = declaration[k++];
+			while (k < declaration.size())
+			{
+				MemberDecl member{type, declaration[k++], 0};
+				if (k + 2 < declaration.size() && declaration[k] == "[")
+				{
+					member.arrayLength = static_cast<uint32_t>(std::strtoul(declaration[k + 1].c_str(), nullptr, 0));
+					if (member.arrayLength == 0 || declaration[k + 2] != "]")
+						valid = false;
+					k += 3;
+				}
+				members.push_back(member);
+				if (k < declaration.size() && declaration[k] == ",")
+					++k;
+				else if (k < declaration.size())
+				{
+					valid = false;
+					break;
+				}
+			}
+			declaration.clear();
+		}
+
+		if (valid && j < tokens.size())
+			table[structName] = std::move(members);
+		i = j;
+	}
+	return table;
+}
+
+// Component size of a scalar / vector / matrix type name and its vector width; nullopt otherwise.
+static std::optional<std::pair<uint32_t, uint32_t>> vector_shape(const std::string& type)
+{
+	static const std::array<std::pair<std::string_view, uint32_t>, 13> prefixes = {{
+		{"i64vec", 8}, {"u64vec", 8}, {"f16vec", 2}, {"i16vec", 2}, {"u16vec", 2}, {"i8vec", 1}, {"u8vec", 1},
+		{"dvec", 8}, {"ivec", 4}, {"uvec", 4}, {"bvec", 4}, {"vec", 4}, {"f64vec", 8},
+	}};
+	static const std::array<std::pair<std::string_view, uint32_t>, 12> scalars = {{
+		{"float", 4}, {"int", 4}, {"uint", 4}, {"bool", 4}, {"double", 8}, {"int64_t", 8}, {"uint64_t", 8},
+		{"float16_t", 2}, {"int16_t", 2}, {"uint16_t", 2}, {"int8_t", 1}, {"uint8_t", 1},
+	}};
+
+	for (const auto& [name, size] : scalars)
+		if (type == name)
+			return std::pair{size, 1u};
+	for (const auto& [prefix, size] : prefixes)
+		if (type.size() == prefix.size() + 1 && type.starts_with(prefix) && type.back() >= '2' && type.back() <= '4')
+			return std::pair{size, static_cast<uint32_t>(type.back() - '0')};
+	return std::nullopt;
+}
+
+static TypeLayout vector_layout(uint32_t componentSize, uint32_t width, const std::string& rules)
+{
+	if (rules == "scalar")
+		return {componentSize * width, componentSize};
+	return {componentSize * width, componentSize * (width == 3 ? 4 : width)};
+}
+
+static std::optional<TypeLayout> type_layout(const std::string& type, const std::string& rules,
+                                             const StructTable& structs, int depth = 0);
+
+static TypeLayout array_layout(TypeLayout element, uint32_t length, const std::string& rules)
+{
+	uint32_t align = element.align;
+	if (rules == "std140")
+		align = round_up(align, 16);
+	const uint32_t stride = (rules == "scalar") ? element.size : round_up(element.size, align);
+	return {stride * length, align};
+}
+
+static std::optional<TypeLayout> member_layout(const MemberDecl& member, const std::string& rules,
+                                               const StructTable& structs, int depth)
+{
+	auto layout = type_layout(member.type, rules, structs, depth);
+	if (!layout || member.arrayLength == 0)
+		return layout;
+	return array_layout(*layout, member.arrayLength, rules);
+}
+
+static std::optional<TypeLayout> type_layout(const std::string& type, const std::string& rules,
+                                             const StructTable& structs, int depth)
+{
+	if (depth > 16)
+		return std::nullopt;
+
+	if (auto shape = vector_shape(type))
+		return vector_layout(shape->first, shape->second, rules);
+
+	// matC / matCxR / dmat...: C columns of R-component vectors.
+	const bool isDouble = type.starts_with("dmat");
+	const std::string_view matrix = std::string_view(type).substr(isDouble ? 4 : 3);
+	if ((isDouble || type.starts_with("mat")) && !matrix.empty() && matrix[0] >= '2' && matrix[0] <= '4')
+	{
+		const uint32_t columns = static_cast<uint32_t>(matrix[0] - '0');
+		uint32_t rows = columns;
+		if (matrix.size() == 3 && matrix[1] == 'x' && matrix[2] >= '2' && matrix[2] <= '4')
+			rows = static_cast<uint32_t>(matrix[2] - '0');
+		else if (matrix.size() != 1)
+			return std::nullopt;
+		return array_layout(vector_layout(isDouble ? 8 : 4, rows, rules), columns, rules);
+	}
+
+	const auto it = structs.find(type);
+	if (it == structs.end())
+		return std::nullopt;
+
+	uint32_t offset = 0;
+	uint32_t align = 1;
+	for (const MemberDecl& member : it->second)
+	{
+		const auto layout = member_layout(member, rules, structs, depth + 1);
+		if (!layout)
+			return std::nullopt;
+		offset = round_up(offset, layout->align) + layout->size;
+		align = std::max(align, layout->align);
+	}
+	if (rules == "std140")
+		align = round_up(align, 16);
+	return TypeLayout{round_up(offset, align), align};
+}
+
+// Fills stride and fields of every buffer whose element type can be laid out.
+static void compute_element_layouts(const std::string& text, std::vector<BufferInfo>& buffers)
+{
+	const StructTable structs = parse_structs(text);
+
+	for (BufferInfo& buffer : buffers)
+	{
+		const auto element = type_layout(buffer.type, buffer.layout, structs);
+		if (!element)
+			continue;
+		buffer.stride = array_layout(*element, 1, buffer.layout).size;
+
+		const auto it = structs.find(buffer.type);
+		if (it == structs.end())
+			continue;
+
+		uint32_t offset = 0;
+		for (const MemberDecl& member : it->second)
+		{
+			const auto layout = member_layout(member, buffer.layout, structs, 1);
+			offset = round_up(offset, layout->align);
+			std::string type = member.type;
+			if (member.arrayLength != 0)
+				type += "[" + std::to_string(member.arrayLength) + "]";
+			buffer.fields.push_back(FieldInfo{member.name, type, offset, layout->size});
+			offset += layout->size;
+		}
+	}
+}
+
 static std::optional<std::string> access_to_glsl_qual(const std::string& s)
 {
 	if (s == "read_only" || s == "readonly" || s == "read-only") return "readonly ";
@@ -382,13 +663,216 @@ static std::string make_glsl_ssbo_decl(const BufferInfo& b)
 	return out;
 }
 
+// --buffers device_address: the block becomes a buffer_reference type and the buffer
+// itself a member of the generated push constant block (make_glsl_address_block).
+static std::string make_glsl_reference_decl(const BufferInfo& b)
+{
+	const std::string accessQual = access_to_glsl_qual(b.access).value_or("");
+	const std::string blockName = pascal_case(b.name) + "Buffer";
+
+	std::string out;
+	out += "layout(buffer_reference, " + b.layout + ") ";
+	out += accessQual;
+	out += "buffer " + blockName + " {\n";
+	out += "  " + b.type + " data[];\n";
+	out += "};\n";
+	return out;
+}
+
+// Anonymous block, so shaders keep writing `name.data[i]` as with descriptors. A reference
+// carries no array length, so each buffer's element count follows the addresses.
+static std::string make_glsl_address_block(const std::vector<BufferInfo>& buffers)
+{
+	std::string out;
+	out += "layout(push_constant) uniform FlowVkBufferAddresses {\n";
+	for (const auto& b : buffers)
+		out += "  layout(offset = " + std::to_string(b.push_offset) + ") " + pascal_case(b.name) + "Buffer " + b.name + ";\n";
+	for (const auto& b : buffers)
+		out += "  layout(offset = " + std::to_string(b.count_offset) + ") uint flowvk_count_" + b.name + ";\n";
+	out += "};\n";
+	return out;
+}
+
+// --buffers bindless: every buffer is an alias of the instance-wide table at set 0,
+// binding 0, indexed by a handle from the generated push constant block.
+static std::string make_glsl_table_decl(const BufferInfo& b)
+{
+	const std::string accessQual = access_to_glsl_qual(b.access).value_or("");
+	const std::string blockName = pascal_case(b.name) + "Buffer";
+
+	std::string out;
+	out += "layout(set = 0, binding = 0, " + b.layout + ") ";
+	out += accessQual;
+	out += "buffer " + blockName + " {\n";
+	out += "  " + b.type + " data[];\n";
+	out += "} flowvk_table_" + b.name + "[];\n";
+	return out;
+}
+
+static std::string make_glsl_handle_block(const std::vector<BufferInfo>& buffers)
+{
+	std::string out;
+	out += "layout(push_constant) uniform FlowVkBufferHandles {\n";
+	for (const auto& b : buffers)
+		out += "  layout(offset = " + std::to_string(b.push_offset) + ") uint flowvk_handle_" + b.name + ";\n";
+	out += "};\n";
+	return out;
+}
+
+// A `name.data` access found by rewrite_buffer_accesses: the buffer, and offsets in the
+// shader of the end of `name` and of the end of `data`.
+struct BufferAccess {
+	const BufferInfo& buffer;
+	std::size_t nameEnd;
+	std::size_t dataEnd;
+};
+
+// Replacement for the text from the start of `name` up to `end`.
+struct AccessRewrite {
+	std::string text;
+	std::size_t end;
+};
+
+using AccessRewriter = std::function<std::optional<AccessRewrite>(const BufferAccess& access, const std::string& code)>;
+
+// Offers every `name.data` after `from` to `rewrite`, which may replace it. Only a buffer name
+// directly followed by `.data` and not itself a member (`v.name`) is offered, so parameters or
+// locals that share the name and text in comments are left alone. `rewrite` sees the shader
+// with comments blanked at the same offsets.
+static void rewrite_buffer_accesses(std::string& glsl, std::size_t from, const std::vector<BufferInfo>& buffers,
+                                    const AccessRewriter& rewrite)
+{
+	std::unordered_map<std::string, const BufferInfo*> byName;
+	for (const auto& b : buffers)
+		byName.emplace(b.name, &b);
+
+	const auto is_word = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+	const std::string code = strip_comments(glsl);
+
+	std::string out = glsl.substr(0, from);
+	std::size_t i = from;
+	while (i < glsl.size())
+	{
+		const char c = code[i];
+		if (!(std::isalpha(static_cast<unsigned char>(c)) || c == '_') || (i > 0 && is_word(code[i - 1])))
+		{
+			out.push_back(glsl[i]);
+			++i;
+			continue;
+		}
+		std::size_t end = i;
+		while (end < code.size() && is_word(code[end]))
+			++end;
+		const std::string word = glsl.substr(i, end - i);
+
+		std::size_t before = i;
+		while (before > 0 && std::isspace(static_cast<unsigned char>(code[before - 1])))
+			--before;
+		const bool member = (before > 0 && code[before - 1] == '.');
+
+		std::size_t after = end;
+		while (after < code.size() && std::isspace(static_cast<unsigned char>(code[after])))
+			++after;
+		bool dataAccess = (after < code.size() && code[after] == '.');
+		if (dataAccess)
+		{
+			++after;
+			while (after < code.size() && std::isspace(static_cast<unsigned char>(code[after])))
+				++after;
+			dataAccess = code.compare(after, 4, "data") == 0 && (after + 4 == code.size() || !is_word(code[after + 4]));
+		}
+
+		auto found = byName.find(word);
+		std::optional<AccessRewrite> replaced;
+		if (found != byName.end() && !member && dataAccess)
+			replaced = rewrite(BufferAccess{*found->second, end, after + 4}, code);
+		if (replaced)
+		{
+			out += replaced->text;
+			i = replaced->end;
+		}
+		else
+		{
+			out += word;
+			i = end;
+		}
+	}
+	glsl = std::move(out);
+}
+
+// Bindless: `name.data` becomes `flowvk_table_name[flowvk_handle_name].data`, so shaders keep
+// the descriptor-mode syntax. The handles are dynamically uniform (push constants), so no
+// nonuniformEXT is needed.
+static void rewrite_table_accesses(std::string& glsl, std::size_t from, const std::vector<BufferInfo>& buffers)
+{
+	rewrite_buffer_accesses(glsl, from, buffers, [](const BufferAccess& access, const std::string&) {
+		const std::string& name = access.buffer.name;
+		return std::optional<AccessRewrite>(AccessRewrite{"flowvk_table_" + name + "[flowvk_handle_" + name + "]", access.nameEnd});
+	});
+}
+
+// Device addresses: OpArrayLength needs a descriptor-backed block, so `name.data.length()`
+// becomes the pushed element count. Returns the first buffer whose length is read but whose
+// element type has no known stride, for which FlowVk cannot compute the count.
+static std::optional<std::string> rewrite_address_lengths(std::string& glsl, std::size_t from, const std::vector<BufferInfo>& buffers)
+{
+	std::optional<std::string> unsized;
+	rewrite_buffer_accesses(glsl, from, buffers, [&](const BufferAccess& access, const std::string& code) -> std::optional<AccessRewrite> {
+		std::size_t i = access.dataEnd;
+		const auto skip_space = [&] {
+			while (i < code.size() && std::isspace(static_cast<unsigned char>(code[i])))
+				++i;
+		};
+		for (std::string_view token : {".", "length", "(", ")"})
+		{
+			skip_space();
+			if (code.compare(i, token.size(), token) != 0)
+				return std::nullopt;
+			i += token.size();
+		}
+		if (access.buffer.stride == 0 && !unsized)
+			unsized = access.buffer.name;
+		return AccessRewrite{"int(flowvk_count_" + access.buffer.name + ")", i};
+	});
+	return unsized;
+}
+
+// Extensions go right after #version, ahead of every declaration.
+static void insert_extension(std::string& glsl, std::string_view extension)
+{
+	const std::string line = "#extension " + std::string(extension) + " : require\n";
+	std::size_t position = glsl.find("#version");
+	if (position != std::string::npos)
+	{
+		position = glsl.find('\n', position);
+		position = (position == std::string::npos) ? glsl.size() : position + 1;
+	}
+	else
+		position = 0;
+	glsl.insert(position, line);
+}
+
 struct TransformResult {
 	std::string out_glsl;
 	std::vector<BufferInfo> buffers;
 };
 
-static TransformResult transform_shader(const std::string& text)
+// 128 push constant bytes are guaranteed on every device.
+static constexpr uint32_t maxPushConstantBytes = 128;
+
+// Push constant bytes per buffer: an 8-byte address and a 4-byte element count, or a 4-byte table handle.
+static uint32_t push_slot_bytes(const std::string& bufferModel)
 {
+	if (bufferModel == "device_address") return 12;
+	if (bufferModel == "bindless") return 4;
+	return 0;
+}
+
+static TransformResult transform_shader(const std::string& text, const std::string& bufferModel)
+{
+	const uint32_t slotBytes = push_slot_bytes(bufferModel);
+	std::size_t pushBlockPos = 0; // just past the last buffer declaration
+
 	std::unordered_map<std::string, std::size_t> name_to_index;
 	std::vector<BufferInfo> buffers;
 	uint32_t next_binding = 0;
@@ -446,19 +930,29 @@ static TransformResult transform_shader(const std::string& text)
           				out += "/* FlowVk_ShaderPP ERROR: layout must be std430/std140/scalar */\n";
           			} else {
             			auto it = name_to_index.find(name);
-            			if (it == name_to_index.end()) {
+            			if (it == name_to_index.end() && (next_binding + 1) * slotBytes > maxPushConstantBytes) {
+            				out += "/* FlowVk_ShaderPP ERROR: " + bufferModel + " kernels take at most " + std::to_string(maxPushConstantBytes / slotBytes) + " buffers */\n";
+            			} else if (it == name_to_index.end()) {
             				BufferInfo bi;
             				bi.name = name;
             				bi.access = access;
             				bi.type = type;
             				bi.layout = layout;
             				bi.set = 0;
-            				bi.binding = next_binding++;
+            				bi.binding = (bufferModel == "bindless") ? 0 : next_binding;
+            				bi.push_offset = next_binding * ((bufferModel == "device_address") ? 8 : slotBytes);
+            				++next_binding;
 
             				name_to_index.emplace(name, buffers.size());
             				buffers.push_back(bi);
 
-            				out += make_glsl_ssbo_decl(bi);
+            				if (bufferModel == "device_address")
+            					out += make_glsl_reference_decl(bi);
+            				else if (bufferModel == "bindless")
+            					out += make_glsl_table_decl(bi);
+            				else
+            					out += make_glsl_ssbo_decl(bi);
+            				pushBlockPos = out.size();
             			} else {
               				BufferInfo& existing = buffers[it->second];
               				const bool same = (existing.access == access && existing.type == type && existing.layout == layout);
@@ -482,11 +976,35 @@ static TransformResult transform_shader(const std::string& text)
 
 	out.append(text.substr(cursor));
 
+	compute_element_layouts(text, buffers);
+
+	if (bufferModel == "device_address" && !buffers.empty())
+	{
+		// Addresses first (8-byte aligned), then one count per buffer.
+		for (std::size_t i = 0; i < buffers.size(); ++i)
+			buffers[i].count_offset = static_cast<uint32_t>(8 * buffers.size() + 4 * i);
+
+		const std::string addresses = make_glsl_address_block(buffers);
+		out.insert(pushBlockPos, addresses);
+		if (auto unsized = rewrite_address_lengths(out, pushBlockPos + addresses.size(), buffers))
+			throw std::runtime_error("FlowVk_ShaderPP: " + *unsized + ".data.length() needs an element type FlowVk_ShaderPP can lay out "
+			                         "(BUFFERS device_address pushes the element count in its place)");
+		insert_extension(out, "GL_EXT_buffer_reference");
+	}
+	else if (bufferModel == "bindless" && !buffers.empty())
+	{
+		const std::string handles = make_glsl_handle_block(buffers);
+		out.insert(pushBlockPos, handles);
+		rewrite_table_accesses(out, pushBlockPos + handles.size(), buffers);
+		insert_extension(out, "GL_EXT_nonuniform_qualifier");
+	}
+
 	return TransformResult{std::move(out), std::move(buffers)};
 }
 
-static std::string emit_hpp(const std::filesystem::path& in_file, const std::vector<BufferInfo>& buffers)
+static std::string emit_hpp(const std::filesystem::path& in_file, const std::vector<BufferInfo>& buffers, const std::string& bufferModel)
 {
+	const bool pushed = (push_slot_bytes(bufferModel) != 0);
 	const std::string stem = sanitize_cpp_ident(in_file.stem().string());
 	const std::string kernel_name = in_file.stem().string();
 
@@ -500,6 +1018,23 @@ static std::string emit_hpp(const std::filesystem::path& in_file, const std::vec
 
 	header += "namespace Flow::shader_meta::" + stem + " {\n\n";
 
+	for (const auto& b : buffers)
+	{
+		if (b.fields.empty())
+			continue;
+		header += "inline constexpr std::array<Flow::shader_meta::ElementField, " + std::to_string(b.fields.size()) + "> k" + pascal_case(b.name) + "Fields = {{\n";
+		for (const auto& f : b.fields)
+		{
+			header += "  Flow::shader_meta::ElementField{";
+			header += "\"" + escape_cpp_string(f.name) + "\", ";
+			header += "\"" + escape_cpp_string(f.type) + "\", ";
+			header += std::to_string(f.offset) + "u, ";
+			header += std::to_string(f.size) + "u";
+			header += "},\n";
+		}
+		header += "}};\n\n";
+	}
+
 	header += "inline constexpr std::array<Flow::shader_meta::BufferBinding, " + std::to_string(buffers.size()) + "> kBufferArray = {{\n";
 	for (const auto& b : buffers)
 	{
@@ -509,7 +1044,16 @@ static std::string emit_hpp(const std::filesystem::path& in_file, const std::vec
 		header += access_to_cpp_enum(b.access) + ", ";
 		header += layout_to_cpp_enum(b.layout) + ", ";
 		header += std::to_string(b.set) + "u, ";
-		header += std::to_string(b.binding) + "u";
+		header += std::to_string(b.binding) + "u, ";
+		header += std::to_string(b.stride) + "u";
+		if (!b.fields.empty())
+			header += ", std::span<const Flow::shader_meta::ElementField>(k" + pascal_case(b.name) + "Fields)";
+		else if (pushed)
+			header += ", {}";
+		if (pushed)
+			header += ", " + std::to_string(b.push_offset) + "u";
+		if (bufferModel == "device_address")
+			header += ", " + std::to_string(b.count_offset) + "u";
 		header += "},\n";
 	}
 	header += "}};\n\n";
@@ -517,6 +1061,12 @@ static std::string emit_hpp(const std::filesystem::path& in_file, const std::vec
 	header += "inline constexpr Flow::shader_meta::Module module = {\n";
 	header += "  .kernel_name = \"" + escape_cpp_string(kernel_name) + "\",\n";
 	header += "  .buffers = std::span<const Flow::shader_meta::BufferBinding>(kBufferArray),\n";
+	if (pushed)
+	{
+		header += "  .buffer_model = Flow::shader_meta::BufferModel::";
+		header += (bufferModel == "bindless") ? "Bindless,\n" : "DeviceAddress,\n";
+		header += "  .push_bytes = " + std::to_string(static_cast<uint32_t>(buffers.size()) * push_slot_bytes(bufferModel)) + "u,\n";
+	}
 	header += "};\n\n";
 
 	header += "} // namespace Flow::shader_meta::" + stem + "\n";
@@ -545,14 +1095,23 @@ int main(int argc, char* argv[])
 		return 2;
 	}
 
-	const TransformResult transformResult = transform_shader(input);
+	TransformResult transformResult;
+	try
+	{
+		transformResult = transform_shader(input, args.buffers);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << args.in_file.string() << ": " << e.what() << '\n';
+		return 5;
+	}
 
 	if (!write_string_to_file(args.out_glsl, transformResult.out_glsl)) {
 		std::cerr << "Failed to write GLSL output: " << args.out_glsl << "\n";
 		return 3;
 	}
 
-	const std::string out_hpp = emit_hpp(args.in_file, transformResult.buffers);
+	const std::string out_hpp = emit_hpp(args.in_file, transformResult.buffers, args.buffers);
 	if (!write_string_to_file(args.out_hpp, out_hpp))
 	{
 		std::cerr << "Failed to write HPP output: " << args.out_hpp << "\n";
@@ -0,0 +1,146 @@
+#include "../include/flowVk/Graph.hpp"
+#include "internal/InstanceImpl.hpp"
+#include "internal/Dispatch.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+
+namespace Flow {
+
+struct GraphNode {
+	std::string kernelName;
+	detail::BindingMap overrides;
+	uint32_t groupCount[3] = {1, 1, 1};
+	uint32_t level = 0;
+};
+
+// Last level that wrote / read each buffer name, for placing new nodes.
+struct BufferUse {
+	int64_t lastWrite = -1;
+	int64_t lastRead = -1;
+};
+
+struct GraphImpl {
+	std::vector<GraphNode> nodes;
+	std::vector<std::vector<uint32_t>> levels;
+	std::unordered_map<std::string, BufferUse> uses;
+
+	// The levels flattened in order, rebuilt after nodes are added.
+	detail::RecordedDispatches program;
+	bool scheduled = false;
+
+	explicit GraphImpl(std::shared_ptr<InstanceImpl> instance) : program(std::move(instance)) {}
+
+	void schedule()
+	{
+		program.steps.clear();
+		for (std::size_t level = 0; level < levels.size(); ++level)
+		{
+			for (std::size_t i = 0; i < levels[level].size(); ++i)
+			{
+				const auto& node = nodes[levels[level][i]];
+				detail::RecordedDispatches::Step step;
+				step.kernelName = node.kernelName;
+				step.overrides = node.overrides;
+				std::copy(std::begin(node.groupCount), std::end(node.groupCount), step.groupCount);
+				step.barrierBefore = (level > 0 && i == 0);
+				program.steps.push_back(std::move(step));
+			}
+		}
+		program.invalidate();
+		scheduled = true;
+	}
+};
+
+static GraphImpl& get_impl(const Graph& graph, const char* op)
+{
+	if (!graph.impl)
+		throw std::runtime_error(std::string("FlowVk: Graph::") + op + " called on empty Graph");
+	return *graph.impl;
+}
+
+Graph::Graph(const Instance& instance)
+{
+	if (!instance.pimpl)
+		throw std::runtime_error("FlowVk: Graph created from empty Instance");
+	impl = std::make_shared<GraphImpl>(instance.pimpl);
+}
+
+uint32_t Graph::addKernel(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	return addKernel(kernelName, {}, groupCountX, groupCountY, groupCountZ);
+}
+
+uint32_t Graph::addKernel(const std::string& kernelName, const std::vector<BindingOverride>& bindings, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	auto& graph = get_impl(*this, "addKernel");
+	const auto& kernel = detail::find_kernel(*graph.program.impl, kernelName);
+	auto overrides = detail::make_binding_map(*graph.program.impl, kernelName, bindings, "Graph::addKernel");
+
+	// One past the latest conflicting use: RAW and WAW wait for writers, WAR for readers.
+	int64_t level = 0;
+	for (const auto& buffer : kernel.module->buffers)
+	{
+		const auto found = graph.uses.find(detail::bound_name(overrides, buffer.name));
+		if (found == graph.uses.end())
+			continue;
+		const bool writes = buffer.access != shader_meta::Access::ReadOnly;
+		level = std::max(level, found->second.lastWrite + 1);
+		if (writes)
+			level = std::max(level, found->second.lastRead + 1);
+	}
+
+	for (const auto& buffer : kernel.module->buffers)
+	{
+		auto& use = graph.uses[detail::bound_name(overrides, buffer.name)];
+		if (buffer.access != shader_meta::Access::WriteOnly)
+			use.lastRead = std::max(use.lastRead, level);
+		if (buffer.access != shader_meta::Access::ReadOnly)
+			use.lastWrite = std::max(use.lastWrite, level);
+	}
+
+	GraphNode node;
+	node.kernelName = kernelName;
+	node.overrides = std::move(overrides);
+	node.groupCount[0] = groupCountX;
+	node.groupCount[1] = groupCountY;
+	node.groupCount[2] = groupCountZ;
+	node.level = static_cast<uint32_t>(level);
+
+	const uint32_t index = static_cast<uint32_t>(graph.nodes.size());
+	graph.nodes.push_back(std::move(node));
+	if (graph.levels.size() <= static_cast<std::size_t>(level))
+		graph.levels.resize(level + 1);
+	graph.levels[level].push_back(index);
+	graph.scheduled = false;
+	return index;
+}
+
+uint32_t Graph::nodeCount() const
+{
+	return static_cast<uint32_t>(get_impl(*this, "nodeCount").nodes.size());
+}
+
+uint32_t Graph::levelCount() const
+{
+	return static_cast<uint32_t>(get_impl(*this, "levelCount").levels.size());
+}
+
+uint32_t Graph::levelOf(uint32_t node) const
+{
+	const auto& graph = get_impl(*this, "levelOf");
+	if (node >= graph.nodes.size())
+		throw std::runtime_error("FlowVk: Graph::levelOf: no node " + std::to_string(node));
+	return graph.nodes[node].level;
+}
+
+void Graph::run()
+{
+	auto& graph = get_impl(*this, "run");
+	if (!graph.scheduled)
+		graph.schedule();
+	graph.program.submit();
+}
+
+} // namespace Flow
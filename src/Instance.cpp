@@ -1,11 +1,13 @@
 #include "../include/flowVk/Instance.hpp"
 #include "internal/InstanceImpl.hpp" 
+#include "internal/Dispatch.hpp"
 
 #include <stdexcept>
 #include <iostream>
 #include <cstring>
 #include <fstream>
 #include <set>
+#include <algorithm>
 
 #include <vulkan/vulkan.h>
 
@@ -14,6 +16,16 @@
 
 #ifdef FLOWVK_WITH_KERNEL_REGISTRY
   #include "KernelBuffers.hpp"
+#else
+// Without user kernels (e.g. the benchmarks, which only use Flow::ops) addKernel has nothing to look up.
+namespace Flow::shader_meta::registry {
+inline const Module& get_module(std::string_view)
+{
+	throw std::runtime_error(
+		"FlowVk: Kernel registry not available. "
+		"Did you call flowvk_add_kernels(...) for your target?");
+}
+}
 #endif
 
 namespace Flow {
@@ -51,7 +63,8 @@ static VkBufferUsageFlags ssbo_usage()
 {
 	return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
         VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 }
 
 static void create_vma_buffer(InstanceImpl* pimpl, VkDeviceSize size, VkBuffer* outBuf, VmaAllocation* outAlloc)
@@ -135,6 +148,92 @@ static bool device_name_contains(VkPhysicalDevice phisicalDevice, const std::str
 	return std::string(properties.deviceName).find(needle) != std::string::npos;
 }
 
+static bool device_has_extension(VkPhysicalDevice physicalDevice, const char* name)
+{
+	uint32_t count = 0;
+	vkCheck(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, nullptr), "vkEnumerateDeviceExtensionProperties(count)");
+	std::vector<VkExtensionProperties> extensions(count);
+	vkCheck(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, extensions.data()), "vkEnumerateDeviceExtensionProperties(list)");
+
+	for (const auto& extension : extensions)
+		if (std::strcmp(extension.extensionName, name) == 0)
+			return true;
+	return false;
+}
+
+static bool lists_extension(const std::vector<const char*>& extensions, const char* name)
+{
+	return std::any_of(extensions.begin(), extensions.end(), [&](const char* e) { return std::strcmp(e, name) == 0; });
+}
+
+static InstanceImpl::DeviceCaps query_device_caps(VkPhysicalDevice physicalDevice)
+{
+	const bool pushDescriptors = device_has_extension(physicalDevice, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+	// The Vulkan 1.1 / 1.2 structures may only be chained for devices that support that version;
+	// on older devices the features they report stay off.
+	VkPhysicalDeviceProperties baseProperties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &baseProperties);
+	const uint32_t deviceVersion = VK_MAKE_VERSION(VK_VERSION_MAJOR(baseProperties.apiVersion), VK_VERSION_MINOR(baseProperties.apiVersion), 0);
+	const uint32_t apiVersion = std::min(deviceVersion, static_cast<uint32_t>(VK_API_VERSION_1_3));
+	const bool vulkan11 = apiVersion >= VK_API_VERSION_1_1;
+	const bool vulkan12 = apiVersion >= VK_API_VERSION_1_2;
+
+	VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptor{};
+	pushDescriptor.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+
+	VkPhysicalDeviceVulkan12Properties properties12{};
+	properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+	properties12.pNext = pushDescriptors ? &pushDescriptor : nullptr;
+
+	VkPhysicalDeviceSubgroupProperties subgroup{};
+	subgroup.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+	subgroup.pNext = vulkan12 ? static_cast<void*>(&properties12) : (pushDescriptors ? &pushDescriptor : nullptr);
+
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = vulkan11 ? static_cast<void*>(&subgroup) : (pushDescriptors ? &pushDescriptor : nullptr);
+	vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+	VkPhysicalDeviceVulkan12Features features12{};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features2{};
+	features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features2.pNext = vulkan12 ? &features12 : nullptr;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+	const VkPhysicalDeviceFeatures& features = features2.features;
+
+	const auto& limits = properties.properties.limits;
+	const bool computeSubgroups = (subgroup.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) != 0;
+
+	InstanceImpl::DeviceCaps caps{};
+	caps.vendorID = properties.properties.vendorID;
+	caps.apiVersion = apiVersion;
+	caps.subgroupSize = subgroup.subgroupSize ? subgroup.subgroupSize : 1u;
+	caps.subgroupArithmetic = computeSubgroups && (subgroup.supportedOperations & VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+	caps.subgroupBallot = computeSubgroups && (subgroup.supportedOperations & VK_SUBGROUP_FEATURE_BALLOT_BIT);
+	caps.shaderInt64 = features.shaderInt64 == VK_TRUE;
+	caps.shaderFloat64 = features.shaderFloat64 == VK_TRUE;
+	caps.shaderBufferInt64Atomics = features12.shaderBufferInt64Atomics == VK_TRUE;
+	caps.pushDescriptors = pushDescriptors;
+	caps.maxPushDescriptors = pushDescriptors ? pushDescriptor.maxPushDescriptors : 0;
+	caps.bufferDeviceAddress = features12.bufferDeviceAddress == VK_TRUE;
+	caps.bindless = features12.runtimeDescriptorArray == VK_TRUE &&
+	                features12.descriptorBindingPartiallyBound == VK_TRUE &&
+	                features12.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE &&
+	                features12.descriptorBindingUpdateUnusedWhilePending == VK_TRUE;
+	caps.maxBindlessBuffers = caps.bindless ? std::min(properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+	                                                   properties12.maxDescriptorSetUpdateAfterBindStorageBuffers) : 0;
+	caps.maxWorkGroupInvocations = std::min(limits.maxComputeWorkGroupInvocations, limits.maxComputeWorkGroupSize[0]);
+	caps.maxSharedMemoryBytes = limits.maxComputeSharedMemorySize;
+	caps.maxGroupCountX = limits.maxComputeWorkGroupCount[0];
+	caps.maxGroupCountY = limits.maxComputeWorkGroupCount[1];
+	caps.maxGroupCountZ = limits.maxComputeWorkGroupCount[2];
+	caps.maxPushConstantBytes = limits.maxPushConstantsSize;
+	return caps;
+}
+
 static VkPhysicalDevice pick_physical_device(VkInstance instance, const InstanceConfig& config, uint32_t& outComputeQF)
 {
 	uint32_t count = 0;
@@ -172,6 +271,10 @@ static VkPhysicalDevice pick_physical_device(VkInstance instance, const Instance
 
 InstanceImpl::~InstanceImpl()
 {
+	// Work still pending is dropped along with the buffers it would have written.
+	setCache.clear();
+	setCacheArena.reset();
+
 	for (auto& [name, kernel] : kernels)
 	{
 		for (auto layout : kernel.setLayouts)
@@ -183,6 +286,25 @@ InstanceImpl::~InstanceImpl()
 		if (kernel.shaderModule)	vkDestroyShaderModule(device, kernel.shaderModule, nullptr);
 	}
 	kernels.clear();
+
+	for (auto& [name, kernel] : builtinKernels)
+	{
+		if (kernel.pipeline)		vkDestroyPipeline(device, kernel.pipeline, nullptr);
+		if (kernel.pipelineLayout)	vkDestroyPipelineLayout(device, kernel.pipelineLayout, nullptr);
+		if (kernel.setLayout)		vkDestroyDescriptorSetLayout(device, kernel.setLayout, nullptr);
+		if (kernel.shaderModule)	vkDestroyShaderModule(device, kernel.shaderModule, nullptr);
+	}
+	builtinKernels.clear();
+
+	if (bindless.pool)		vkDestroyDescriptorPool(device, bindless.pool, nullptr);
+	if (bindless.layout)	vkDestroyDescriptorSetLayout(device, bindless.layout, nullptr);
+
+	for (auto& scratch : freeScratch)
+	{
+		if (scratch.buffer)
+			vmaDestroyBuffer(allocator, scratch.buffer, scratch.allocation);
+	}
+	freeScratch.clear();
 	
 	for (auto& [n, b] : buffers)
 	{
@@ -197,41 +319,91 @@ InstanceImpl::~InstanceImpl()
 	if (instance)	vkDestroyInstance(instance, nullptr);
 }
 
-void InstanceImpl::submit_one_time(std::function<void(VkCommandBuffer)> record)
+static void submit_and_wait(InstanceImpl& impl, VkCommandBuffer cmd)
+{
+	VkSubmitInfo subbmitInfo{};
+	subbmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	subbmitInfo.commandBufferCount = 1;
+	subbmitInfo.pCommandBuffers = &cmd;
+
+	VkFenceCreateInfo fenceCreateInfo{};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	VkFence fence = VK_NULL_HANDLE;
+	vkCheck(vkCreateFence(impl.device, &fenceCreateInfo, nullptr, &fence), "vkCreateFence");
+
+	VkResult result = vkQueueSubmit(impl.computeQueue, 1, &subbmitInfo, fence);
+	if (result == VK_SUCCESS)
+		result = vkWaitForFences(impl.device, 1, &fence, VK_TRUE, UINT64_MAX);
+
+	vkDestroyFence(impl.device, fence, nullptr);
+	vkFreeCommandBuffers(impl.device, impl.cmdPool, 1, &cmd);
+	vkCheck(result, "vkQueueSubmit/vkWaitForFences");
+}
+
+static VkCommandBuffer begin_one_time(InstanceImpl& impl)
 {
 	VkCommandBufferAllocateInfo allocateInfo{};
 	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocateInfo.commandPool = cmdPool;
+	allocateInfo.commandPool = impl.cmdPool;
 	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 	allocateInfo.commandBufferCount = 1;
 
 	VkCommandBuffer cmd = VK_NULL_HANDLE;
-	vkCheck(vkAllocateCommandBuffers(device, &allocateInfo, &cmd), "vkAllocateCommandBuffers");
+	vkCheck(vkAllocateCommandBuffers(impl.device, &allocateInfo, &cmd), "vkAllocateCommandBuffers");
 
 	VkCommandBufferBeginInfo bufferBeginInfo{};
 	bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	bufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 	vkCheck(vkBeginCommandBuffer(cmd, &bufferBeginInfo), "vkBeginCommandBuffer");
+	return cmd;
+}
 
-	record(cmd);
+void InstanceImpl::submit_one_time(std::function<void(VkCommandBuffer)> record)
+{
+	flush();
 
+	VkCommandBuffer cmd = begin_one_time(*this);
+	record(cmd);
 	vkCheck(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
 
-	VkSubmitInfo subbmitInfo{};
-	subbmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	subbmitInfo.commandBufferCount = 1;
-	subbmitInfo.pCommandBuffers = &cmd;
+	submit_and_wait(*this, cmd);
+}
 
-	VkFenceCreateInfo fenceCreateInfo{};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	VkFence fence = VK_NULL_HANDLE;
-	vkCheck(vkCreateFence(device, &fenceCreateInfo, nullptr, &fence), "vkCreateFence");
+// Transfer (zeroFill) and compute writes of earlier pending work, for any later access.
+static constexpr VkPipelineStageFlags kPendingStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+static constexpr VkAccessFlags kPendingWrites = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 
-	vkCheck(vkQueueSubmit(computeQueue, 1, &subbmitInfo, fence), "vkQueueSubmit");
-	vkCheck(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+void InstanceImpl::defer(const std::function<void(VkCommandBuffer)>& record)
+{
+	if (!pendingCmd)
+	{
+		pendingCmd = begin_one_time(*this);
+		detail::record_host_to_compute(pendingCmd);
+	}
+	else
+	{
+		detail::record_barrier(pendingCmd,
+			kPendingStages, kPendingWrites,
+			kPendingStages | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+			VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	}
+	record(pendingCmd);
+}
 
-	vkDestroyFence(device, fence, nullptr);
-	vkFreeCommandBuffers(device, cmdPool, 1, &cmd);
+void InstanceImpl::flush()
+{
+	if (!pendingCmd)
+		return;
+
+	VkCommandBuffer cmd = pendingCmd;
+	pendingCmd = VK_NULL_HANDLE;
+	pendingBuffers.clear();
+
+	detail::record_barrier(cmd, kPendingStages, kPendingWrites, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+	vkCheck(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
+
+	submit_and_wait(*this, cmd);
 }
 
 // ----- Public Api -----
@@ -264,6 +436,7 @@ Instance makeInstance(const InstanceConfig& config)
 
 	// ----- Physical device selection -----
 	pimpl->physical = pick_physical_device(pimpl->instance, config, pimpl->computeQueueFamily);
+	pimpl->caps = query_device_caps(pimpl->physical);
 
 	// ----- Logical device -----
 	float queuePriority = 1.0f;
@@ -277,10 +450,30 @@ Instance makeInstance(const InstanceConfig& config)
 	if (deviceExtensions.empty())
 		deviceExtensions = default_device_extensions();
 
+	// Optional extensions FlowVk uses whenever the device has them.
+	pimpl->caps.pushDescriptors = pimpl->caps.pushDescriptors && config.use_push_descriptors;
+	if (pimpl->caps.pushDescriptors && !lists_extension(deviceExtensions, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+		deviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
   	VkPhysicalDeviceFeatures features{};
+	features.shaderInt64 = pimpl->caps.shaderInt64 ? VK_TRUE : VK_FALSE;
+	features.shaderFloat64 = pimpl->caps.shaderFloat64 ? VK_TRUE : VK_FALSE;
+
+	VkPhysicalDeviceVulkan12Features features12{};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	features12.shaderBufferInt64Atomics = pimpl->caps.shaderBufferInt64Atomics ? VK_TRUE : VK_FALSE;
+	features12.bufferDeviceAddress = pimpl->caps.bufferDeviceAddress ? VK_TRUE : VK_FALSE;
+	if (pimpl->caps.bindless)
+	{
+		features12.runtimeDescriptorArray = VK_TRUE;
+		features12.descriptorBindingPartiallyBound = VK_TRUE;
+		features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	}
 
 	VkDeviceCreateInfo deviceCreateInfo{};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceCreateInfo.pNext = (pimpl->caps.apiVersion >= VK_API_VERSION_1_2) ? &features12 : nullptr;
 	deviceCreateInfo.queueCreateInfoCount = 1;
 	deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
 	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
@@ -291,6 +484,13 @@ Instance makeInstance(const InstanceConfig& config)
 
 	vkGetDeviceQueue(pimpl->device, pimpl->computeQueueFamily, 0, &pimpl->computeQueue);
 
+	if (pimpl->caps.pushDescriptors)
+	{
+		pimpl->cmdPushDescriptorSet = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(
+			vkGetDeviceProcAddr(pimpl->device, "vkCmdPushDescriptorSetKHR"));
+		pimpl->caps.pushDescriptors = (pimpl->cmdPushDescriptorSet != nullptr);
+	}
+
 
 	// ------ CMD Pool -----
 	VkCommandPoolCreateInfo poolInfo{};
@@ -302,13 +502,18 @@ Instance makeInstance(const InstanceConfig& config)
 
 	// ----- VMA allocator -----
 	VmaAllocatorCreateInfo allocatorCreateInfo{};
-	allocatorCreateInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+	allocatorCreateInfo.vulkanApiVersion = pimpl->caps.apiVersion;
 	allocatorCreateInfo.physicalDevice = pimpl->physical;
 	allocatorCreateInfo.device = pimpl->device;
 	allocatorCreateInfo.instance = pimpl->instance;
+	if (pimpl->caps.bufferDeviceAddress)
+		allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 
 	vkCheck(vmaCreateAllocator(&allocatorCreateInfo, &pimpl->allocator), "vmaCreateAllocator");
 
+	pimpl->deferSubmission = config.deferred_submission;
+	pimpl->bindlessCapacity = std::min(config.max_bindless_buffers, pimpl->caps.maxBindlessBuffers);
+
 	Instance out;
 	out.pimpl = std::move(pimpl);
 	return out;
@@ -322,25 +527,30 @@ void Instance::addKernel(const std::string& kernelName, const std::filesystem::p
 	if (pimpl->kernels.find(kernelName) != pimpl->kernels.end())
 		throw std::runtime_error("FlowVk: kernel already exists: " + kernelName);
 
-#ifndef FLOWVK_WITH_KERNEL_REGISTRY
-  throw std::runtime_error(
-    "FlowVk: Kernel registry not available. "
-    "Did you call flowvk_add_kernels(...) for your target?"
-  );
-#endif
-
 	const auto& mod = Flow::shader_meta::registry::get_module(kernelName);
 
+	// Device-address and bindless kernels take their buffers through push constants and own no set layouts.
+	const bool deviceAddress = (mod.buffer_model == shader_meta::BufferModel::DeviceAddress);
+	const bool bindless = (mod.buffer_model == shader_meta::BufferModel::Bindless);
+	if (deviceAddress && !pimpl->caps.bufferDeviceAddress)
+		throw std::runtime_error("FlowVk: addKernel: " + kernelName + " uses buffer device addresses, which the device does not support");
+	if (bindless)
+		detail::ensure_bindless_table(*pimpl);
+	if (mod.push_bytes > InstanceImpl::KernelState::pushConstantBytes)
+		throw std::runtime_error("FlowVk: addKernel: push constants of " + kernelName + " exceed " +
+		                         std::to_string(InstanceImpl::KernelState::pushConstantBytes) + " bytes");
+	const std::span<const shader_meta::BufferBinding> setBuffers = (deviceAddress || bindless) ? std::span<const shader_meta::BufferBinding>{} : mod.buffers;
+
 	uint32_t maxSet = 0;
-	for (const auto& buffer : mod.buffers)
+	for (const auto& buffer : setBuffers)
     	maxSet = std::max(maxSet, buffer.set);
-  	const uint32_t setCount = mod.buffers.empty() ? 0u : (maxSet + 1u);
+  	const uint32_t setCount = setBuffers.empty() ? 0u : (maxSet + 1u);
 
 	std::vector<std::vector<VkDescriptorSetLayoutBinding>> perSet(setCount);
 
 	std::vector<std::set<uint32_t>> usedBindings(setCount);
 
-	for (const auto& buffer : mod.buffers)
+	for (const auto& buffer : setBuffers)
 	{
 		if (buffer.set >= setCount)
     		throw std::runtime_error("FlowVk: invalid set index in metadata for kernel: " + kernelName);
@@ -363,6 +573,10 @@ void Instance::addKernel(const std::string& kernelName, const std::filesystem::p
 		std::sort(vector.begin(), vector.end(), [](auto& a, auto& c) { return a.binding < c.binding; });
 
 	InstanceImpl::KernelState kernel{};
+	kernel.module = &mod;
+	// Only one set of a pipeline layout may be pushed; FlowVk_ShaderPP puts every buffer in set 0.
+	kernel.pushDescriptors = pimpl->caps.pushDescriptors && setCount == 1 &&
+	                         mod.buffers.size() <= pimpl->caps.maxPushDescriptors;
 
 	kernel.setLayouts.resize(setCount, VK_NULL_HANDLE);
 
@@ -370,18 +584,33 @@ void Instance::addKernel(const std::string& kernelName, const std::filesystem::p
 	{
 		VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo{};
 		setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		setLayoutCreateInfo.flags = kernel.pushDescriptors ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
 		setLayoutCreateInfo.bindingCount = static_cast<uint32_t>(perSet[set].size());
 		setLayoutCreateInfo.pBindings = perSet[set].empty() ? nullptr : perSet[set].data();
 
 		vkCheck(vkCreateDescriptorSetLayout(pimpl->device, &setLayoutCreateInfo, nullptr, &kernel.setLayouts[set]), "vkCreateDescriptorSetLayout");
 	}
 
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = InstanceImpl::KernelState::pushConstantBytes;
+
 	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
 	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(kernel.setLayouts.size());
-	pipelineLayoutCreateInfo.pSetLayouts = kernel.setLayouts.empty() ? nullptr : kernel.setLayouts.data();
-	pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+	if (bindless)
+	{
+		// The table's layout belongs to the instance, not to the kernel.
+		pipelineLayoutCreateInfo.setLayoutCount = 1;
+		pipelineLayoutCreateInfo.pSetLayouts = &pimpl->bindless.layout;
+	}
+	else
+	{
+		pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(kernel.setLayouts.size());
+		pipelineLayoutCreateInfo.pSetLayouts = kernel.setLayouts.empty() ? nullptr : kernel.setLayouts.data();
+	}
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
 	vkCheck(vkCreatePipelineLayout(pimpl->device, &pipelineLayoutCreateInfo, nullptr, &kernel.pipelineLayout), "vkCreatePipelineLayout");
 
@@ -413,183 +642,107 @@ void Instance::addKernel(const std::string& kernelName, const std::filesystem::p
 	pimpl->kernels.emplace(kernelName, kernel);
 }
 
-void Instance::runSingleKernel(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+// Binds `kernelName` with its buffers from the registry and submits `dispatch` between host barriers,
+// or appends it to the pending work in deferred mode.
+static void run_kernel(InstanceImpl* pimpl, const std::string& kernelName, const detail::BindingMap& overrides,
+                       const std::function<void(VkCommandBuffer)>& dispatch)
 {
-	if (!pimpl)
-		throw std::runtime_error("FlowVk: runSingleKernel called on empty Instance");
-
-	auto kernelItterator = pimpl->kernels.find(kernelName);
-	if (kernelItterator == pimpl->kernels.end())
-		throw std::runtime_error("FlowVk: unknown kernel: " + kernelName);
-
-#ifndef FLOWVK_WITH_KERNEL_REGISTRY
-	throw std::runtime_error(
-		"FlowVk: Kernel registry not available. "
-		"Did you call flowvk_add_kernels(...) for your target?"
-	);
-#endif
-
-	const auto& module = Flow::shader_meta::registry::get_module(kernelName);
-
-	uint32_t maxSet = 0;
-	for (const auto& b : module.buffers)
-		maxSet = std::max(maxSet, b.set);
-	const uint32_t setCount = module.buffers.empty() ? 0u : (maxSet + 1u);
-
-	auto& kernelState = kernelItterator->second;
-	if (kernelState.setLayouts.size() != setCount)
-		throw std::runtime_error("FlowVk: kernel setLayout count mismatch (did metadata change?): " + kernelName);
-
-	uint32_t totalStorageBindings = static_cast<uint32_t>(module.buffers.size());
-
-	VkDescriptorPoolSize poolSize{};
-	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	poolSize.descriptorCount = totalStorageBindings;
-
-	VkDescriptorPoolCreateInfo poolCreateInfo{};
-	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolCreateInfo.maxSets = setCount;
-	poolCreateInfo.poolSizeCount = (totalStorageBindings > 0) ? 1u : 0u;
-	poolCreateInfo.pPoolSizes = (totalStorageBindings > 0) ? &poolSize : nullptr;
+	const auto binding = detail::resolve_kernel(*pimpl, kernelName, overrides);
+	const auto& sets = detail::cached_sets(*pimpl, binding);
 
-	VkDescriptorPool descPool = VK_NULL_HANDLE;
-	vkCheck(vkCreateDescriptorPool(pimpl->device, &poolCreateInfo, nullptr, &descPool), "vkCreateDescriptorPool");
-
-	std::vector<VkDescriptorSet> sets(setCount, VK_NULL_HANDLE);
-	if (setCount > 0)
+	if (pimpl->deferSubmission)
 	{
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = descPool;
-		allocInfo.descriptorSetCount = setCount;
-		allocInfo.pSetLayouts = kernelState.setLayouts.data();	
-		vkCheck(vkAllocateDescriptorSets(pimpl->device, &allocInfo, sets.data()), "vkAllocateDescriptorSets");
+		for (const auto* buffer : binding.buffers)
+			pimpl->pendingBuffers.insert(buffer->name);
+
+		pimpl->defer([&](VkCommandBuffer cmd) {
+			detail::record_bind(*pimpl, cmd, binding, sets);
+			dispatch(cmd);
+		});
+		return;
 	}
 
-	std::vector<VkDescriptorBufferInfo> bufferInfos;
-	bufferInfos.reserve(module.buffers.size());
-
-	std::vector<VkWriteDescriptorSet> writes;
-	writes.reserve(module.buffers.size());
+	pimpl->submit_one_time([&](VkCommandBuffer cmd) {
+		detail::record_host_to_compute(cmd);
+		detail::record_bind(*pimpl, cmd, binding, sets);
+		dispatch(cmd);
+		detail::record_compute_to_host(cmd);
+	});
+}
 
-	for (const auto& buffer : module.buffers)
-	{
-		auto bufferItterator = pimpl->buffers.find(std::string(buffer.name));
-		if (bufferItterator == pimpl->buffers.end())
-		{
-			vkDestroyDescriptorPool(pimpl->device, descPool, nullptr);
-			throw std::runtime_error("FlowVk: missing required buffer '" + std::string(buffer.name) + "' for kernel '" + kernelName + "'");
-		}
+void Instance::runSingleKernel(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	if (!pimpl)
+		throw std::runtime_error("FlowVk: runSingleKernel called on empty Instance");
 
-    	auto& state = bufferItterator->second;
-    	if (!state.buffer)
-		{
-    	  vkDestroyDescriptorPool(pimpl->device, descPool, nullptr);
-    	  throw std::runtime_error("FlowVk: buffer '" + std::string(buffer.name) + "' not allocated");
-    	}
+	run_kernel(pimpl.get(), kernelName, {}, [&](VkCommandBuffer cmd) {
+		vkCmdDispatch(cmd, groupCountX, groupCountY, groupCountZ);
+	});
+}
 
+void Instance::runSingleKernel(const std::string& kernelName, const std::vector<BindingOverride>& bindings, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	if (!pimpl)
+		throw std::runtime_error("FlowVk: runSingleKernel called on empty Instance");
 
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = state.buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range  = VK_WHOLE_SIZE;
-		bufferInfos.push_back(bufferInfo);
-
-		VkWriteDescriptorSet setW{};
-		setW.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		setW.dstSet = sets[buffer.set];
-		setW.dstBinding = buffer.binding;
-		setW.dstArrayElement = 0;
-		setW.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-		setW.descriptorCount = 1;
-		setW.pBufferInfo = &bufferInfos.back();
-		writes.push_back(setW);
-	}
+	const auto overrides = detail::make_binding_map(*pimpl, kernelName, bindings, "runSingleKernel");
+	run_kernel(pimpl.get(), kernelName, overrides, [&](VkCommandBuffer cmd) {
+		vkCmdDispatch(cmd, groupCountX, groupCountY, groupCountZ);
+	});
+}
 
-	if (!writes.empty())
-		vkUpdateDescriptorSets(pimpl->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+void Instance::runSingleKernelIndirect(const std::string& kernelName, const Buffer& args, std::size_t offsetBytes)
+{
+	if (!pimpl)
+		throw std::runtime_error("FlowVk: runSingleKernelIndirect called on empty Instance");
+	if (args.owner != pimpl)
+		throw std::runtime_error("FlowVk: runSingleKernelIndirect: buffer '" + args.name + "' belongs to another instance");
+
+	auto argsItterator = pimpl->buffers.find(args.name);
+	if (argsItterator == pimpl->buffers.end() || !argsItterator->second.buffer)
+		throw std::runtime_error("FlowVk: runSingleKernelIndirect: buffer '" + args.name + "' not allocated");
+	if (offsetBytes % 4 != 0 || offsetBytes + sizeof(VkDispatchIndirectCommand) > argsItterator->second.sizeBytes)
+		throw std::runtime_error("FlowVk: runSingleKernelIndirect: no aligned VkDispatchIndirectCommand at offset " + std::to_string(offsetBytes) + " of '" + args.name + "'");
+
+	const VkBuffer argsBuffer = argsItterator->second.buffer;
+	if (pimpl->deferSubmission)
+		pimpl->pendingBuffers.insert(args.name);
+	run_kernel(pimpl.get(), kernelName, {}, [&](VkCommandBuffer cmd) {
+		// The arguments usually come from earlier GPU work (e.g. Flow::ops::compact).
+		VkMemoryBarrier memBarrier{};
+		memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT;
+		memBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
 
-	pimpl->submit_one_time([&](VkCommandBuffer cmd) {
-    	if (!module.buffers.empty())
-		{
-      		std::vector<VkBufferMemoryBarrier> preBarriers;
-      		preBarriers.reserve(module.buffers.size());
-
-      		for (const auto& buffer : module.buffers)
-			{
-        		auto& state = pimpl->buffers.at(std::string(buffer.name));
-        		VkBufferMemoryBarrier memBarrier{};
-        		memBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-        		memBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-        		memBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-        		memBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        		memBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        		memBarrier.buffer = state.buffer;
-        		memBarrier.offset = 0;
-        		memBarrier.size = VK_WHOLE_SIZE;
-        		preBarriers.push_back(memBarrier);
-      		}
-
-    		vkCmdPipelineBarrier(
-				cmd,
-				VK_PIPELINE_STAGE_HOST_BIT,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				0,
-				0, nullptr,
-				static_cast<uint32_t>(preBarriers.size()), preBarriers.data(),
-				0, nullptr
-    		);
-    	}
+		vkCmdPipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			0,
+			1, &memBarrier,
+			0, nullptr,
+			0, nullptr
+		);
 
-		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, kernelState.pipeline);
+		vkCmdDispatchIndirect(cmd, argsBuffer, offsetBytes);
+	});
+}
 
-		if (setCount > 0)
-		{
-			vkCmdBindDescriptorSets(
-				cmd,
-				VK_PIPELINE_BIND_POINT_COMPUTE,
-				kernelState.pipelineLayout,
-				0,
-				setCount,
-				sets.data(),
-				0,
-				nullptr
-			);
-		}
+void Instance::flush()
+{
+	if (!pimpl)
+		throw std::runtime_error("FlowVk: flush called on empty Instance");
+	pimpl->flush();
+}
 
-		vkCmdDispatch(cmd, groupCountX, groupCountY, groupCountZ);
+void Instance::trimScratch()
+{
+	if (!pimpl)
+		throw std::runtime_error("FlowVk: trimScratch called on empty Instance");
 
-    	if (!module.buffers.empty())
-		{
-    		std::vector<VkBufferMemoryBarrier> postBarriers;
-    		postBarriers.reserve(module.buffers.size());
-
-    		for (const auto& buffer : module.buffers) {
-    			auto& state = pimpl->buffers.at(std::string(buffer.name));
-    			VkBufferMemoryBarrier memBarrier{};
-    			memBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-    			memBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    			memBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
-    			memBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    			memBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    			memBarrier.buffer = state.buffer;
-    			memBarrier.offset = 0;
-    			memBarrier.size = VK_WHOLE_SIZE;
-    			postBarriers.push_back(memBarrier);
-    		}
-
-			vkCmdPipelineBarrier(
-				cmd,
-				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-				VK_PIPELINE_STAGE_HOST_BIT,
-				0,
-				0, nullptr,
-				static_cast<uint32_t>(postBarriers.size()), postBarriers.data(),
-				0, nullptr
-			);
-    	}
-	});
-	vkDestroyDescriptorPool(pimpl->device, descPool, nullptr);
+	for (auto& scratch : pimpl->freeScratch)
+		vmaDestroyBuffer(pimpl->allocator, scratch.buffer, scratch.allocation);
+	pimpl->freeScratch.clear();
 }
 
 BufferBuilder Instance::makeReadOnly(const std::string& name)
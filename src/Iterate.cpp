@@ -0,0 +1,364 @@
+#include "../include/flowVk/Instance.hpp"
+#include "internal/InstanceImpl.hpp"
+#include "internal/Dispatch.hpp"
+#include "internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstring>
+
+namespace Flow {
+
+static void vkCheck(VkResult result, const char* msg)
+{
+	if (result != VK_SUCCESS)
+		throw std::runtime_error(std::string("FlowVk Vulkan error: ") + msg + " (VkResult=" + std::to_string((int)result) + ")");
+}
+
+// ----- Plan -----
+
+// One kernel dispatched repeatedly, with the bindings of even and odd iterations.
+struct IterationPlan {
+	const InstanceImpl* impl = nullptr;
+	detail::KernelBinding even;
+	detail::KernelBinding odd;
+	const std::vector<VkDescriptorSet>* evenSets = nullptr;
+	const std::vector<VkDescriptorSet>* oddSets = nullptr;
+	bool alternate = false;
+
+	uint32_t groupCount[3] = {1, 1, 1};
+	bool pushIndex = false;
+	uint32_t indexOffset = 0;
+	uint32_t firstIndex = 0;
+	uint32_t iterationsPerSubmit = 1;
+};
+
+static IterationPlan make_plan(InstanceImpl& impl, const std::string& kernelName,
+                               uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+                               const IterationOptions& options, const char* op)
+{
+	if (options.pushIndex && (options.indexOffset % 4 != 0 ||
+	                          options.indexOffset + sizeof(uint32_t) > InstanceImpl::KernelState::pushConstantBytes))
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": index offset " + std::to_string(options.indexOffset) +
+		                         " is not an aligned uint inside the push constant block");
+
+	// The generated address / handle block is the only push constant block such a shader can declare.
+	if (options.pushIndex && detail::find_kernel(impl, kernelName).module->buffer_model != shader_meta::BufferModel::Descriptors)
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": " + kernelName +
+		                         " takes its buffers through push constants (BUFFERS device_address or bindless) and cannot read a pushed index");
+
+	IterationPlan plan;
+	plan.impl = &impl;
+	const auto evenMap = detail::make_binding_map(impl, kernelName, options.bindings, op);
+	plan.even = detail::resolve_kernel(impl, kernelName, evenMap);
+	plan.evenSets = &detail::cached_sets(impl, plan.even);
+
+	plan.alternate = !options.oddBindings.empty();
+	if (plan.alternate)
+	{
+		auto oddMap = evenMap;
+		for (const auto& [shaderName, bufferName] : detail::make_binding_map(impl, kernelName, options.oddBindings, op))
+		{
+			auto entry = std::find_if(oddMap.begin(), oddMap.end(), [&](const auto& e) { return e.first == shaderName; });
+			if (entry != oddMap.end())
+				entry->second = bufferName;
+			else
+				oddMap.emplace_back(shaderName, bufferName);
+		}
+		plan.odd = detail::resolve_kernel(impl, kernelName, oddMap);
+		// Looked up after `even`: a cache rebuild in between would drop the earlier sets.
+		plan.oddSets = &detail::cached_sets(impl, plan.odd);
+		plan.evenSets = &detail::cached_sets(impl, plan.even);
+	}
+
+	plan.groupCount[0] = groupCountX;
+	plan.groupCount[1] = groupCountY;
+	plan.groupCount[2] = groupCountZ;
+	plan.pushIndex = options.pushIndex;
+	plan.indexOffset = options.indexOffset;
+	plan.firstIndex = options.firstIndex;
+	plan.iterationsPerSubmit = std::max(1u, options.iterationsPerSubmit);
+	return plan;
+}
+
+// Records iterations [first, first + count); `first` is relative to the start of the run.
+static void record_iterations(VkCommandBuffer cmd, const IterationPlan& plan, uint64_t first, uint64_t count)
+{
+	for (uint64_t i = first; i < first + count; ++i)
+	{
+		if (i != first)
+			detail::record_compute_to_compute(cmd);
+
+		const bool odd = plan.alternate && (i & 1) != 0;
+		if (i == first || plan.alternate)
+			detail::record_bind(*plan.impl, cmd, odd ? plan.odd : plan.even, odd ? *plan.oddSets : *plan.evenSets);
+
+		if (plan.pushIndex)
+		{
+			const uint32_t index = plan.firstIndex + static_cast<uint32_t>(i);
+			vkCmdPushConstants(cmd, plan.even.kernel->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+			                   plan.indexOffset, sizeof(uint32_t), &index);
+		}
+		vkCmdDispatch(cmd, plan.groupCount[0], plan.groupCount[1], plan.groupCount[2]);
+	}
+}
+
+// ----- Submission -----
+
+// Two command buffers in flight: one executes while the next chunk is recorded.
+struct SubmissionRing {
+	struct Slot {
+		VkCommandBuffer cmd = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		bool busy = false;
+	};
+
+	InstanceImpl& impl;
+	Slot slots[2];
+	uint32_t next = 0;
+
+	explicit SubmissionRing(InstanceImpl& instance) : impl(instance)
+	{
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = impl.cmdPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		VkFenceCreateInfo fenceCreateInfo{};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (auto& slot : slots)
+		{
+			vkCheck(vkAllocateCommandBuffers(impl.device, &allocateInfo, &slot.cmd), "vkAllocateCommandBuffers");
+			vkCheck(vkCreateFence(impl.device, &fenceCreateInfo, nullptr, &slot.fence), "vkCreateFence");
+		}
+	}
+
+	SubmissionRing(const SubmissionRing&) = delete;
+	SubmissionRing& operator=(const SubmissionRing&) = delete;
+
+	~SubmissionRing()
+	{
+		for (auto& slot : slots)
+		{
+			if (slot.busy)
+				vkWaitForFences(impl.device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+			if (slot.fence)	vkDestroyFence(impl.device, slot.fence, nullptr);
+			if (slot.cmd)	vkFreeCommandBuffers(impl.device, impl.cmdPool, 1, &slot.cmd);
+		}
+	}
+
+	// Waits for the oldest slot if it is still executing, then records and submits into it.
+	template<class Record>
+	void submit(Record&& record)
+	{
+		Slot& slot = slots[next];
+		next ^= 1;
+		wait(slot);
+
+		VkCommandBufferBeginInfo bufferBeginInfo{};
+		bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		bufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkCheck(vkBeginCommandBuffer(slot.cmd, &bufferBeginInfo), "vkBeginCommandBuffer");
+		record(slot.cmd);
+		vkCheck(vkEndCommandBuffer(slot.cmd), "vkEndCommandBuffer");
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &slot.cmd;
+		vkCheck(vkQueueSubmit(impl.computeQueue, 1, &submitInfo, slot.fence), "vkQueueSubmit");
+		slot.busy = true;
+	}
+
+	void wait(Slot& slot)
+	{
+		if (!slot.busy)
+			return;
+		slot.busy = false;
+		vkCheck(vkWaitForFences(impl.device, 1, &slot.fence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+		vkCheck(vkResetFences(impl.device, 1, &slot.fence), "vkResetFences");
+	}
+
+	void wait_all()
+	{
+		for (auto& slot : slots)
+			wait(slot);
+	}
+};
+
+// Compute and transfer writes become visible to both, around fills and copies between dispatches.
+static void record_compute_transfer_barrier(VkCommandBuffer cmd)
+{
+	detail::record_barrier(cmd,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+}
+
+// Extra commands around the last iteration of a run.
+struct RunHooks {
+	std::function<void(VkCommandBuffer)> beforeLast;
+	std::function<void(VkCommandBuffer)> afterLast;
+};
+
+// Submits iterations [first, first + count) in chunks and waits. Barriers at the start of
+// each chunk also order it after the previous submission.
+static void run_plan(InstanceImpl& impl, const IterationPlan& plan, uint64_t first, uint64_t count,
+                     const RunHooks& hooks = {})
+{
+	// Deferred work queued before this call runs first.
+	impl.flush();
+
+	SubmissionRing ring(impl);
+	const uint64_t end = first + count;
+	for (uint64_t chunk = first; chunk < end; chunk += plan.iterationsPerSubmit)
+	{
+		const uint64_t chunkCount = std::min<uint64_t>(plan.iterationsPerSubmit, end - chunk);
+		const bool last = (chunk + chunkCount >= end);
+
+		ring.submit([&](VkCommandBuffer cmd) {
+			if (chunk == first)
+				detail::record_host_to_compute(cmd);
+			else
+				detail::record_compute_to_compute(cmd);
+
+			if (!last || !hooks.beforeLast)
+				record_iterations(cmd, plan, chunk, chunkCount);
+			else
+			{
+				record_iterations(cmd, plan, chunk, chunkCount - 1);
+				record_compute_transfer_barrier(cmd);
+				hooks.beforeLast(cmd);
+				record_compute_transfer_barrier(cmd);
+				record_iterations(cmd, plan, end - 1, 1);
+			}
+
+			if (last)
+			{
+				if (hooks.afterLast)
+				{
+					record_compute_transfer_barrier(cmd);
+					hooks.afterLast(cmd);
+					detail::record_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+					                       VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+				}
+				detail::record_compute_to_host(cmd);
+			}
+		});
+	}
+	ring.wait_all();
+}
+
+// ----- Public Api -----
+
+void Instance::runIterations(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+                             uint32_t iterations, const IterationOptions& options)
+{
+	if (!pimpl)
+		throw std::runtime_error("FlowVk: runIterations called on empty Instance");
+	if (iterations == 0)
+		return;
+
+	const auto plan = make_plan(*pimpl, kernelName, groupCountX, groupCountY, groupCountZ, options, "runIterations");
+	run_plan(*pimpl, plan, 0, iterations);
+}
+
+static bool is_converged(const ConvergenceOptions& options, uint32_t flag, float residual)
+{
+	switch (options.stop)
+	{
+		case ConvergenceOptions::Stop::WhenZero:			return flag == 0;
+		case ConvergenceOptions::Stop::WhenNonZero:			return flag != 0;
+		case ConvergenceOptions::Stop::WhenBelowTolerance:	return residual <= options.tolerance;
+	}
+	return false;
+}
+
+// Iterations until the next check. Without a usable trend the interval grows with the
+// iterations done so far, keeping checks logarithmic and overshoot near a quarter of the
+// run. A residual that shrinks geometrically predicts the remaining iterations directly.
+static uint64_t next_interval(const ConvergenceOptions& options, uint64_t done, uint64_t lastBatch,
+                              float previousResidual, float residual)
+{
+	const uint64_t lower = std::max<uint64_t>(1, options.minInterval);
+	const uint64_t upper = std::max<uint64_t>(lower, options.maxInterval);
+	uint64_t next = std::max(lower, done / 4);
+
+	if (options.stop == ConvergenceOptions::Stop::WhenBelowTolerance &&
+	    options.tolerance > 0.0f && residual > options.tolerance &&
+	    previousResidual > residual && std::isfinite(previousResidual))
+	{
+		const double ratePerIteration = std::pow(double(residual) / double(previousResidual), 1.0 / double(lastBatch));
+		if (ratePerIteration > 0.0 && ratePerIteration < 1.0)
+		{
+			const double remaining = std::log(double(options.tolerance) / double(residual)) / std::log(ratePerIteration);
+			next = static_cast<uint64_t>(std::min(std::ceil(remaining), double(upper)));
+		}
+	}
+	return std::clamp(next, lower, upper);
+}
+
+ConvergenceResult Instance::runUntil(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+                                     const ConvergenceOptions& options)
+{
+	if (!pimpl)
+		throw std::runtime_error("FlowVk: runUntil called on empty Instance");
+	if (options.value.owner != pimpl)
+		throw std::runtime_error("FlowVk: runUntil: the value buffer must belong to this instance");
+
+	const auto& valueState = ops::detail::buffer_state(options.value, "runUntil");
+	if (options.offsetBytes % 4 != 0 || options.offsetBytes + sizeof(uint32_t) > valueState.sizeBytes)
+		throw std::runtime_error("FlowVk: runUntil: no aligned 4-byte value at offset " + std::to_string(options.offsetBytes) +
+		                         " of '" + options.value.name + "'");
+
+	const auto plan = make_plan(*pimpl, kernelName, groupCountX, groupCountY, groupCountZ, options.iteration, "runUntil");
+	ops::detail::Scratch readback(*pimpl, sizeof(uint32_t), ops::detail::ScratchKind::Readback);
+
+	const VkBuffer value = valueState.buffer;
+	const VkDeviceSize offset = options.offsetBytes;
+
+	RunHooks hooks;
+	if (options.resetBeforeCheck)
+		hooks.beforeLast = [&](VkCommandBuffer cmd) { vkCmdFillBuffer(cmd, value, offset, sizeof(uint32_t), 0); };
+	hooks.afterLast = [&](VkCommandBuffer cmd) {
+		VkBufferCopy region{};
+		region.srcOffset = offset;
+		region.dstOffset = 0;
+		region.size = sizeof(uint32_t);
+		vkCmdCopyBuffer(cmd, value, readback.handle(), 1, &region);
+	};
+
+	ConvergenceResult result;
+	uint64_t done = 0;
+	uint64_t interval = std::clamp<uint64_t>(options.minInterval, 1, std::max(1u, options.maxInterval));
+	float previousResidual = INFINITY;
+
+	while (done < options.maxIterations)
+	{
+		const uint64_t batch = std::min<uint64_t>(interval, options.maxIterations - done);
+		run_plan(*pimpl, plan, done, batch, hooks);
+		done += batch;
+
+		readback.read(&result.flag, sizeof(uint32_t));
+		std::memcpy(&result.residual, &result.flag, sizeof(float));
+		result.iterations = static_cast<uint32_t>(done);
+		++result.checks;
+
+		if (is_converged(options, result.flag, result.residual))
+		{
+			result.converged = true;
+			break;
+		}
+
+		interval = next_interval(options, done, batch, previousResidual, result.residual);
+		previousResidual = result.residual;
+	}
+	return result;
+}
+
+} // namespace Flow
@@ -0,0 +1,60 @@
+#include "../include/flowVk/Replay.hpp"
+#include "internal/InstanceImpl.hpp"
+#include "internal/Dispatch.hpp"
+
+#include <stdexcept>
+
+namespace Flow {
+
+struct ReplayImpl {
+	detail::RecordedDispatches program;
+
+	explicit ReplayImpl(std::shared_ptr<InstanceImpl> instance) : program(std::move(instance)) {}
+};
+
+static ReplayImpl& get_impl(const Replay& replay, const char* op)
+{
+	if (!replay.impl)
+		throw std::runtime_error(std::string("FlowVk: Replay::") + op + " called on empty Replay");
+	return *replay.impl;
+}
+
+Replay::Replay(const Instance& instance)
+{
+	if (!instance.pimpl)
+		throw std::runtime_error("FlowVk: Replay created from empty Instance");
+	impl = std::make_shared<ReplayImpl>(instance.pimpl);
+}
+
+Replay& Replay::addKernel(const std::string& kernelName, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	return addKernel(kernelName, {}, groupCountX, groupCountY, groupCountZ);
+}
+
+Replay& Replay::addKernel(const std::string& kernelName, const std::vector<BindingOverride>& bindings, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	auto& replay = get_impl(*this, "addKernel");
+
+	detail::RecordedDispatches::Step step;
+	step.kernelName = kernelName;
+	step.overrides = detail::make_binding_map(*replay.program.impl, kernelName, bindings, "Replay::addKernel");
+	step.groupCount[0] = groupCountX;
+	step.groupCount[1] = groupCountY;
+	step.groupCount[2] = groupCountZ;
+	step.barrierBefore = !replay.program.steps.empty();
+	replay.program.steps.push_back(std::move(step));
+	replay.program.invalidate();
+	return *this;
+}
+
+bool Replay::isRecorded() const
+{
+	return get_impl(*this, "isRecorded").program.is_current();
+}
+
+void Replay::submit()
+{
+	get_impl(*this, "submit").program.submit();
+}
+
+} // namespace Flow
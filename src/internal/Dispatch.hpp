@@ -0,0 +1,147 @@
+#pragma once
+
+#include "InstanceImpl.hpp"
+
+#include <span>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Flow::detail {
+
+// ----- User kernels -----
+
+// A kernel added with Instance::addKernel together with the buffer behind each
+// of its metadata bindings (parallel to kernel->module->buffers).
+struct KernelBinding {
+	std::string kernelName;
+	const InstanceImpl::KernelState* kernel = nullptr;
+	std::vector<const InstanceImpl::BufferState*> buffers;
+	std::vector<uint64_t> generations; // BufferState::generation at resolve time
+};
+
+// Shader buffer name -> name of the Flow::Buffer bound in its place for one dispatch.
+using BindingMap = std::vector<std::pair<std::string, std::string>>;
+
+// The kernel's metadata; throws if `kernelName` was never added.
+const InstanceImpl::KernelState& find_kernel(const InstanceImpl& impl, const std::string& kernelName);
+
+// Checks public overrides against the kernel's metadata and the instance; throws with `op` on mismatch.
+BindingMap make_binding_map(const InstanceImpl& impl, const std::string& kernelName,
+                            const std::vector<BindingOverride>& overrides, const char* op);
+
+// Looks up every buffer the kernel binds, by name unless `overrides` maps it
+// elsewhere; throws if one is missing or unallocated.
+KernelBinding resolve_kernel(const InstanceImpl& impl, const std::string& kernelName, const BindingMap& overrides = {});
+
+// The name each of the kernel's bindings resolves to (metadata order).
+std::string bound_name(const BindingMap& overrides, std::string_view shaderName);
+
+// True once a bound buffer was reallocated (resizeBytes) after resolve_kernel.
+bool is_stale(const KernelBinding& binding);
+
+// ----- Descriptor sets -----
+
+// Descriptor sets that live as long as the arena (one call, graph or recording).
+struct DescriptorArena {
+	InstanceImpl& impl;
+	std::vector<VkDescriptorPool> pools;
+	uint32_t setsLeft = 0;
+	uint32_t descriptorsLeft = 0;
+
+	explicit DescriptorArena(InstanceImpl& instance) : impl(instance) {}
+	DescriptorArena(const DescriptorArena&) = delete;
+	DescriptorArena& operator=(const DescriptorArena&) = delete;
+	~DescriptorArena();
+
+	// Allocates the kernel's sets and points them at the resolved buffers; none for push-descriptor kernels.
+	std::vector<VkDescriptorSet> allocate(const KernelBinding& binding);
+
+	// Destroys the pools and every set allocated from them.
+	void reset();
+};
+
+// Points `sets` (from DescriptorArena::allocate) at the buffers of `binding`.
+void write_sets(InstanceImpl& impl, const KernelBinding& binding, std::span<const VkDescriptorSet> sets);
+
+// Instance-wide sets for this kernel and combination of VkBuffers, written on first
+// use. Alternating between a few bindings (ping-pong) only switches sets.
+const std::vector<VkDescriptorSet>& cached_sets(InstanceImpl& impl, const KernelBinding& binding);
+
+// Drops cached sets that reference `buffer`; called before it is destroyed.
+void forget_cached_sets(InstanceImpl& impl, VkBuffer buffer);
+
+// ----- Bindless table -----
+
+// Creates InstanceImpl::bindless on first use and registers every allocated buffer;
+// throws if the device lacks the descriptor indexing features.
+void ensure_bindless_table(InstanceImpl& impl);
+
+// Points the buffer's table slot at its VkBuffer, assigning a slot on first use. Slots
+// belong to the storage: they survive resizes and move with swapStorage.
+void write_bindless_slot(InstanceImpl& impl, InstanceImpl::BufferState& state);
+
+// ----- Recording -----
+
+// Binds the kernel's pipeline and descriptor sets, or pushes its descriptors for
+// push-descriptor kernels, its buffer addresses for device-address kernels and its
+// table handles (binding the table) for bindless kernels; `sets` is then empty.
+// The caller records the dispatch.
+void record_bind(const InstanceImpl& impl, VkCommandBuffer cmd, const KernelBinding& binding, std::span<const VkDescriptorSet> sets);
+
+// One global memory barrier; FlowVk buffers never change queue family or layout.
+void record_barrier(VkCommandBuffer cmd,
+                    VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+// Host writes become visible to compute shaders.
+void record_host_to_compute(VkCommandBuffer cmd);
+// Compute writes become visible to the next dispatch.
+void record_compute_to_compute(VkCommandBuffer cmd);
+// Compute writes become visible to host reads.
+void record_compute_to_host(VkCommandBuffer cmd);
+
+// ----- Reusable submissions -----
+
+// Dispatches recorded once into a command buffer that is resubmitted unchanged.
+// Buffers are resolved by name on the first submit; if one of them is reallocated
+// afterwards, the next submit resolves, rewrites and re-records everything.
+struct RecordedDispatches {
+	struct Step {
+		std::string kernelName;
+		uint32_t groupCount[3] = {1, 1, 1};
+		bool barrierBefore = false; // compute -> compute barrier ahead of this dispatch
+		BindingMap overrides;
+
+		KernelBinding binding;
+		std::vector<VkDescriptorSet> sets;
+	};
+
+	std::shared_ptr<InstanceImpl> impl;
+	std::vector<Step> steps;
+
+	explicit RecordedDispatches(std::shared_ptr<InstanceImpl> instance) : impl(std::move(instance)) {}
+	RecordedDispatches(const RecordedDispatches&) = delete;
+	RecordedDispatches& operator=(const RecordedDispatches&) = delete;
+	~RecordedDispatches();
+
+	// Forces the next submit to re-record, e.g. after `steps` changed.
+	void invalidate() noexcept { recorded = false; }
+
+	// Recorded and no bound buffer has been reallocated since.
+	bool is_current() const;
+
+	// Re-records if needed, submits and waits.
+	void submit();
+
+private:
+	std::unique_ptr<DescriptorArena> arena;
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	VkFence fence = VK_NULL_HANDLE;
+	bool recorded = false;
+
+	void record();
+};
+
+} // namespace Flow::detail
@@ -1,14 +1,17 @@
 #pragma once
 
 #include "../../include/flowVk/Instance.hpp"
+#include "../../include/flowVk/ShaderMeta.hpp"
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 
 #include <unordered_map>
 #include <functional>
+#include <memory>
 #include <set>
 namespace Flow {
 
+namespace detail { struct DescriptorArena; }
 
 struct InstanceImpl {
 	VkInstance 		 instance = VK_NULL_HANDLE;
@@ -21,12 +24,58 @@ struct InstanceImpl {
 	VmaAllocator allocator = VK_NULL_HANDLE;
 
 	VkCommandPool cmdPool = VK_NULL_HANDLE;
-	
+
+	// Loaded when caps.pushDescriptors is set.
+	PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet = nullptr;
+
+	// What the selected device can do; filled once in makeInstance.
+	struct DeviceCaps {
+		uint32_t vendorID = 0;
+		uint32_t apiVersion = VK_API_VERSION_1_0; // the physical device's, capped at the 1.3 FlowVk asks for
+		uint32_t subgroupSize = 1;
+		bool subgroupArithmetic = false;
+		bool subgroupBallot = false;
+		bool shaderInt64 = false;
+		bool shaderFloat64 = false;
+		bool shaderBufferInt64Atomics = false;
+		bool pushDescriptors = false; // VK_KHR_push_descriptor enabled and loaded
+		uint32_t maxPushDescriptors = 0;
+		bool bufferDeviceAddress = false; // named buffers carry SHADER_DEVICE_ADDRESS usage
+		// Update-after-bind, partially bound runtime arrays of storage buffers.
+		bool bindless = false;
+		uint32_t maxBindlessBuffers = 0;
+
+		uint32_t maxWorkGroupInvocations = 128;
+		uint32_t maxSharedMemoryBytes = 16384;
+		uint32_t maxGroupCountX = 65535;
+		uint32_t maxGroupCountY = 65535;
+		uint32_t maxGroupCountZ = 65535;
+		uint32_t maxPushConstantBytes = 128;
+	};
+
 	struct KernelState {
+		const shader_meta::Module* module = nullptr;
 		VkShaderModule shaderModule = VK_NULL_HANDLE;
 		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
 		VkPipeline pipeline = VK_NULL_HANDLE;
 		std::vector<VkDescriptorSetLayout> setLayouts;
+		// Single set layout created with the push-descriptor flag: bindings are written
+		// into the command buffer at dispatch and the kernel never owns descriptor sets.
+		bool pushDescriptors = false;
+		// Push constant range every user kernel's layout declares (the guaranteed minimum),
+		// so shaders may read per-dispatch values such as the runIterations index.
+		static constexpr uint32_t pushConstantBytes = 128;
+	};
+
+	// Kernels shipped inside the library (Flow::ops). One set, storage buffers
+	// only, bound in order; keyed by variant name + specialization values.
+	struct BuiltinKernelState {
+		VkShaderModule shaderModule = VK_NULL_HANDLE;
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		uint32_t bindingCount = 0;
+		uint32_t pushConstantBytes = 0;
 	};
 
 	struct BufferState {
@@ -37,14 +86,66 @@ struct InstanceImpl {
 		VmaAllocation allocation = VK_NULL_HANDLE;
 
 		std::size_t sizeBytes = 0;
+		// Bumped whenever `buffer` is replaced, so recorded descriptor sets can tell they are stale.
+		uint64_t generation = 0;
+		// vkGetBufferDeviceAddress of `buffer` when the device supports it, else 0.
+		VkDeviceAddress address = 0;
+		// Element of the bindless table describing `buffer`; assigned once the table exists.
+		uint32_t bindlessSlot = UINT32_MAX;
+	};
+
+	// Unnamed buffers used by built-in ops for partials and readbacks.
+	struct ScratchBuffer {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		std::size_t sizeBytes = 0;
+		void* mapped = nullptr; // non-null only for readback scratch
 	};
 
+	DeviceCaps caps;
+
 	std::unordered_map<std::string, KernelState> kernels;
 	std::unordered_map<std::string, BufferState> buffers;
+	std::unordered_map<std::string, BuiltinKernelState> builtinKernels;
+	std::vector<ScratchBuffer> freeScratch;
+
+	// Deferred submission (InstanceConfig::deferred_submission): user dispatches and
+	// zeroFill calls are recorded into `pendingCmd` and submitted together by flush().
+	bool deferSubmission = false;
+	VkCommandBuffer pendingCmd = VK_NULL_HANDLE;
+	std::set<std::string> pendingBuffers; // named buffers the pending work uses
+
+	// Descriptor sets of user kernels per combination of bound VkBuffers (detail::cached_sets).
+	struct CachedSets {
+		std::vector<VkBuffer> buffers;
+		std::vector<VkDescriptorSet> sets;
+	};
+	std::unique_ptr<detail::DescriptorArena> setCacheArena;
+	std::unordered_map<std::string, CachedSets> setCache;
+	uint32_t droppedCachedSets = 0;
+
+	// One storage-buffer array at set 0, binding 0 describing every allocated named buffer,
+	// for BufferModel::Bindless kernels. Created by the first such addKernel (detail::ensure_bindless_table).
+	struct BindlessTable {
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		uint32_t capacity = 0;
+		uint32_t nextSlot = 0;
+	};
+	BindlessTable bindless;
+	uint32_t bindlessCapacity = 0; // InstanceConfig::max_bindless_buffers
 
 	~InstanceImpl();
+	// Flushes pending work first, so submissions stay in call order.
 	void submit_one_time(std::function<void(VkCommandBuffer)> record);
 
+	// Appends `record` to the pending command buffer, behind a barrier on earlier pending work.
+	void defer(const std::function<void(VkCommandBuffer)>& record);
+	// Submits pending work, if any, and waits.
+	void flush();
+	bool is_pending(const std::string& bufferName) const { return pendingBuffers.count(bufferName) != 0; }
+
 };
 
-} //namespace Flow
\ No newline at end of file
+} //namespace Flow
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "InstanceImpl.hpp"
+#include "../../include/flowVk/Buffer.hpp"
+#include "../../include/flowVk/ops/Scalar.hpp"
+
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <initializer_list>
+
+namespace Flow::ops::detail {
+
+// ----- Built-in kernels -----
+
+// Returns the cached pipeline for a built-in kernel variant, creating it on first use.
+// `spirv` is the embedded module; `specConstants` are bound to constant_id 0..N-1.
+const InstanceImpl::BuiltinKernelState& get_builtin_kernel(
+	InstanceImpl& impl,
+	std::string_view variant,
+	std::span<const uint32_t> spirv,
+	uint32_t bindingCount,
+	uint32_t pushConstantBytes,
+	std::initializer_list<uint32_t> specConstants = {});
+
+// As above for specialization values only known at run time (e.g. generated programs).
+const InstanceImpl::BuiltinKernelState& get_builtin_kernel(
+	InstanceImpl& impl,
+	std::string_view variant,
+	std::span<const uint32_t> spirv,
+	uint32_t bindingCount,
+	uint32_t pushConstantBytes,
+	std::span<const uint32_t> specConstants);
+
+// Largest power-of-two workgroup size not above `preferred` the device accepts.
+uint32_t workgroup_size(const InstanceImpl& impl, uint32_t preferred = 256);
+
+inline uint32_t div_up(std::size_t value, std::size_t divisor)
+{
+	return static_cast<uint32_t>((value + divisor - 1) / divisor);
+}
+
+// Spreads `groups` workgroups over X (up to the device limit) and Y.
+// Kernels rebuild the flat index as gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x.
+struct GroupCount {
+	uint32_t x = 1;
+	uint32_t y = 1;
+};
+GroupCount split_groups(const InstanceImpl& impl, uint32_t groups);
+
+// ----- Buffers -----
+
+// The named buffer behind `buffer`; throws if it is missing or unallocated.
+InstanceImpl::BufferState& buffer_state(const Buffer& buffer, const char* op);
+
+// All buffers passed to one op must live on the same instance.
+void require_same_owner(const Buffer& a, const Buffer& b, const char* op);
+
+// ----- Scratch -----
+
+enum struct ScratchKind : uint8_t { Device, Readback };
+
+// Pooled unnamed buffer, returned to the instance's free list on destruction.
+struct Scratch {
+	InstanceImpl* owner = nullptr;
+	InstanceImpl::ScratchBuffer buffer{};
+
+	Scratch() = default;
+	Scratch(InstanceImpl& impl, std::size_t bytes, ScratchKind kind);
+	Scratch(const Scratch&) = delete;
+	Scratch& operator=(const Scratch&) = delete;
+	Scratch(Scratch&& other) noexcept;
+	Scratch& operator=(Scratch&& other) noexcept;
+	~Scratch();
+
+	VkBuffer handle() const noexcept { return buffer.buffer; }
+	std::size_t sizeBytes() const noexcept { return buffer.sizeBytes; }
+
+	// Readback scratch only: invalidates and copies `bytes` to `out`.
+	void read(void* out, std::size_t bytes) const;
+};
+
+// ----- Recording -----
+
+// Collects dispatches/fills/barriers for a single submission. Descriptor sets
+// are written as commands are added, so every binding is fixed at call time.
+struct Recorder {
+	InstanceImpl& impl;
+	std::vector<VkDescriptorPool> pools;
+	uint32_t setsLeft = 0;
+	std::vector<std::function<void(VkCommandBuffer)>> commands;
+	std::vector<Scratch> scratchBuffers;
+
+	explicit Recorder(InstanceImpl& instance) : impl(instance) {}
+	Recorder(const Recorder&) = delete;
+	Recorder& operator=(const Recorder&) = delete;
+	~Recorder();
+
+	void dispatch(const InstanceImpl::BuiltinKernelState& kernel,
+	              std::initializer_list<VkBuffer> bindings,
+	              const void* push, uint32_t pushBytes,
+	              uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+	template<class Push>
+	void dispatch(const InstanceImpl::BuiltinKernelState& kernel,
+	              std::initializer_list<VkBuffer> bindings,
+	              const Push& push,
+	              uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1)
+	{
+		dispatch(kernel, bindings, &push, static_cast<uint32_t>(sizeof(Push)), groupCountX, groupCountY, groupCountZ);
+	}
+
+	// Device scratch that stays alive until the recorder is destroyed.
+	VkBuffer scratch(std::size_t bytes);
+
+	void fill(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t value);
+	void copy(VkBuffer src, VkBuffer dst, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size);
+
+	// Small inline upload (vkCmdUpdateBuffer): at most 64 KiB, a multiple of 4 bytes.
+	void update(VkBuffer buffer, VkDeviceSize offset, const void* data, std::size_t bytes);
+
+	// Compute/transfer writes become visible to following compute/transfer work.
+	void barrier();
+
+	// Records everything, makes device writes host-visible, submits and waits.
+	void submit();
+
+private:
+	VkDescriptorSet allocate_set(VkDescriptorSetLayout layout);
+};
+
+// ----- Shared primitives -----
+
+// Records a prefix sum of `count` elements from `input` to `output` (may alias).
+// Scratch comes from the recorder; no barrier is added after the scan.
+void record_scan(Recorder& recorder, ScalarType type, VkBuffer input, VkBuffer output,
+                 uint32_t count, bool inclusive, bool lookback);
+
+// Records an in-place stable radix sort of `count` keys, moving `payloadWords`
+// words of `payload` per key along (0 = keys only). Only the low `keyBits` bits
+// of the order-preserving key are sorted (0 = all). No barrier is added after it.
+void record_radix_sort(Recorder& recorder, ScalarType keyType, VkBuffer keys, VkBuffer payload,
+                       uint32_t count, uint32_t payloadWords, uint32_t keyBits = 0);
+
+// Whether the device is known to give spinning workgroups forward progress.
+bool supports_lookback(const InstanceImpl& impl);
+
+} // namespace Flow::ops::detail
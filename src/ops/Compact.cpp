@@ -0,0 +1,124 @@
+#include "../../include/flowVk/ops/Compact.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kCompactU32[] =
+#include "compact_u32.spv.inc"
+;
+static const uint32_t kCompactI32[] =
+#include "compact_i32.spv.inc"
+;
+static const uint32_t kCompactF32[] =
+#include "compact_f32.spv.inc"
+;
+static const uint32_t kCompactU64[] =
+#include "compact_u64.spv.inc"
+;
+
+struct CompactPush {
+	uint32_t count;
+	uint32_t useFlags;
+	uint32_t op;
+	uint32_t valueLo;
+	uint32_t valueHi;
+	uint32_t writeIndices;
+	uint32_t indirectGroupSize;
+	uint32_t maxGroupCountX;
+};
+
+// Must match COMPACT_MODE in compact.comp.
+static constexpr uint32_t kModeFlags = 0;
+static constexpr uint32_t kModeScatter = 1;
+
+static std::pair<const char*, std::span<const uint32_t>> compact_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"compact_u32", std::span<const uint32_t>(kCompactU32)};
+		case ScalarType::I32: return {"compact_i32", std::span<const uint32_t>(kCompactI32)};
+		case ScalarType::F32: return {"compact_f32", std::span<const uint32_t>(kCompactF32)};
+		case ScalarType::U64: return {"compact_u64", std::span<const uint32_t>(kCompactU64)};
+	}
+	throw std::runtime_error("FlowVk: compact: unsupported element type");
+}
+
+void detail::compact(const Buffer& input, const Buffer* flags, ScalarType type, CompareOp op, uint64_t valueBits,
+                     const Buffer& output, const Buffer& count, CompactOutput mode, uint32_t indirectGroupSize)
+{
+	detail::require_same_owner(input, output, "compact");
+	detail::require_same_owner(input, count, "compact");
+	auto& in = detail::buffer_state(input, "compact");
+	auto& out = detail::buffer_state(output, "compact");
+	auto& countState = detail::buffer_state(count, "compact");
+	InstanceImpl& impl = *input.owner;
+
+	const std::size_t elementSize = scalar_size(type);
+	if (in.sizeBytes % elementSize != 0)
+		throw std::runtime_error("FlowVk: compact: size of '" + input.name + "' is not a multiple of the element size");
+	const std::size_t elements = in.sizeBytes / elementSize;
+	if (elements > UINT32_MAX)
+		throw std::runtime_error("FlowVk: compact: more than 2^32 elements in '" + input.name + "'");
+	if (type == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: compact: 64-bit elements require shaderInt64");
+
+	const std::size_t outputSize = (mode == CompactOutput::Indices) ? sizeof(uint32_t) : elementSize;
+	if (out.sizeBytes < elements * outputSize)
+		throw std::runtime_error("FlowVk: compact: output '" + output.name + "' cannot hold every element of '" + input.name + "'");
+	if (countState.sizeBytes < sizeof(CompactCount))
+		throw std::runtime_error("FlowVk: compact: count buffer '" + count.name + "' is smaller than CompactCount");
+	if (indirectGroupSize == 0)
+		throw std::runtime_error("FlowVk: compact: indirectGroupSize must not be 0");
+
+	VkBuffer flagBuffer = in.buffer; // unread when comparing
+	if (flags)
+	{
+		detail::require_same_owner(input, *flags, "compact");
+		auto& flagState = detail::buffer_state(*flags, "compact");
+		if (flagState.sizeBytes < elements * sizeof(uint32_t))
+			throw std::runtime_error("FlowVk: compact: flags '" + flags->name + "' hold fewer than one uint32_t per element");
+		flagBuffer = flagState.buffer;
+	}
+
+	detail::Recorder recorder(impl);
+
+	if (elements == 0)
+	{
+		recorder.fill(countState.buffer, 0, sizeof(CompactCount), 0);
+		recorder.submit();
+		return;
+	}
+
+	const auto [variant, spirv] = compact_variant(type);
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(elements, groupSize));
+	const auto& flagsKernel = detail::get_builtin_kernel(impl, variant, spirv, 7, sizeof(CompactPush), {groupSize, kModeFlags});
+	const auto& scatterKernel = detail::get_builtin_kernel(impl, variant, spirv, 7, sizeof(CompactPush), {groupSize, kModeScatter});
+
+	const CompactPush push{
+		static_cast<uint32_t>(elements),
+		flags ? 1u : 0u,
+		static_cast<uint32_t>(op),
+		static_cast<uint32_t>(valueBits),
+		static_cast<uint32_t>(valueBits >> 32),
+		mode == CompactOutput::Indices ? 1u : 0u,
+		indirectGroupSize,
+		impl.caps.maxGroupCountX};
+
+	const VkBuffer keepFlags = recorder.scratch(elements * sizeof(uint32_t));
+	const VkBuffer positions = recorder.scratch(elements * sizeof(uint32_t));
+
+	recorder.dispatch(flagsKernel, {in.buffer, flagBuffer, keepFlags, positions, out.buffer, out.buffer, countState.buffer}, push, groups.x, groups.y);
+	recorder.barrier();
+	detail::record_scan(recorder, ScalarType::U32, keepFlags, positions, static_cast<uint32_t>(elements), false, detail::supports_lookback(impl));
+	recorder.barrier();
+	recorder.dispatch(scatterKernel, {in.buffer, flagBuffer, keepFlags, positions, out.buffer, out.buffer, countState.buffer}, push, groups.x, groups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
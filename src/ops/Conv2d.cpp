@@ -0,0 +1,165 @@
+#include "../../include/flowVk/ops/Conv2d.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kConv2d[] =
+#include "conv2d.spv.inc"
+;
+
+struct Conv2dPush {
+	uint32_t width;
+	uint32_t height;
+};
+
+static constexpr uint32_t kTileX = 16;
+static constexpr uint32_t kTileY = 16;
+static constexpr uint32_t kMaxKernelSize = 33;
+
+// Rank-1 factorization weights = column * row^T, if it exists.
+bool factor_separable(const std::vector<float>& weights, uint32_t kernelWidth, uint32_t kernelHeight, std::vector<float>& factors)
+{
+	const std::size_t count = std::size_t(kernelWidth) * kernelHeight;
+	if (count == 0 || weights.size() < count)
+		throw std::runtime_error("FlowVk: factor_separable: fewer than kernelWidth * kernelHeight weights");
+
+	std::size_t pivot = 0;
+	for (std::size_t i = 1; i < count; ++i)
+		if (std::fabs(weights[i]) > std::fabs(weights[pivot]))
+			pivot = i;
+
+	const float peak = std::fabs(weights[pivot]);
+	if (peak == 0.0f)
+		return false;
+
+	const uint32_t py = static_cast<uint32_t>(pivot / kernelWidth);
+	const uint32_t px = static_cast<uint32_t>(pivot % kernelWidth);
+	std::vector<float> row(kernelWidth), column(kernelHeight);
+	for (uint32_t x = 0; x < kernelWidth; ++x)
+		row[x] = weights[py * kernelWidth + x] / weights[pivot];
+	for (uint32_t y = 0; y < kernelHeight; ++y)
+		column[y] = weights[y * kernelWidth + px];
+
+	const float tolerance = 1e-6f * peak;
+	for (uint32_t y = 0; y < kernelHeight; ++y)
+		for (uint32_t x = 0; x < kernelWidth; ++x)
+			if (std::fabs(weights[y * kernelWidth + x] - column[y] * row[x]) > tolerance)
+				return false;
+
+	factors = std::move(row);
+	factors.insert(factors.end(), column.begin(), column.end());
+	return true;
+}
+
+static void filter2d(const Buffer& input, const Buffer& output, const Buffer& weights, const Conv2dDesc& desc,
+                     bool flip, const char* op)
+{
+	detail::require_same_owner(input, output, op);
+	detail::require_same_owner(input, weights, op);
+	auto& in = detail::buffer_state(input, op);
+	auto& out = detail::buffer_state(output, op);
+	auto& weightState = detail::buffer_state(weights, op);
+	InstanceImpl& impl = *input.owner;
+
+	auto fail = [&](const std::string& message) { return std::runtime_error(std::string("FlowVk: ") + op + ": " + message); };
+
+	if (desc.kernelWidth % 2 == 0 || desc.kernelHeight % 2 == 0)
+		throw fail("kernel width and height must be odd");
+	if (desc.kernelWidth > kMaxKernelSize || desc.kernelHeight > kMaxKernelSize)
+		throw fail("kernels are limited to 33 x 33");
+	const std::size_t pixels = std::size_t(desc.width) * desc.height * desc.batch;
+	if (pixels > UINT32_MAX)
+		throw fail("more than 2^32 pixels");
+	if (in.sizeBytes < pixels * sizeof(float))
+		throw fail("input '" + input.name + "' is smaller than the images");
+	if (out.sizeBytes < pixels * sizeof(float))
+		throw fail("output '" + output.name + "' is smaller than the images");
+	const std::size_t weightCount = desc.separable ? std::size_t(desc.kernelWidth) + desc.kernelHeight
+	                                               : std::size_t(desc.kernelWidth) * desc.kernelHeight;
+	if (weightState.sizeBytes < weightCount * sizeof(float))
+		throw fail("weights '" + weights.name + "' hold fewer than " +
+		           (desc.separable ? "kernelWidth + kernelHeight" : "kernelWidth * kernelHeight") + " floats");
+	if (desc.batch > impl.caps.maxGroupCountZ)
+		throw fail("batch exceeds the device's Z group limit");
+	if (pixels == 0 || desc.steps == 0)
+		return;
+
+	const uint32_t rx = desc.kernelWidth / 2;
+	const uint32_t ry = desc.kernelHeight / 2;
+	const uint32_t border = static_cast<uint32_t>(desc.border);
+	auto kernel = [&](uint32_t radiusX, uint32_t radiusY) -> const InstanceImpl::BuiltinKernelState& {
+		return detail::get_builtin_kernel(impl, "conv2d", kConv2d, 3, sizeof(Conv2dPush),
+		                                  {kTileX, kTileY, radiusX, radiusY, flip ? 1u : 0u, border});
+	};
+
+	const Conv2dPush push{desc.width, desc.height};
+	const uint32_t groupsX = detail::div_up(desc.width, kTileX);
+	const uint32_t groupsY = detail::div_up(desc.height, kTileY);
+	if (groupsX > impl.caps.maxGroupCountX || groupsY > impl.caps.maxGroupCountY)
+		throw fail("image exceeds the device's X or Y group limit");
+	const std::size_t imageBytes = pixels * sizeof(float);
+
+	detail::Recorder recorder(impl);
+
+	VkBuffer rowWeights = VK_NULL_HANDLE;
+	VkBuffer columnWeights = VK_NULL_HANDLE;
+	VkBuffer between = VK_NULL_HANDLE;
+	if (desc.separable)
+	{
+		// The row factor is read in place; the column factor is copied to offset 0 of its own buffer.
+		rowWeights = weightState.buffer;
+		columnWeights = recorder.scratch(desc.kernelHeight * sizeof(float));
+		between = recorder.scratch(imageBytes);
+		recorder.copy(weightState.buffer, columnWeights, desc.kernelWidth * sizeof(float), 0, desc.kernelHeight * sizeof(float));
+		recorder.barrier();
+	}
+
+	// Steps alternate between the output and one scratch image so the last lands in the output.
+	VkBuffer current = in.buffer;
+	if (&in == &out)
+	{
+		current = recorder.scratch(imageBytes);
+		recorder.copy(in.buffer, current, 0, 0, imageBytes);
+		recorder.barrier();
+	}
+	const VkBuffer pingPong = (desc.steps > 1) ? recorder.scratch(imageBytes) : VK_NULL_HANDLE;
+
+	for (uint32_t step = 0; step < desc.steps; ++step)
+	{
+		const VkBuffer target = ((desc.steps - 1 - step) % 2 == 0) ? out.buffer : pingPong;
+		if (step > 0)
+			recorder.barrier();
+
+		if (desc.separable)
+		{
+			recorder.dispatch(kernel(rx, 0), {current, between, rowWeights}, push, groupsX, groupsY, desc.batch);
+			recorder.barrier();
+			recorder.dispatch(kernel(0, ry), {between, target, columnWeights}, push, groupsX, groupsY, desc.batch);
+		}
+		else
+			recorder.dispatch(kernel(rx, ry), {current, target, weightState.buffer}, push, groupsX, groupsY, desc.batch);
+
+		current = target;
+	}
+
+	recorder.submit();
+}
+
+void conv2d(const Buffer& input, const Buffer& output, const Buffer& weights, const Conv2dDesc& desc)
+{
+	filter2d(input, output, weights, desc, true, "conv2d");
+}
+
+void stencil2d(const Buffer& input, const Buffer& output, const Buffer& weights, const Conv2dDesc& desc)
+{
+	filter2d(input, output, weights, desc, false, "stencil2d");
+}
+
+} // namespace Flow::ops
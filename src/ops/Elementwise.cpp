@@ -0,0 +1,114 @@
+#include "../../include/flowVk/ops/Elementwise.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kElementwise[] =
+#include "elementwise.spv.inc"
+;
+
+struct ElementwisePush {
+	uint32_t count;
+	float constants[detail::ExprProgram::kMaxConstants];
+};
+
+// ----- Program building -----
+
+void detail::ExprProgram::emit(ExprOp op, uint32_t operand)
+{
+	if (length == kMaxInstructions)
+		throw std::runtime_error("FlowVk: evaluate: expression has more than 32 instructions");
+	code[length++] = static_cast<uint32_t>(op) | (operand << 8);
+}
+
+void detail::ExprProgram::load(const Buffer& buffer)
+{
+	uint32_t slot = 0;
+	while (slot < inputCount && !(inputs[slot]->owner == buffer.owner && inputs[slot]->name == buffer.name))
+		++slot;
+	if (slot == inputCount)
+	{
+		if (inputCount == kMaxInputs)
+			throw std::runtime_error("FlowVk: evaluate: expression reads more than 7 buffers");
+		inputs[inputCount++] = &buffer;
+	}
+
+	if (depth == kMaxStack)
+		throw std::runtime_error("FlowVk: evaluate: expression nests too deeply");
+	emit(ExprOp::Buffer, slot);
+	++depth;
+}
+
+void detail::ExprProgram::constant(float value)
+{
+	if (constantCount == kMaxConstants)
+		throw std::runtime_error("FlowVk: evaluate: expression has more than 16 constants");
+	if (depth == kMaxStack)
+		throw std::runtime_error("FlowVk: evaluate: expression nests too deeply");
+	constants[constantCount] = value;
+	emit(ExprOp::Constant, constantCount++);
+	++depth;
+}
+
+void detail::ExprProgram::apply(ExprOp op, uint32_t operands)
+{
+	emit(op, 0);
+	depth -= operands - 1;
+}
+
+// ----- Evaluation -----
+
+void detail::evaluate(const Buffer& output, const ExprProgram& program)
+{
+	auto& out = detail::buffer_state(output, "evaluate");
+	InstanceImpl& impl = *output.owner;
+
+	if (out.sizeBytes % sizeof(float) != 0)
+		throw std::runtime_error("FlowVk: evaluate: size of '" + output.name + "' is not a multiple of 4");
+	const std::size_t count = out.sizeBytes / sizeof(float);
+	if (count > UINT32_MAX)
+		throw std::runtime_error("FlowVk: evaluate: more than 2^32 elements in '" + output.name + "'");
+
+	VkBuffer inputs[ExprProgram::kMaxInputs];
+	for (uint32_t i = 0; i < ExprProgram::kMaxInputs; ++i)
+	{
+		if (i >= program.inputCount)
+		{
+			inputs[i] = out.buffer; // never read past inputCount
+			continue;
+		}
+		const Buffer& input = *program.inputs[i];
+		detail::require_same_owner(output, input, "evaluate");
+		auto& state = detail::buffer_state(input, "evaluate");
+		if (state.sizeBytes < count * sizeof(float))
+			throw std::runtime_error("FlowVk: evaluate: input '" + input.name + "' is smaller than output '" + output.name + "'");
+		inputs[i] = state.buffer;
+	}
+	if (count == 0)
+		return;
+
+	// Specialization: workgroup size, program length, then the instructions (unused ones stay 0).
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	std::array<uint32_t, 2 + ExprProgram::kMaxInstructions> spec{};
+	spec[0] = groupSize;
+	spec[1] = program.length;
+	std::copy_n(program.code.begin(), program.length, spec.begin() + 2);
+	const auto& kernel = detail::get_builtin_kernel(impl, "elementwise", kElementwise, 8, sizeof(ElementwisePush),
+	                                                std::span<const uint32_t>(spec.data(), 2 + program.length));
+
+	ElementwisePush push{static_cast<uint32_t>(count), {}};
+	std::copy_n(program.constants.begin(), program.constantCount, push.constants);
+
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(count, groupSize));
+	detail::Recorder recorder(impl);
+	recorder.dispatch(kernel, {out.buffer, inputs[0], inputs[1], inputs[2], inputs[3], inputs[4], inputs[5], inputs[6]},
+	                  push, groups.x, groups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,290 @@
+#include "../../include/flowVk/ops/Fft.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kFft[] =
+#include "fft.spv.inc"
+;
+
+struct FftPush {
+	uint32_t count;
+	uint32_t elementStride;
+	uint32_t inner;
+	uint32_t innerStride;
+	uint32_t outerStride;
+	uint32_t fullWidth;
+	uint32_t halfWidth;
+};
+
+// Must match FFT_MODE and MAX_RADIX in fft.comp.
+static constexpr uint32_t kModePass = 0;
+static constexpr uint32_t kModeFromReal = 1;
+static constexpr uint32_t kModeTruncate = 2;
+static constexpr uint32_t kModeExpand = 3;
+static constexpr uint32_t kModeToReal = 4;
+
+// Radix 4 first: the fewest passes among the butterflies written out in the kernel.
+static constexpr uint32_t kRadices[] = {4, 2, 3, 5, 7, 11, 13};
+
+using KernelRef = const InstanceImpl::BuiltinKernelState*;
+
+// Stockham passes along one axis, for both directions.
+struct FftAxis {
+	uint32_t length = 1;
+	std::vector<uint32_t> radices;
+	std::vector<KernelRef> forward;
+	std::vector<KernelRef> inverse;
+};
+
+struct FftPlanImpl {
+	std::shared_ptr<InstanceImpl> owner;
+	FftDesc desc;
+	uint32_t groupSize = 0;
+	uint32_t rowLength = 0; // complex elements per row in the spectrum
+	FftAxis rows;
+	FftAxis columns;
+
+	KernelRef fromReal = nullptr;
+	KernelRef truncate = nullptr;
+	KernelRef expand = nullptr;
+	KernelRef toReal = nullptr;
+};
+
+static std::vector<uint32_t> factorize(uint32_t length)
+{
+	std::vector<uint32_t> factors;
+	for (uint32_t radix : kRadices)
+	{
+		while (length % radix == 0)
+		{
+			factors.push_back(radix);
+			length /= radix;
+		}
+	}
+	if (length != 1)
+		throw std::runtime_error("FlowVk: fft: length has a prime factor above 13");
+	return factors;
+}
+
+static FftAxis make_axis(InstanceImpl& impl, uint32_t groupSize, uint32_t length)
+{
+	FftAxis axis;
+	axis.length = length;
+
+	axis.radices = factorize(length);
+
+	uint32_t sublength = 1;
+	for (uint32_t radix : axis.radices)
+	{
+		for (uint32_t inverse : {0u, 1u})
+		{
+			const auto& kernel = detail::get_builtin_kernel(impl, "fft", kFft, 4, sizeof(FftPush),
+			                                                {groupSize, kModePass, length, radix, sublength, inverse});
+			(inverse ? axis.inverse : axis.forward).push_back(&kernel);
+		}
+		sublength *= radix;
+	}
+	return axis;
+}
+
+FftPlan::FftPlan(const Instance& instance, const FftDesc& desc)
+{
+	if (!instance)
+		throw std::runtime_error("FlowVk: FftPlan on empty Instance");
+	if (desc.nx == 0 || desc.ny == 0 || desc.batch == 0)
+		throw std::runtime_error("FlowVk: fft: nx, ny and batch must be positive");
+	if (std::size_t(desc.nx) * desc.ny * desc.batch > UINT32_MAX)
+		throw std::runtime_error("FlowVk: fft: more than 2^32 elements");
+
+	InstanceImpl& owner = *instance.pimpl;
+	auto plan = std::make_shared<FftPlanImpl>();
+	plan->owner = instance.pimpl;
+	plan->desc = desc;
+	plan->groupSize = detail::workgroup_size(owner, 256);
+
+	const bool real = (desc.kind == FftKind::RealToComplex);
+	plan->rowLength = real ? desc.nx / 2 + 1 : desc.nx;
+	plan->rows = make_axis(owner, plan->groupSize, desc.nx);
+	plan->columns = make_axis(owner, plan->groupSize, desc.ny);
+
+	if (real)
+	{
+		auto helper = [&](uint32_t mode) { return &detail::get_builtin_kernel(owner, "fft", kFft, 4, sizeof(FftPush), {plan->groupSize, mode}); };
+		plan->fromReal = helper(kModeFromReal);
+		plan->truncate = helper(kModeTruncate);
+		plan->expand = helper(kModeExpand);
+		plan->toReal = helper(kModeToReal);
+	}
+
+	impl = std::move(plan);
+}
+
+const FftDesc& FftPlan::desc() const
+{
+	if (!impl)
+		throw std::runtime_error("FlowVk: desc() on empty FftPlan");
+	return impl->desc;
+}
+
+std::size_t FftPlan::spatialBytes() const
+{
+	const FftDesc& d = desc();
+	const std::size_t elements = std::size_t(d.nx) * d.ny * d.batch;
+	return elements * (d.kind == FftKind::RealToComplex ? sizeof(float) : 2 * sizeof(float));
+}
+
+std::size_t FftPlan::spectrumBytes() const
+{
+	const FftDesc& d = desc();
+	return std::size_t(impl->rowLength) * d.ny * d.batch * 2 * sizeof(float);
+}
+
+// One dispatch of the chain; buffers are assigned when the chain is recorded.
+struct FftStep {
+	KernelRef kernel;
+	FftPush push;
+	uint32_t threads;
+};
+
+static void run(const FftPlanImpl& plan, const Buffer& input, const Buffer& output, bool inverse)
+{
+	detail::require_same_owner(input, output, "fft");
+	if (input.owner != plan.owner)
+		throw std::runtime_error("FlowVk: fft: buffer '" + input.name + "' belongs to another instance than the plan");
+	auto& in = detail::buffer_state(input, "fft");
+	auto& out = detail::buffer_state(output, "fft");
+	InstanceImpl& impl = *plan.owner;
+
+	const FftDesc& d = plan.desc;
+	const bool real = (d.kind == FftKind::RealToComplex);
+	const std::size_t fullElements = std::size_t(d.nx) * d.ny * d.batch;
+	const std::size_t halfElements = std::size_t(plan.rowLength) * d.ny * d.batch;
+	const std::size_t spatialBytes = fullElements * (real ? sizeof(float) : 2 * sizeof(float));
+	const std::size_t spectrumBytes = halfElements * 2 * sizeof(float);
+
+	const std::size_t inBytes = inverse ? spectrumBytes : spatialBytes;
+	const std::size_t outBytes = inverse ? spatialBytes : spectrumBytes;
+	if (in.sizeBytes < inBytes)
+		throw std::runtime_error("FlowVk: fft: input '" + input.name + "' is smaller than the transform");
+	if (out.sizeBytes < outBytes)
+		throw std::runtime_error("FlowVk: fft: output '" + output.name + "' is smaller than the transform");
+
+	const uint32_t rowCount = d.ny * d.batch;
+	auto row_layout = [&](uint32_t width) {
+		return FftPush{rowCount, 1, 1, 0, width, 0, 0};
+	};
+	auto column_layout = [&](uint32_t width) {
+		return FftPush{width * d.batch, width, width, 1, width * d.ny, 0, 0};
+	};
+	auto add_axis = [&](std::vector<FftStep>& steps, const FftAxis& axis, FftPush layout) {
+		const auto& passes = inverse ? axis.inverse : axis.forward;
+		for (std::size_t i = 0; i < passes.size(); ++i)
+			steps.push_back({passes[i], layout, layout.count * (axis.length / axis.radices[i])});
+	};
+	auto add_helper = [&](std::vector<FftStep>& steps, KernelRef kernel, uint32_t count) {
+		steps.push_back({kernel, FftPush{count, 0, 0, 0, 0, d.nx, plan.rowLength}, count});
+	};
+
+	std::vector<FftStep> steps;
+	if (!real)
+	{
+		add_axis(steps, plan.rows, row_layout(d.nx));
+		add_axis(steps, plan.columns, column_layout(d.nx));
+	}
+	else if (!inverse)
+	{
+		add_helper(steps, plan.fromReal, static_cast<uint32_t>(fullElements));
+		add_axis(steps, plan.rows, row_layout(d.nx));
+		add_helper(steps, plan.truncate, static_cast<uint32_t>(halfElements));
+		add_axis(steps, plan.columns, column_layout(plan.rowLength));
+	}
+	else
+	{
+		add_axis(steps, plan.columns, column_layout(plan.rowLength));
+		add_helper(steps, plan.expand, static_cast<uint32_t>(fullElements));
+		add_axis(steps, plan.rows, row_layout(d.nx));
+		add_helper(steps, plan.toReal, static_cast<uint32_t>(fullElements));
+	}
+
+	detail::Recorder recorder(impl);
+
+	if (steps.empty())
+	{
+		if (&in != &out)
+			recorder.copy(in.buffer, out.buffer, 0, 0, inBytes);
+		recorder.submit();
+		return;
+	}
+
+	// Every step reads the previous result; intermediates ping-pong through scratch so
+	// the input is never overwritten, and only the last step writes the output.
+	const std::size_t scratchBytes = fullElements * 2 * sizeof(float);
+	const VkBuffer scratch[2] = {recorder.scratch(scratchBytes), recorder.scratch(scratchBytes)};
+	VkBuffer current = in.buffer;
+	int ping = 0;
+
+	for (std::size_t i = 0; i < steps.size(); ++i)
+	{
+		const bool last = (i + 1 == steps.size());
+		VkBuffer target = scratch[ping];
+		if (target == current)
+			target = scratch[ping ^= 1];
+		if (last && current != out.buffer)
+			target = out.buffer;
+
+		const FftStep& step = steps[i];
+		const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(step.threads, plan.groupSize));
+		if (i > 0)
+			recorder.barrier();
+		recorder.dispatch(*step.kernel, {current, target, current, target}, step.push, groups.x, groups.y);
+
+		current = target;
+		ping ^= 1;
+	}
+
+	// Single-step in-place transforms end in scratch.
+	if (current != out.buffer)
+	{
+		recorder.barrier();
+		recorder.copy(current, out.buffer, 0, 0, outBytes);
+	}
+
+	recorder.submit();
+}
+
+void FftPlan::forward(const Buffer& input, const Buffer& output) const
+{
+	if (!impl)
+		throw std::runtime_error("FlowVk: forward() on empty FftPlan");
+	run(*impl, input, output, false);
+}
+
+void FftPlan::inverse(const Buffer& input, const Buffer& output) const
+{
+	if (!impl)
+		throw std::runtime_error("FlowVk: inverse() on empty FftPlan");
+	run(*impl, input, output, true);
+}
+
+void fft(const Buffer& input, const Buffer& output, const FftDesc& desc, FftDirection direction)
+{
+	if (!input.owner)
+		throw std::runtime_error("FlowVk: fft on empty Buffer");
+
+	Instance instance;
+	instance.pimpl = input.owner;
+	const FftPlan plan(instance, desc);
+	if (direction == FftDirection::Forward)
+		plan.forward(input, output);
+	else
+		plan.inverse(input, output);
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,164 @@
+#include "../../include/flowVk/ops/Gather.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kGather[] =
+#include "gather.spv.inc"
+;
+static const uint32_t kScatterAddU32[] =
+#include "scatter_add_u32.spv.inc"
+;
+static const uint32_t kScatterAddI32[] =
+#include "scatter_add_i32.spv.inc"
+;
+static const uint32_t kScatterAddF32[] =
+#include "scatter_add_f32.spv.inc"
+;
+static const uint32_t kScatterAddU64[] =
+#include "scatter_add_u64.spv.inc"
+;
+
+struct GatherPush {
+	uint32_t count;
+	uint32_t elementUnits;
+	uint32_t inputElements;
+	uint32_t outputElements;
+	uint32_t invocations;
+};
+
+struct ScatterAddPush {
+	uint32_t count;
+	uint32_t components;
+	uint32_t outputElements;
+};
+
+// Must match GATHER_MODE in gather.comp.
+static constexpr uint32_t kModeGather = 0;
+static constexpr uint32_t kModeScatter = 1;
+
+static std::pair<const char*, std::span<const uint32_t>> scatter_add_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"scatter_add_u32", std::span<const uint32_t>(kScatterAddU32)};
+		case ScalarType::I32: return {"scatter_add_i32", std::span<const uint32_t>(kScatterAddI32)};
+		case ScalarType::F32: return {"scatter_add_f32", std::span<const uint32_t>(kScatterAddF32)};
+		case ScalarType::U64: return {"scatter_add_u64", std::span<const uint32_t>(kScatterAddU64)};
+	}
+	throw std::runtime_error("FlowVk: scatter_add: unsupported element type");
+}
+
+static uint32_t index_count(const Buffer& indices, const InstanceImpl::BufferState& state, const char* op)
+{
+	if (state.sizeBytes % sizeof(uint32_t) != 0)
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": size of indices '" + indices.name + "' is not a multiple of 4");
+	const std::size_t count = state.sizeBytes / sizeof(uint32_t);
+	if (count > UINT32_MAX)
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": more than 2^32 indices in '" + indices.name + "'");
+	return static_cast<uint32_t>(count);
+}
+
+static void move_elements(const Buffer& input, const Buffer& indices, const Buffer& output, std::size_t elementBytes,
+                          uint32_t mode, const char* op)
+{
+	detail::require_same_owner(input, indices, op);
+	detail::require_same_owner(input, output, op);
+	auto& in = detail::buffer_state(input, op);
+	auto& idx = detail::buffer_state(indices, op);
+	auto& out = detail::buffer_state(output, op);
+	InstanceImpl& impl = *input.owner;
+
+	auto fail = [&](const std::string& message) { return std::runtime_error(std::string("FlowVk: ") + op + ": " + message); };
+
+	if (elementBytes == 0 || (elementBytes > 2 && elementBytes % 4 != 0))
+		throw fail("element size must be 1, 2 or a multiple of 4 bytes");
+	if (&in == &out)
+		throw fail("input and output must be different buffers");
+	const uint32_t count = index_count(indices, idx, op);
+
+	// Packed elements are addressed by word, so whole words of both buffers must exist.
+	const std::size_t inputElements = (elementBytes < 4) ? (in.sizeBytes / 4 * 4) / elementBytes : in.sizeBytes / elementBytes;
+	const std::size_t outputElements = (elementBytes < 4) ? (out.sizeBytes / 4 * 4) / elementBytes : out.sizeBytes / elementBytes;
+	const std::size_t moved = (mode == kModeGather) ? outputElements : inputElements;
+	if (moved < count)
+		throw fail(mode == kModeGather ? "output '" + output.name + "' holds fewer elements than there are indices"
+		                               : "input '" + input.name + "' holds fewer elements than there are indices");
+	if (count == 0)
+		return;
+
+	// Widest vector dividing the element: uvec4 loads for 16-byte multiples, then uvec2, then words.
+	const uint32_t vecWords = (elementBytes < 4) ? 0u : (elementBytes % 16 == 0) ? 4u : (elementBytes % 8 == 0) ? 2u : 1u;
+	const std::size_t elementUnits = (vecWords == 0) ? elementBytes : elementBytes / (4u * vecWords);
+	const std::size_t invocations = (vecWords != 0)        ? std::size_t(count) * elementUnits
+	                                : (mode == kModeGather) ? detail::div_up(count, 4 / elementBytes)
+	                                                        : count;
+	if (invocations > UINT32_MAX || std::max(inputElements, outputElements) * elementUnits > UINT32_MAX)
+		throw fail("more than 2^32 vectors to address");
+
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const auto& kernel = detail::get_builtin_kernel(impl, "gather", kGather, 3, sizeof(GatherPush), {groupSize, mode, vecWords});
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(invocations, groupSize));
+	const GatherPush push{count, static_cast<uint32_t>(elementUnits),
+	                      static_cast<uint32_t>(std::min<std::size_t>(inputElements, UINT32_MAX)),
+	                      static_cast<uint32_t>(std::min<std::size_t>(outputElements, UINT32_MAX)),
+	                      static_cast<uint32_t>(invocations)};
+
+	detail::Recorder recorder(impl);
+	recorder.dispatch(kernel, {in.buffer, idx.buffer, out.buffer}, push, groups.x, groups.y);
+	recorder.submit();
+}
+
+void gather(const Buffer& input, const Buffer& indices, const Buffer& output, std::size_t elementBytes)
+{
+	move_elements(input, indices, output, elementBytes, kModeGather, "gather");
+}
+
+void scatter(const Buffer& input, const Buffer& indices, const Buffer& output, std::size_t elementBytes)
+{
+	move_elements(input, indices, output, elementBytes, kModeScatter, "scatter");
+}
+
+void detail::scatter_add(const Buffer& input, const Buffer& indices, const Buffer& output, ScalarType type, uint32_t components)
+{
+	detail::require_same_owner(input, indices, "scatter_add");
+	detail::require_same_owner(input, output, "scatter_add");
+	auto& in = detail::buffer_state(input, "scatter_add");
+	auto& idx = detail::buffer_state(indices, "scatter_add");
+	auto& out = detail::buffer_state(output, "scatter_add");
+	InstanceImpl& impl = *input.owner;
+
+	if (components == 0)
+		throw std::runtime_error("FlowVk: scatter_add: components must not be 0");
+	if (&in == &out)
+		throw std::runtime_error("FlowVk: scatter_add: input and output must be different buffers");
+	if (type == ScalarType::U64 && !(impl.caps.shaderInt64 && impl.caps.shaderBufferInt64Atomics))
+		throw std::runtime_error("FlowVk: scatter_add: 64-bit elements require shaderBufferInt64Atomics");
+
+	const std::size_t elementBytes = scalar_size(type) * components;
+	const uint32_t count = index_count(indices, idx, "scatter_add");
+	if (in.sizeBytes < std::size_t(count) * elementBytes)
+		throw std::runtime_error("FlowVk: scatter_add: input '" + input.name + "' holds fewer elements than there are indices");
+	const std::size_t outputElements = out.sizeBytes / elementBytes;
+	if (std::size_t(count) * components > UINT32_MAX || outputElements * components > UINT32_MAX)
+		throw std::runtime_error("FlowVk: scatter_add: more than 2^32 scalars to address");
+	if (count == 0)
+		return;
+
+	const auto [variant, spirv] = scatter_add_variant(type);
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const auto& kernel = detail::get_builtin_kernel(impl, variant, spirv, 3, sizeof(ScatterAddPush), {groupSize});
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(std::size_t(count) * components, groupSize));
+
+	detail::Recorder recorder(impl);
+	recorder.dispatch(kernel, {in.buffer, idx.buffer, out.buffer},
+	                  ScatterAddPush{count, components, static_cast<uint32_t>(outputElements)}, groups.x, groups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
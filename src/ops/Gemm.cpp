@@ -0,0 +1,110 @@
+#include "../../include/flowVk/ops/Gemm.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kGemmF32[] =
+#include "gemm_f32.spv.inc"
+;
+
+struct GemmPush {
+	uint32_t m;
+	uint32_t n;
+	uint32_t k;
+	uint32_t layoutA;
+	uint32_t layoutB;
+	uint32_t layoutC;
+	uint32_t batchOffset;
+	float alpha;
+	float beta;
+};
+
+// Square output tile per workgroup and rows of it each invocation accumulates.
+// Must stay within MAX_TILE / MAX_WPT in gemm.comp.
+struct GemmTile {
+	uint32_t size;
+	uint32_t rowsPerThread;
+};
+
+static constexpr GemmTile kTiles[] = {
+	{32, 4}, // 256 invocations, 8 KiB shared
+	{16, 2}, // 128 invocations, 2 KiB shared
+	{8, 1},  //  64 invocations, 512 B shared
+};
+
+// Largest tile the device accepts that does not dwarf the matrices; small
+// batched products get small tiles so most invocations do useful work.
+static GemmTile pick_tile(const InstanceImpl& impl, uint32_t m, uint32_t n)
+{
+	const uint32_t extent = std::max(m, n);
+	for (const GemmTile& tile : kTiles)
+	{
+		const uint32_t invocations = tile.size * (tile.size / tile.rowsPerThread);
+		const uint32_t sharedBytes = 2 * tile.size * tile.size * sizeof(float);
+		if (invocations > impl.caps.maxWorkGroupInvocations || sharedBytes > impl.caps.maxSharedMemoryBytes)
+			continue;
+		if (tile.size / 2 >= extent)
+			continue;
+		return tile;
+	}
+	return kTiles[std::size(kTiles) - 1];
+}
+
+void gemm(const Buffer& a, const Buffer& b, const Buffer& c, const GemmDesc& desc)
+{
+	detail::require_same_owner(a, b, "gemm");
+	detail::require_same_owner(a, c, "gemm");
+	auto& stateA = detail::buffer_state(a, "gemm");
+	auto& stateB = detail::buffer_state(b, "gemm");
+	auto& stateC = detail::buffer_state(c, "gemm");
+	InstanceImpl& impl = *a.owner;
+
+	if (desc.m == 0 || desc.n == 0 || desc.batch == 0)
+		return;
+
+	const std::size_t elementsA = std::size_t(desc.m) * desc.k;
+	const std::size_t elementsB = std::size_t(desc.k) * desc.n;
+	const std::size_t elementsC = std::size_t(desc.m) * desc.n;
+	if (std::max({elementsA, elementsB, elementsC}) * desc.batch > UINT32_MAX)
+		throw std::runtime_error("FlowVk: gemm: more than 2^32 elements in one operand");
+	if (stateA.sizeBytes < elementsA * desc.batch * sizeof(float))
+		throw std::runtime_error("FlowVk: gemm: '" + a.name + "' is smaller than batch * m * k floats");
+	if (stateB.sizeBytes < elementsB * desc.batch * sizeof(float))
+		throw std::runtime_error("FlowVk: gemm: '" + b.name + "' is smaller than batch * k * n floats");
+	if (stateC.sizeBytes < elementsC * desc.batch * sizeof(float))
+		throw std::runtime_error("FlowVk: gemm: '" + c.name + "' is smaller than batch * m * n floats");
+
+	const GemmTile tile = pick_tile(impl, desc.m, desc.n);
+	const uint32_t rowsOfThreads = tile.size / tile.rowsPerThread;
+	const auto& kernel = detail::get_builtin_kernel(impl, "gemm_f32", kGemmF32, 3, sizeof(GemmPush),
+	                                                {tile.size, rowsOfThreads, tile.size, tile.rowsPerThread});
+
+	const uint32_t groupsX = detail::div_up(desc.n, tile.size);
+	const uint32_t groupsY = detail::div_up(desc.m, tile.size);
+	if (groupsX > impl.caps.maxGroupCountX || groupsY > impl.caps.maxGroupCountY)
+		throw std::runtime_error("FlowVk: gemm: matrix too large for one dispatch");
+
+	detail::Recorder recorder(impl);
+
+	// Batches beyond the Z group limit go into further dispatches of the same submission.
+	for (uint32_t offset = 0; offset < desc.batch; offset += impl.caps.maxGroupCountZ)
+	{
+		const uint32_t batches = std::min(desc.batch - offset, impl.caps.maxGroupCountZ);
+		const GemmPush push{
+			desc.m, desc.n, desc.k,
+			static_cast<uint32_t>(desc.layoutA),
+			static_cast<uint32_t>(desc.layoutB),
+			static_cast<uint32_t>(desc.layoutC),
+			offset, desc.alpha, desc.beta};
+		recorder.dispatch(kernel, {stateA.buffer, stateB.buffer, stateC.buffer}, push, groupsX, groupsY, batches);
+	}
+
+	recorder.submit();
+}
+
+} // namespace Flow::ops
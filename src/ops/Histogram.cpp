@@ -0,0 +1,149 @@
+#include "../../include/flowVk/ops/Histogram.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kHistogramU32[] =
+#include "histogram_u32.spv.inc"
+;
+static const uint32_t kHistogramI32[] =
+#include "histogram_i32.spv.inc"
+;
+static const uint32_t kHistogramF32[] =
+#include "histogram_f32.spv.inc"
+;
+
+struct HistogramPush {
+	uint32_t count;
+	uint32_t binCount;
+	uint32_t customEdges;
+	uint32_t lowerBits;
+	uint32_t upperBits;
+	float scale;
+};
+
+// Must match HIST_MODE in histogram.comp.
+static constexpr uint32_t kModeShared = 0;
+static constexpr uint32_t kModeKeys = 1;
+static constexpr uint32_t kModeCount = 2;
+
+// Above this many bins, clearing and merging the private copies costs more than sorting.
+static constexpr uint32_t kMaxSharedBins = 4096;
+static constexpr uint32_t kItemsPerThread = 16;
+
+static std::pair<const char*, std::span<const uint32_t>> histogram_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"histogram_u32", std::span<const uint32_t>(kHistogramU32)};
+		case ScalarType::I32: return {"histogram_i32", std::span<const uint32_t>(kHistogramI32)};
+		case ScalarType::F32: return {"histogram_f32", std::span<const uint32_t>(kHistogramF32)};
+		case ScalarType::U64: break;
+	}
+	throw std::runtime_error("FlowVk: histogram: unsupported element type");
+}
+
+// Shared array size for `binCount` bins; 0 when they do not fit.
+static uint32_t shared_bins(const InstanceImpl& impl, uint32_t binCount)
+{
+	const uint32_t size = std::bit_ceil(std::max(binCount, 1u));
+	if (size > kMaxSharedBins || size * sizeof(uint32_t) > impl.caps.maxSharedMemoryBytes)
+		return 0;
+	return size;
+}
+
+void detail::histogram(const Buffer& input, const Buffer& counts, const Buffer* edges, ScalarType type,
+                       uint32_t lowerBits, uint32_t upperBits, uint32_t binCount, HistogramAlgorithm algorithm)
+{
+	detail::require_same_owner(input, counts, "histogram");
+	auto& in = detail::buffer_state(input, "histogram");
+	auto& out = detail::buffer_state(counts, "histogram");
+	InstanceImpl& impl = *input.owner;
+
+	const std::size_t elementSize = scalar_size(type);
+	if (in.sizeBytes % elementSize != 0)
+		throw std::runtime_error("FlowVk: histogram: size of '" + input.name + "' is not a multiple of the element size");
+	const std::size_t count = in.sizeBytes / elementSize;
+	if (count > UINT32_MAX)
+		throw std::runtime_error("FlowVk: histogram: more than 2^32 elements in '" + input.name + "'");
+
+	const auto [variant, spirv] = histogram_variant(type);
+
+	VkBuffer edgeBuffer = in.buffer; // unread for uniform bins
+	float scale = 0.0f;
+	if (edges)
+	{
+		detail::require_same_owner(input, *edges, "histogram");
+		auto& edgeState = detail::buffer_state(*edges, "histogram");
+		if (edgeState.sizeBytes % elementSize != 0 || edgeState.sizeBytes / elementSize < 2)
+			throw std::runtime_error("FlowVk: histogram: edges '" + edges->name + "' must hold at least two elements");
+		if (edgeState.sizeBytes / elementSize - 1 > UINT32_MAX)
+			throw std::runtime_error("FlowVk: histogram: too many edges in '" + edges->name + "'");
+		binCount = static_cast<uint32_t>(edgeState.sizeBytes / elementSize - 1);
+		edgeBuffer = edgeState.buffer;
+	}
+	else if (type == ScalarType::F32)
+	{
+		const double lower = std::bit_cast<float>(lowerBits);
+		const double upper = std::bit_cast<float>(upperBits);
+		if (!(upper > lower))
+			throw std::runtime_error("FlowVk: histogram: upper edge must be above lower edge");
+		scale = static_cast<float>(binCount / (upper - lower));
+	}
+	else if (type == ScalarType::I32 ? std::bit_cast<int32_t>(upperBits) < std::bit_cast<int32_t>(lowerBits) : upperBits < lowerBits)
+		throw std::runtime_error("FlowVk: histogram: upper edge must not be below lower edge");
+
+	if (binCount == 0)
+		throw std::runtime_error("FlowVk: histogram: no bins");
+	if (out.sizeBytes < std::size_t(binCount) * sizeof(uint32_t))
+		throw std::runtime_error("FlowVk: histogram: '" + counts.name + "' is smaller than one uint32_t per bin");
+
+	const uint32_t sharedSize = shared_bins(impl, binCount);
+	bool useShared = (algorithm == HistogramAlgorithm::SharedAtomics) ||
+	                 (algorithm == HistogramAlgorithm::Auto && sharedSize != 0);
+	if (useShared && sharedSize == 0)
+		throw std::runtime_error("FlowVk: histogram: " + std::to_string(binCount) + " bins do not fit in shared memory");
+
+	const HistogramPush push{static_cast<uint32_t>(count), binCount, edges ? 1u : 0u, lowerBits, upperBits, scale};
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+
+	detail::Recorder recorder(impl);
+
+	if (useShared)
+	{
+		const auto& kernel = detail::get_builtin_kernel(impl, variant, spirv, 4, sizeof(HistogramPush),
+		                                                {groupSize, kModeShared, sharedSize});
+		// Enough workgroups to fill the device, few enough that each amortizes its bin merge.
+		const uint32_t groups = std::clamp(detail::div_up(count, std::size_t(groupSize) * kItemsPerThread), 1u, impl.caps.maxGroupCountX);
+
+		recorder.fill(out.buffer, 0, std::size_t(binCount) * sizeof(uint32_t), 0);
+		recorder.barrier();
+		recorder.dispatch(kernel, {in.buffer, edgeBuffer, out.buffer, out.buffer}, push, groups);
+		recorder.submit();
+		return;
+	}
+
+	const auto& keysKernel = detail::get_builtin_kernel(impl, variant, spirv, 4, sizeof(HistogramPush), {groupSize, kModeKeys, 1});
+	const auto& countKernel = detail::get_builtin_kernel(impl, variant, spirv, 4, sizeof(HistogramPush), {groupSize, kModeCount, 1});
+
+	// Out-of-range elements get key binCount, so only bit_width(binCount) bits need sorting.
+	const VkBuffer keys = recorder.scratch(std::max<std::size_t>(count, 1) * sizeof(uint32_t));
+	const detail::GroupCount elementGroups = detail::split_groups(impl, detail::div_up(count, groupSize));
+	const detail::GroupCount binGroups = detail::split_groups(impl, detail::div_up(binCount, groupSize));
+
+	recorder.dispatch(keysKernel, {in.buffer, edgeBuffer, out.buffer, keys}, push, elementGroups.x, elementGroups.y);
+	recorder.barrier();
+	detail::record_radix_sort(recorder, ScalarType::U32, keys, VK_NULL_HANDLE, static_cast<uint32_t>(count), 0,
+	                          static_cast<uint32_t>(std::bit_width(binCount)));
+	recorder.barrier();
+	recorder.dispatch(countKernel, {in.buffer, edgeBuffer, out.buffer, keys}, push, binGroups.x, binGroups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,167 @@
+#include "../../include/flowVk/ops/Layout.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kTranspose[] =
+#include "transpose.spv.inc"
+;
+static const uint32_t kAosSoa[] =
+#include "aos_soa.spv.inc"
+;
+
+struct TransposePush {
+	uint32_t rows;
+	uint32_t cols;
+};
+
+// Must match MAX_FIELDS and LAYOUT_MODE in aos_soa.comp.
+static constexpr uint32_t kMaxFields = 7;
+static constexpr uint32_t kModeToSoa = 0;
+static constexpr uint32_t kModeToAos = 1;
+
+struct AosSoaPush {
+	uint32_t count;
+	uint32_t strideWords;
+	uint32_t fieldCount;
+	uint32_t fields[kMaxFields];
+};
+
+// Largest staged row per dispatch; bigger fields do not fit a useful tile.
+static constexpr uint32_t kMaxRowWords = 1024;
+
+void transpose(const Buffer& input, const Buffer& output, uint32_t rows, uint32_t cols, std::size_t elementBytes, uint32_t batch)
+{
+	detail::require_same_owner(input, output, "transpose");
+	auto& in = detail::buffer_state(input, "transpose");
+	auto& out = detail::buffer_state(output, "transpose");
+	InstanceImpl& impl = *input.owner;
+
+	if (elementBytes != 4 && elementBytes != 8 && elementBytes != 16)
+		throw std::runtime_error("FlowVk: transpose: element size must be 4, 8 or 16 bytes");
+	if (&in == &out)
+		throw std::runtime_error("FlowVk: transpose: input and output must be different buffers");
+	const std::size_t bytes = std::size_t(rows) * cols * batch * elementBytes;
+	if (bytes / 4 > UINT32_MAX)
+		throw std::runtime_error("FlowVk: transpose: more than 2^32 words");
+	if (in.sizeBytes < bytes)
+		throw std::runtime_error("FlowVk: transpose: input '" + input.name + "' is smaller than the matrices");
+	if (out.sizeBytes < bytes)
+		throw std::runtime_error("FlowVk: transpose: output '" + output.name + "' is smaller than the matrices");
+	if (batch > impl.caps.maxGroupCountZ)
+		throw std::runtime_error("FlowVk: transpose: batch exceeds the device's Z group limit");
+	if (bytes == 0)
+		return;
+
+	// 32 x 32 tiles with 8 rows of invocations; 16-byte elements use 16 x 16 to stay within 16 KiB of shared memory.
+	const uint32_t words = static_cast<uint32_t>(elementBytes / 4);
+	const uint32_t tile = (words == 4) ? 16u : 32u;
+	const uint32_t tileRows = std::min(8u, impl.caps.maxWorkGroupInvocations / tile);
+	const uint32_t groupsX = detail::div_up(cols, tile);
+	const uint32_t groupsY = detail::div_up(rows, tile);
+	if (groupsX > impl.caps.maxGroupCountX || groupsY > impl.caps.maxGroupCountY)
+		throw std::runtime_error("FlowVk: transpose: matrix exceeds the device's X or Y group limit");
+	const auto& kernel = detail::get_builtin_kernel(impl, "transpose", kTranspose, 2, sizeof(TransposePush), {tile, tileRows, words});
+
+	detail::Recorder recorder(impl);
+	recorder.dispatch(kernel, {in.buffer, out.buffer}, TransposePush{rows, cols}, groupsX, groupsY, batch);
+	recorder.submit();
+}
+
+static void convert_layout(const Buffer& aos, uint32_t stride, std::span<const shader_meta::ElementField> layout,
+                           std::span<const Buffer> fields, uint32_t mode, const char* op)
+{
+	auto& aosState = detail::buffer_state(aos, op);
+	InstanceImpl& impl = *aos.owner;
+
+	auto fail = [&](const std::string& message) { return std::runtime_error(std::string("FlowVk: ") + op + ": " + message); };
+
+	if (stride == 0)
+		throw fail("element stride is 0 (FlowVk_ShaderPP could not lay out the element type)");
+	if (stride % 4 != 0)
+		throw fail("element stride must be a multiple of 4 bytes");
+	if (stride / 4 > 0xFFFF)
+		throw fail("elements larger than 256 KiB are not supported");
+	if (fields.size() > layout.size())
+		throw fail("more field buffers than fields in the layout");
+	const std::size_t count = aosState.sizeBytes / stride;
+	if (count > UINT32_MAX || std::size_t(count) * (stride / 4) > UINT32_MAX)
+		throw fail("more than 2^32 words in '" + aos.name + "'");
+
+	// Selected fields, batched into dispatches of at most kMaxFields fields and kMaxRowWords words.
+	struct Selected { VkBuffer buffer; uint32_t offsetWords; uint32_t sizeWords; };
+	std::vector<Selected> selected;
+	for (std::size_t i = 0; i < fields.size(); ++i)
+	{
+		if (!fields[i])
+			continue;
+		const shader_meta::ElementField& field = layout[i];
+		detail::require_same_owner(aos, fields[i], op);
+		auto& fieldState = detail::buffer_state(fields[i], op);
+		if (&fieldState == &aosState)
+			throw fail("field buffer '" + fields[i].name + "' aliases the struct buffer");
+		if (field.offset % 4 != 0 || field.size % 4 != 0)
+			throw fail("field '" + std::string(field.name) + "' is not made of 32-bit words");
+		if (field.size == 0 || field.offset + field.size > stride)
+			throw fail("field '" + std::string(field.name) + "' lies outside the element");
+		if (field.size / 4 > kMaxRowWords)
+			throw fail("field '" + std::string(field.name) + "' is larger than 4 KiB");
+		if (fieldState.sizeBytes < count * field.size)
+			throw fail("field buffer '" + fields[i].name + "' cannot hold " + std::to_string(count) + " elements");
+		selected.push_back({fieldState.buffer, field.offset / 4, field.size / 4});
+	}
+	if (count == 0 || selected.empty())
+		return;
+
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	detail::Recorder recorder(impl);
+
+	// Dispatches touch disjoint words, so they need no barriers between them.
+	for (std::size_t first = 0; first < selected.size();)
+	{
+		AosSoaPush push{static_cast<uint32_t>(count), stride / 4, 0, {}};
+		VkBuffer bindings[kMaxFields];
+		uint32_t rowWords = 0;
+		std::size_t next = first;
+		while (next < selected.size() && push.fieldCount < kMaxFields && rowWords + selected[next].sizeWords <= kMaxRowWords)
+		{
+			bindings[push.fieldCount] = selected[next].buffer;
+			push.fields[push.fieldCount++] = selected[next].offsetWords | (selected[next].sizeWords << 16);
+			rowWords += selected[next].sizeWords;
+			++next;
+		}
+		for (uint32_t f = push.fieldCount; f < kMaxFields; ++f)
+			bindings[f] = bindings[0]; // never touched past fieldCount
+
+		// Odd pitch keeps column walks conflict-free; the tile is as many structs as shared memory allows.
+		const uint32_t pitch = rowWords | 1u;
+		uint32_t tile = 64;
+		while (tile > 1 && std::size_t(tile) * pitch * sizeof(uint32_t) > impl.caps.maxSharedMemoryBytes)
+			tile /= 2;
+
+		const auto& kernel = detail::get_builtin_kernel(impl, "aos_soa", kAosSoa, 8, sizeof(AosSoaPush), {groupSize, mode, tile, pitch});
+		const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(count, tile));
+		recorder.dispatch(kernel, {aosState.buffer, bindings[0], bindings[1], bindings[2], bindings[3], bindings[4], bindings[5], bindings[6]},
+		                  push, groups.x, groups.y);
+		first = next;
+	}
+
+	recorder.submit();
+}
+
+void aos_to_soa(const Buffer& aos, uint32_t stride, std::span<const shader_meta::ElementField> layout, std::span<const Buffer> fields)
+{
+	convert_layout(aos, stride, layout, fields, kModeToSoa, "aos_to_soa");
+}
+
+void soa_to_aos(std::span<const Buffer> fields, uint32_t stride, std::span<const shader_meta::ElementField> layout, const Buffer& aos)
+{
+	convert_layout(aos, stride, layout, fields, kModeToAos, "soa_to_aos");
+}
+
+} // namespace Flow::ops
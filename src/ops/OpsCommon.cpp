@@ -0,0 +1,467 @@
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+
+namespace Flow::ops::detail {
+
+// ----- Helpers -----
+
+static void vkCheck(VkResult result, const char* msg)
+{
+	if (result != VK_SUCCESS)
+		throw std::runtime_error(std::string("FlowVk Vulkan error: ") + msg + " (VkResult=" + std::to_string((int)result) + ")");
+}
+
+static constexpr uint32_t kSetsPerPool = 64;
+static constexpr uint32_t kBindingsPerSet = 8;
+static constexpr std::size_t kScratchGranularity = 256;
+
+static VkBufferUsageFlags scratch_usage()
+{
+	return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+}
+
+static std::string variant_key(std::string_view variant, std::span<const uint32_t> specConstants)
+{
+	std::string key(variant);
+	for (uint32_t value : specConstants)
+		key += "/" + std::to_string(value);
+	return key;
+}
+
+// ----- Built-in kernels -----
+
+static void destroy_builtin_kernel(VkDevice device, const InstanceImpl::BuiltinKernelState& kernel)
+{
+	if (kernel.pipeline)		vkDestroyPipeline(device, kernel.pipeline, nullptr);
+	if (kernel.pipelineLayout)	vkDestroyPipelineLayout(device, kernel.pipelineLayout, nullptr);
+	if (kernel.setLayout)		vkDestroyDescriptorSetLayout(device, kernel.setLayout, nullptr);
+	if (kernel.shaderModule)	vkDestroyShaderModule(device, kernel.shaderModule, nullptr);
+}
+
+static void create_builtin_kernel(InstanceImpl& impl, InstanceImpl::BuiltinKernelState& kernel,
+                                  std::span<const uint32_t> spirv, std::span<const uint32_t> specConstants)
+{
+	const uint32_t bindingCount = kernel.bindingCount;
+	const uint32_t pushConstantBytes = kernel.pushConstantBytes;
+
+	std::vector<VkDescriptorSetLayoutBinding> layoutBindings(bindingCount);
+	for (uint32_t i = 0; i < bindingCount; ++i)
+	{
+		layoutBindings[i].binding = i;
+		layoutBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		layoutBindings[i].descriptorCount = 1;
+		layoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo{};
+	setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutCreateInfo.bindingCount = bindingCount;
+	setLayoutCreateInfo.pBindings = layoutBindings.empty() ? nullptr : layoutBindings.data();
+	vkCheck(vkCreateDescriptorSetLayout(impl.device, &setLayoutCreateInfo, nullptr, &kernel.setLayout), "vkCreateDescriptorSetLayout");
+
+	VkPushConstantRange pushRange{};
+	pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushRange.offset = 0;
+	pushRange.size = pushConstantBytes;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &kernel.setLayout;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantBytes ? 1u : 0u;
+	pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantBytes ? &pushRange : nullptr;
+	vkCheck(vkCreatePipelineLayout(impl.device, &pipelineLayoutCreateInfo, nullptr, &kernel.pipelineLayout), "vkCreatePipelineLayout");
+
+	VkShaderModuleCreateInfo shaderModule{};
+	shaderModule.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shaderModule.codeSize = spirv.size() * sizeof(uint32_t);
+	shaderModule.pCode = spirv.data();
+	vkCheck(vkCreateShaderModule(impl.device, &shaderModule, nullptr, &kernel.shaderModule), "vkCreateShaderModule");
+
+	const std::vector<uint32_t> specValues(specConstants.begin(), specConstants.end());
+	std::vector<VkSpecializationMapEntry> specEntries(specValues.size());
+	for (uint32_t i = 0; i < specEntries.size(); ++i)
+	{
+		specEntries[i].constantID = i;
+		specEntries[i].offset = i * sizeof(uint32_t);
+		specEntries[i].size = sizeof(uint32_t);
+	}
+
+	VkSpecializationInfo specInfo{};
+	specInfo.mapEntryCount = static_cast<uint32_t>(specEntries.size());
+	specInfo.pMapEntries = specEntries.empty() ? nullptr : specEntries.data();
+	specInfo.dataSize = specValues.size() * sizeof(uint32_t);
+	specInfo.pData = specValues.empty() ? nullptr : specValues.data();
+
+	VkPipelineShaderStageCreateInfo stage{};
+	stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	stage.module = kernel.shaderModule;
+	stage.pName = "main";
+	stage.pSpecializationInfo = specValues.empty() ? nullptr : &specInfo;
+
+	VkComputePipelineCreateInfo pipelineCreateInfo{};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stage = stage;
+	pipelineCreateInfo.layout = kernel.pipelineLayout;
+	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineCreateInfo.basePipelineIndex = -1;
+	vkCheck(vkCreateComputePipelines(impl.device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &kernel.pipeline), "vkCreateComputePipelines");
+}
+
+const InstanceImpl::BuiltinKernelState& get_builtin_kernel(
+	InstanceImpl& impl,
+	std::string_view variant,
+	std::span<const uint32_t> spirv,
+	uint32_t bindingCount,
+	uint32_t pushConstantBytes,
+	std::initializer_list<uint32_t> specConstants)
+{
+	return get_builtin_kernel(impl, variant, spirv, bindingCount, pushConstantBytes,
+	                          std::span<const uint32_t>(specConstants.begin(), specConstants.size()));
+}
+
+const InstanceImpl::BuiltinKernelState& get_builtin_kernel(
+	InstanceImpl& impl,
+	std::string_view variant,
+	std::span<const uint32_t> spirv,
+	uint32_t bindingCount,
+	uint32_t pushConstantBytes,
+	std::span<const uint32_t> specConstants)
+{
+	const std::string key = variant_key(variant, specConstants);
+	if (auto it = impl.builtinKernels.find(key); it != impl.builtinKernels.end())
+		return it->second;
+
+	if (bindingCount > kBindingsPerSet)
+		throw std::runtime_error("FlowVk: built-in kernel has too many bindings: " + key);
+	if (pushConstantBytes > impl.caps.maxPushConstantBytes)
+		throw std::runtime_error("FlowVk: built-in kernel push constants exceed device limit: " + key);
+
+	InstanceImpl::BuiltinKernelState kernel{};
+	kernel.bindingCount = bindingCount;
+	kernel.pushConstantBytes = pushConstantBytes;
+
+	// Cached only once the pipeline exists; a failure half way destroys what was created,
+	// so the next call retries instead of finding null handles.
+	try
+	{
+		create_builtin_kernel(impl, kernel, spirv, specConstants);
+	}
+	catch (...)
+	{
+		destroy_builtin_kernel(impl.device, kernel);
+		throw;
+	}
+	return impl.builtinKernels.emplace(key, kernel).first->second;
+}
+
+uint32_t workgroup_size(const InstanceImpl& impl, uint32_t preferred)
+{
+	return std::bit_floor(std::max(1u, std::min(preferred, impl.caps.maxWorkGroupInvocations)));
+}
+
+GroupCount split_groups(const InstanceImpl& impl, uint32_t groups)
+{
+	GroupCount count{};
+	count.x = std::max(1u, std::min(groups, impl.caps.maxGroupCountX));
+	count.y = div_up(groups, count.x);
+	return count;
+}
+
+// ----- Buffers -----
+
+InstanceImpl::BufferState& buffer_state(const Buffer& buffer, const char* op)
+{
+	if (!buffer.owner)
+		throw std::runtime_error(std::string("FlowVk: ") + op + " on empty Buffer");
+	auto it = buffer.owner->buffers.find(buffer.name);
+	if (it == buffer.owner->buffers.end())
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": unknown buffer name: " + buffer.name);
+	if (!it->second.buffer)
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": buffer '" + buffer.name + "' not allocated");
+	return it->second;
+}
+
+void require_same_owner(const Buffer& a, const Buffer& b, const char* op)
+{
+	if (a.owner != b.owner)
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": buffers '" + a.name + "' and '" + b.name + "' belong to different instances");
+}
+
+// ----- Scratch -----
+
+Scratch::Scratch(InstanceImpl& impl, std::size_t bytes, ScratchKind kind) : owner(&impl)
+{
+	const bool readback = (kind == ScratchKind::Readback);
+	bytes = std::max<std::size_t>(bytes, 1);
+
+	// Best fit from the free list; scratch is recycled, never shrunk.
+	auto best = impl.freeScratch.end();
+	for (auto it = impl.freeScratch.begin(); it != impl.freeScratch.end(); ++it)
+	{
+		if ((it->mapped != nullptr) != readback || it->sizeBytes < bytes)
+			continue;
+		if (best == impl.freeScratch.end() || it->sizeBytes < best->sizeBytes)
+			best = it;
+	}
+	if (best != impl.freeScratch.end())
+	{
+		buffer = *best;
+		impl.freeScratch.erase(best);
+		return;
+	}
+
+	const std::size_t rounded = std::max(kScratchGranularity, std::bit_ceil(bytes));
+
+	VkBufferCreateInfo bufferCreateInfo{};
+	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCreateInfo.size = rounded;
+	bufferCreateInfo.usage = scratch_usage();
+	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VmaAllocationCreateInfo allocationCreateInfo{};
+	if (readback)
+	{
+		allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+		allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+		                             VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	}
+	else
+		allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+	VmaAllocationInfo allocationInfo{};
+	VkResult r = vmaCreateBuffer(impl.allocator, &bufferCreateInfo, &allocationCreateInfo, &buffer.buffer, &buffer.allocation, &allocationInfo);
+	vkCheck(r, "vmaCreateBuffer(scratch)");
+	buffer.sizeBytes = rounded;
+	buffer.mapped = readback ? allocationInfo.pMappedData : nullptr;
+}
+
+Scratch::Scratch(Scratch&& other) noexcept : owner(other.owner), buffer(other.buffer)
+{
+	other.owner = nullptr;
+	other.buffer = {};
+}
+
+Scratch& Scratch::operator=(Scratch&& other) noexcept
+{
+	if (this != &other)
+	{
+		this->~Scratch();
+		owner = other.owner;
+		buffer = other.buffer;
+		other.owner = nullptr;
+		other.buffer = {};
+	}
+	return *this;
+}
+
+Scratch::~Scratch()
+{
+	if (owner && buffer.buffer)
+		owner->freeScratch.push_back(buffer);
+	owner = nullptr;
+	buffer = {};
+}
+
+void Scratch::read(void* out, std::size_t bytes) const
+{
+	if (!buffer.mapped)
+		throw std::runtime_error("FlowVk: read from non-readback scratch");
+	if (bytes > buffer.sizeBytes)
+		throw std::runtime_error("FlowVk: scratch read exceeds size");
+	vkCheck(vmaInvalidateAllocation(owner->allocator, buffer.allocation, 0, bytes), "vmaInvalidateAllocation");
+	std::memcpy(out, buffer.mapped, bytes);
+}
+
+// ----- Recording -----
+
+Recorder::~Recorder()
+{
+	for (auto pool : pools)
+		vkDestroyDescriptorPool(impl.device, pool, nullptr);
+}
+
+VkDescriptorSet Recorder::allocate_set(VkDescriptorSetLayout layout)
+{
+	if (setsLeft == 0)
+	{
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSize.descriptorCount = kSetsPerPool * kBindingsPerSet;
+
+		VkDescriptorPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCreateInfo.maxSets = kSetsPerPool;
+		poolCreateInfo.poolSizeCount = 1;
+		poolCreateInfo.pPoolSizes = &poolSize;
+
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		vkCheck(vkCreateDescriptorPool(impl.device, &poolCreateInfo, nullptr, &pool), "vkCreateDescriptorPool");
+		pools.push_back(pool);
+		setsLeft = kSetsPerPool;
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = pools.back();
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	vkCheck(vkAllocateDescriptorSets(impl.device, &allocInfo, &set), "vkAllocateDescriptorSets");
+	--setsLeft;
+	return set;
+}
+
+void Recorder::dispatch(const InstanceImpl::BuiltinKernelState& kernel,
+                        std::initializer_list<VkBuffer> bindings,
+                        const void* push, uint32_t pushBytes,
+                        uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	if (bindings.size() != kernel.bindingCount)
+		throw std::runtime_error("FlowVk: built-in kernel binding count mismatch");
+	if (pushBytes != kernel.pushConstantBytes)
+		throw std::runtime_error("FlowVk: built-in kernel push constant size mismatch");
+	if (groupCountX == 0 || groupCountY == 0 || groupCountZ == 0)
+		return;
+
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	if (kernel.bindingCount > 0)
+	{
+		set = allocate_set(kernel.setLayout);
+
+		std::array<VkDescriptorBufferInfo, kBindingsPerSet> bufferInfos{};
+		std::array<VkWriteDescriptorSet, kBindingsPerSet> writes{};
+		uint32_t binding = 0;
+		for (VkBuffer buffer : bindings)
+		{
+			bufferInfos[binding].buffer = buffer;
+			bufferInfos[binding].offset = 0;
+			bufferInfos[binding].range = VK_WHOLE_SIZE;
+
+			writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[binding].dstSet = set;
+			writes[binding].dstBinding = binding;
+			writes[binding].dstArrayElement = 0;
+			writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[binding].descriptorCount = 1;
+			writes[binding].pBufferInfo = &bufferInfos[binding];
+			++binding;
+		}
+		vkUpdateDescriptorSets(impl.device, binding, writes.data(), 0, nullptr);
+	}
+
+	std::array<uint8_t, 128> pushData{};
+	if (pushBytes > pushData.size())
+		throw std::runtime_error("FlowVk: built-in kernel push constants too large");
+	if (pushBytes)
+		std::memcpy(pushData.data(), push, pushBytes);
+
+	const VkPipeline pipeline = kernel.pipeline;
+	const VkPipelineLayout layout = kernel.pipelineLayout;
+
+	commands.push_back([=](VkCommandBuffer cmd) {
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		if (set)
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+		if (pushBytes)
+			vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushBytes, pushData.data());
+		vkCmdDispatch(cmd, groupCountX, groupCountY, groupCountZ);
+	});
+}
+
+VkBuffer Recorder::scratch(std::size_t bytes)
+{
+	scratchBuffers.emplace_back(impl, bytes, ScratchKind::Device);
+	return scratchBuffers.back().handle();
+}
+
+void Recorder::fill(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t value)
+{
+	commands.push_back([=](VkCommandBuffer cmd) {
+		vkCmdFillBuffer(cmd, buffer, offset, size, value);
+	});
+}
+
+void Recorder::copy(VkBuffer src, VkBuffer dst, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size)
+{
+	commands.push_back([=](VkCommandBuffer cmd) {
+		VkBufferCopy region{};
+		region.srcOffset = srcOffset;
+		region.dstOffset = dstOffset;
+		region.size = size;
+		vkCmdCopyBuffer(cmd, src, dst, 1, &region);
+	});
+}
+
+void Recorder::update(VkBuffer buffer, VkDeviceSize offset, const void* data, std::size_t bytes)
+{
+	if (bytes == 0)
+		return;
+	if (bytes > 65536 || bytes % 4 != 0)
+		throw std::runtime_error("FlowVk: inline buffer update must be a multiple of 4 bytes up to 64 KiB");
+
+	const auto* first = static_cast<const uint8_t*>(data);
+	std::vector<uint8_t> copy(first, first + bytes);
+	commands.push_back([=, copy = std::move(copy)](VkCommandBuffer cmd) {
+		vkCmdUpdateBuffer(cmd, buffer, offset, copy.size(), copy.data());
+	});
+}
+
+void Recorder::barrier()
+{
+	commands.push_back([](VkCommandBuffer cmd) {
+		VkMemoryBarrier memBarrier{};
+		memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		memBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+		                           VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			1, &memBarrier,
+			0, nullptr,
+			0, nullptr
+		);
+	});
+}
+
+void Recorder::submit()
+{
+	if (commands.empty())
+		return;
+
+	impl.submit_one_time([&](VkCommandBuffer cmd) {
+		for (auto& command : commands)
+			command(cmd);
+
+		VkMemoryBarrier memBarrier{};
+		memBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		memBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT,
+			0,
+			1, &memBarrier,
+			0, nullptr,
+			0, nullptr
+		);
+	});
+	commands.clear();
+}
+
+} // namespace Flow::ops::detail
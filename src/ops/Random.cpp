@@ -0,0 +1,91 @@
+#include "../../include/flowVk/ops/Random.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kRandomU32[] =
+#include "random_u32.spv.inc"
+;
+static const uint32_t kRandomI32[] =
+#include "random_i32.spv.inc"
+;
+static const uint32_t kRandomF32[] =
+#include "random_f32.spv.inc"
+;
+static const uint32_t kRandomU64[] =
+#include "random_u64.spv.inc"
+;
+
+struct RandomPush {
+	uint32_t count;
+	uint32_t skip;
+	uint32_t blockLo;
+	uint32_t blockHi;
+	uint32_t seedLo;
+	uint32_t seedHi;
+	uint32_t distribution;
+	float scale;
+	float bias;
+};
+
+static std::pair<const char*, std::span<const uint32_t>> random_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"random_u32", std::span<const uint32_t>(kRandomU32)};
+		case ScalarType::I32: return {"random_i32", std::span<const uint32_t>(kRandomI32)};
+		case ScalarType::F32: return {"random_f32", std::span<const uint32_t>(kRandomF32)};
+		case ScalarType::U64: return {"random_u64", std::span<const uint32_t>(kRandomU64)};
+	}
+	throw std::runtime_error("FlowVk: random: unsupported element type");
+}
+
+void detail::random(const Buffer& buffer, ScalarType type, const RandomDesc& desc)
+{
+	auto& state = detail::buffer_state(buffer, "random");
+	InstanceImpl& impl = *buffer.owner;
+
+	const std::size_t elementSize = scalar_size(type);
+	if (state.sizeBytes % elementSize != 0)
+		throw std::runtime_error("FlowVk: random: size of '" + buffer.name + "' is not a multiple of the element size");
+	const std::size_t count = state.sizeBytes / elementSize;
+	if (count > UINT32_MAX - 4)
+		throw std::runtime_error("FlowVk: random: more than 2^32 - 4 elements in '" + buffer.name + "'");
+	if (type == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: random: 64-bit elements require shaderInt64");
+	if (desc.distribution == Distribution::Normal && type != ScalarType::F32)
+		throw std::runtime_error("FlowVk: random: normal values need float elements");
+	if (count == 0)
+		return;
+
+	// Must match PER_BLOCK in random.comp: one Philox block yields four words.
+	const uint32_t perBlock = (type == ScalarType::U64) ? 2u : 4u;
+	const uint64_t firstBlock = desc.offset / perBlock;
+	const uint32_t skip = static_cast<uint32_t>(desc.offset % perBlock);
+	const bool normal = desc.distribution == Distribution::Normal;
+
+	const RandomPush push{
+		static_cast<uint32_t>(count), skip,
+		static_cast<uint32_t>(firstBlock), static_cast<uint32_t>(firstBlock >> 32),
+		static_cast<uint32_t>(desc.seed), static_cast<uint32_t>(desc.seed >> 32),
+		static_cast<uint32_t>(desc.distribution),
+		normal ? desc.stddev : desc.upper - desc.lower,
+		normal ? desc.mean : desc.lower,
+	};
+
+	const auto [variant, spirv] = random_variant(type);
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const auto& kernel = detail::get_builtin_kernel(impl, variant, spirv, 1, sizeof(RandomPush), {groupSize});
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(detail::div_up(count + skip, perBlock), groupSize));
+
+	detail::Recorder recorder(impl);
+	recorder.dispatch(kernel, {state.buffer}, push, groups.x, groups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
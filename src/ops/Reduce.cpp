@@ -0,0 +1,128 @@
+#include "../../include/flowVk/ops/Reduce.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kReduceU32[] =
+#include "reduce_u32.spv.inc"
+;
+static const uint32_t kReduceU32Subgroup[] =
+#include "reduce_u32_sg.spv.inc"
+;
+static const uint32_t kReduceI32[] =
+#include "reduce_i32.spv.inc"
+;
+static const uint32_t kReduceI32Subgroup[] =
+#include "reduce_i32_sg.spv.inc"
+;
+static const uint32_t kReduceF32[] =
+#include "reduce_f32.spv.inc"
+;
+static const uint32_t kReduceF32Subgroup[] =
+#include "reduce_f32_sg.spv.inc"
+;
+static const uint32_t kReduceU64[] =
+#include "reduce_u64.spv.inc"
+;
+
+struct ReducePush {
+	uint32_t count;
+	uint32_t hasIndices;
+};
+
+static constexpr uint32_t kItemsPerThread = 4;
+static constexpr uint32_t kMaxPartials = 1024;
+
+// 64-bit subgroup arithmetic needs shaderSubgroupExtendedTypes; U64 always takes the shared-memory path.
+static std::pair<const char*, std::span<const uint32_t>> reduce_variant(ScalarType type, bool subgroup)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return subgroup ? std::pair{"reduce_u32_sg", std::span<const uint32_t>(kReduceU32Subgroup)} : std::pair{"reduce_u32", std::span<const uint32_t>(kReduceU32)};
+		case ScalarType::I32: return subgroup ? std::pair{"reduce_i32_sg", std::span<const uint32_t>(kReduceI32Subgroup)} : std::pair{"reduce_i32", std::span<const uint32_t>(kReduceI32)};
+		case ScalarType::F32: return subgroup ? std::pair{"reduce_f32_sg", std::span<const uint32_t>(kReduceF32Subgroup)} : std::pair{"reduce_f32", std::span<const uint32_t>(kReduceF32)};
+		case ScalarType::U64: return {"reduce_u64", std::span<const uint32_t>(kReduceU64)};
+	}
+	throw std::runtime_error("FlowVk: reduce: unsupported scalar type");
+}
+
+void detail::reduce(const Buffer& input, ScalarType type, ReduceOp op, void* outValue, uint32_t* outIndex)
+{
+	auto& state = detail::buffer_state(input, "reduce");
+	InstanceImpl& impl = *input.owner;
+
+	const std::size_t elementSize = scalar_size(type);
+	if (state.sizeBytes % elementSize != 0)
+		throw std::runtime_error("FlowVk: reduce: size of '" + input.name + "' is not a multiple of the element size");
+	const std::size_t count = state.sizeBytes / elementSize;
+	if (count > UINT32_MAX)
+		throw std::runtime_error("FlowVk: reduce: more than 2^32 elements in '" + input.name + "'");
+	if (type == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: reduce: 64-bit elements require shaderInt64");
+
+	*outIndex = 0;
+	if (count == 0)
+	{
+		if (op != ReduceOp::Sum)
+			throw std::runtime_error("FlowVk: reduce: min/max of empty buffer '" + input.name + "'");
+		std::memset(outValue, 0, elementSize);
+		return;
+	}
+
+	const bool subgroup = impl.caps.subgroupArithmetic && type != ScalarType::U64;
+	const auto [variant, spirv] = reduce_variant(type, subgroup);
+	const uint32_t groupSize = detail::workgroup_size(impl);
+	const auto& kernel = detail::get_builtin_kernel(impl, variant, spirv, 4, sizeof(ReducePush),
+	                                                {groupSize, static_cast<uint32_t>(op)});
+
+	const uint32_t perGroup = groupSize * kItemsPerThread;
+	const uint32_t maxGroups = std::min(kMaxPartials, impl.caps.maxGroupCountX);
+	const uint32_t firstGroups = std::min(detail::div_up(count, perGroup), maxGroups);
+
+	detail::Scratch resultValue(impl, elementSize, detail::ScratchKind::Readback);
+	detail::Scratch resultIndex(impl, sizeof(uint32_t), detail::ScratchKind::Readback);
+	detail::Recorder recorder(impl);
+
+	// Partials ping-pong between two scratch pairs; the last pass lands in readback memory.
+	const VkBuffer values[2] = {recorder.scratch(firstGroups * elementSize), recorder.scratch(firstGroups * elementSize)};
+	const VkBuffer indices[2] = {recorder.scratch(firstGroups * sizeof(uint32_t)), recorder.scratch(firstGroups * sizeof(uint32_t))};
+
+	VkBuffer inValues = state.buffer;
+	VkBuffer inIndices = state.buffer; // unread on the first pass
+	uint32_t remaining = static_cast<uint32_t>(count);
+	uint32_t hasIndices = 0;
+	int ping = 0;
+
+	while (true)
+	{
+		const uint32_t groups = std::min(detail::div_up(remaining, perGroup), maxGroups);
+		const bool last = (groups == 1);
+		const VkBuffer outValues = last ? resultValue.handle() : values[ping];
+		const VkBuffer outIndices = last ? resultIndex.handle() : indices[ping];
+
+		recorder.dispatch(kernel, {inValues, inIndices, outValues, outIndices}, ReducePush{remaining, hasIndices}, groups);
+		if (last)
+			break;
+
+		recorder.barrier();
+		inValues = outValues;
+		inIndices = outIndices;
+		remaining = groups;
+		hasIndices = 1;
+		ping ^= 1;
+	}
+
+	recorder.submit();
+
+	resultValue.read(outValue, elementSize);
+	if (op == ReduceOp::ArgMin || op == ReduceOp::ArgMax)
+		resultIndex.read(outIndex, sizeof(uint32_t));
+}
+
+} // namespace Flow::ops
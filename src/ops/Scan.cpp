@@ -0,0 +1,148 @@
+#include "../../include/flowVk/ops/Scan.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kScanU32[] =
+#include "scan_u32.spv.inc"
+;
+static const uint32_t kScanU32Subgroup[] =
+#include "scan_u32_sg.spv.inc"
+;
+static const uint32_t kScanI32[] =
+#include "scan_i32.spv.inc"
+;
+static const uint32_t kScanI32Subgroup[] =
+#include "scan_i32_sg.spv.inc"
+;
+static const uint32_t kScanF32[] =
+#include "scan_f32.spv.inc"
+;
+static const uint32_t kScanF32Subgroup[] =
+#include "scan_f32_sg.spv.inc"
+;
+static const uint32_t kScanU64[] =
+#include "scan_u64.spv.inc"
+;
+
+struct ScanPush {
+	uint32_t count;
+	uint32_t inclusive;
+	uint32_t tileCount;
+};
+
+// Must match SCAN_MODE and ITEMS_PER_THREAD in scan.comp.
+static constexpr uint32_t kModeLookback = 0;
+static constexpr uint32_t kModeTileReduce = 1;
+static constexpr uint32_t kModeTileScan = 2;
+
+static uint32_t items_per_thread(ScalarType type)
+{
+	return type == ScalarType::U64 ? 4u : 8u;
+}
+
+static std::pair<const char*, std::span<const uint32_t>> scan_variant(ScalarType type, bool subgroup)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return subgroup ? std::pair{"scan_u32_sg", std::span<const uint32_t>(kScanU32Subgroup)} : std::pair{"scan_u32", std::span<const uint32_t>(kScanU32)};
+		case ScalarType::I32: return subgroup ? std::pair{"scan_i32_sg", std::span<const uint32_t>(kScanI32Subgroup)} : std::pair{"scan_i32", std::span<const uint32_t>(kScanI32)};
+		case ScalarType::F32: return subgroup ? std::pair{"scan_f32_sg", std::span<const uint32_t>(kScanF32Subgroup)} : std::pair{"scan_f32", std::span<const uint32_t>(kScanF32)};
+		case ScalarType::U64: return {"scan_u64", std::span<const uint32_t>(kScanU64)};
+	}
+	throw std::runtime_error("FlowVk: scan: unsupported scalar type");
+}
+
+bool detail::supports_lookback(const InstanceImpl& impl)
+{
+	switch (impl.caps.vendorID)
+	{
+		case 0x10DE: // NVIDIA
+		case 0x1002: // AMD
+		case 0x8086: // Intel
+			return true;
+		default:
+			return false;
+	}
+}
+
+void detail::record_scan(Recorder& recorder, ScalarType type, VkBuffer input, VkBuffer output,
+                         uint32_t count, bool inclusive, bool lookback)
+{
+	if (count == 0)
+		return;
+
+	InstanceImpl& impl = recorder.impl;
+	const bool subgroup = impl.caps.subgroupArithmetic && type != ScalarType::U64;
+	const auto [variant, spirv] = scan_variant(type, subgroup);
+	const uint32_t groupSize = workgroup_size(impl, 256);
+	const uint32_t tiles = div_up(count, groupSize * items_per_thread(type));
+	const GroupCount groups = split_groups(impl, tiles);
+	const std::size_t elementSize = scalar_size(type);
+	const ScanPush push{count, inclusive ? 1u : 0u, tiles};
+
+	auto kernel = [&](uint32_t mode) -> const InstanceImpl::BuiltinKernelState& {
+		return get_builtin_kernel(impl, variant, spirv, 5, sizeof(ScanPush), {groupSize, mode});
+	};
+
+	// Unused bindings are pointed at `input`; the selected mode never touches them.
+	if (tiles == 1)
+	{
+		recorder.dispatch(kernel(kModeTileScan), {input, output, input, input, input}, push, 1);
+		return;
+	}
+
+	if (lookback)
+	{
+		const VkBuffer state = recorder.scratch((1 + std::size_t(tiles)) * sizeof(uint32_t));
+		const VkBuffer aggregates = recorder.scratch(tiles * elementSize);
+		const VkBuffer prefixes = recorder.scratch(tiles * elementSize);
+
+		recorder.fill(state, 0, VK_WHOLE_SIZE, 0);
+		recorder.barrier();
+		recorder.dispatch(kernel(kModeLookback), {input, output, state, aggregates, prefixes}, push, groups.x, groups.y);
+		return;
+	}
+
+	const VkBuffer sums = recorder.scratch(tiles * elementSize);
+	const VkBuffer offsets = recorder.scratch(tiles * elementSize);
+
+	recorder.dispatch(kernel(kModeTileReduce), {input, output, input, sums, input}, push, groups.x, groups.y);
+	recorder.barrier();
+	record_scan(recorder, type, sums, offsets, tiles, false, false);
+	recorder.barrier();
+	recorder.dispatch(kernel(kModeTileScan), {input, output, input, input, offsets}, push, groups.x, groups.y);
+}
+
+void detail::scan(const Buffer& input, const Buffer& output, ScalarType type, ScanKind kind, ScanAlgorithm algorithm)
+{
+	detail::require_same_owner(input, output, "scan");
+	auto& in = detail::buffer_state(input, "scan");
+	auto& out = detail::buffer_state(output, "scan");
+	InstanceImpl& impl = *input.owner;
+
+	const std::size_t elementSize = scalar_size(type);
+	if (in.sizeBytes % elementSize != 0)
+		throw std::runtime_error("FlowVk: scan: size of '" + input.name + "' is not a multiple of the element size");
+	const std::size_t count = in.sizeBytes / elementSize;
+	if (count > UINT32_MAX)
+		throw std::runtime_error("FlowVk: scan: more than 2^32 elements in '" + input.name + "'");
+	if (out.sizeBytes < in.sizeBytes)
+		throw std::runtime_error("FlowVk: scan: output '" + output.name + "' is smaller than input '" + input.name + "'");
+	if (type == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: scan: 64-bit elements require shaderInt64");
+
+	const bool lookback = (algorithm == ScanAlgorithm::DecoupledLookback) ||
+	                      (algorithm == ScanAlgorithm::Auto && detail::supports_lookback(impl));
+
+	detail::Recorder recorder(impl);
+	detail::record_scan(recorder, type, in.buffer, out.buffer, static_cast<uint32_t>(count), kind == ScanKind::Inclusive, lookback);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
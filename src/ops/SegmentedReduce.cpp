@@ -0,0 +1,182 @@
+#include "../../include/flowVk/ops/SegmentedReduce.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kSegmentedReduceU32[] =
+#include "segmented_reduce_u32.spv.inc"
+;
+static const uint32_t kSegmentedReduceI32[] =
+#include "segmented_reduce_i32.spv.inc"
+;
+static const uint32_t kSegmentedReduceF32[] =
+#include "segmented_reduce_f32.spv.inc"
+;
+static const uint32_t kSegmentedReduceU64[] =
+#include "segmented_reduce_u64.spv.inc"
+;
+static const uint32_t kKeyRuns[] =
+#include "key_runs.spv.inc"
+;
+
+struct SegmentedPush {
+	uint32_t count;
+	uint32_t segments;
+	uint32_t deviceSegments;
+	uint32_t itemsPerThread;
+	uint32_t threads;
+};
+
+struct KeyRunsPush {
+	uint32_t count;
+	uint32_t indirectGroupSize;
+};
+
+// Must match SEG_MODE in segmented_reduce.comp and RUNS_MODE in key_runs.comp.
+static constexpr uint32_t kModeMerge = 0;
+static constexpr uint32_t kModeFixup = 1;
+static constexpr uint32_t kModeHeads = 0;
+static constexpr uint32_t kModeRuns = 1;
+
+static constexpr uint32_t kItemsPerThread = 16;
+
+static std::pair<const char*, std::span<const uint32_t>> segmented_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"segmented_reduce_u32", std::span<const uint32_t>(kSegmentedReduceU32)};
+		case ScalarType::I32: return {"segmented_reduce_i32", std::span<const uint32_t>(kSegmentedReduceI32)};
+		case ScalarType::F32: return {"segmented_reduce_f32", std::span<const uint32_t>(kSegmentedReduceF32)};
+		case ScalarType::U64: return {"segmented_reduce_u64", std::span<const uint32_t>(kSegmentedReduceU64)};
+	}
+	throw std::runtime_error("FlowVk: segmented_reduce: unsupported element type");
+}
+
+static uint32_t value_count(const Buffer& values, const InstanceImpl::BufferState& state, ScalarType type,
+                            ReduceOp op, const InstanceImpl& impl, const char* name)
+{
+	const std::size_t elementSize = scalar_size(type);
+	if (state.sizeBytes % elementSize != 0)
+		throw std::runtime_error(std::string("FlowVk: ") + name + ": size of '" + values.name + "' is not a multiple of the element size");
+	const std::size_t count = state.sizeBytes / elementSize;
+	if (count > UINT32_MAX / 2)
+		throw std::runtime_error(std::string("FlowVk: ") + name + ": more than 2^31 elements in '" + values.name + "'");
+	if (type == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error(std::string("FlowVk: ") + name + ": 64-bit elements require shaderInt64");
+	if (op != ReduceOp::Sum && op != ReduceOp::Min && op != ReduceOp::Max)
+		throw std::runtime_error(std::string("FlowVk: ") + name + ": only Sum, Min and Max are supported");
+	return static_cast<uint32_t>(count);
+}
+
+// Merge path over `maxSegments` + `count` items, then the carry fixup. With a device
+// segment count, invocations past the real item count only publish empty carries.
+static void record_segmented(detail::Recorder& recorder, ScalarType type, ReduceOp op,
+                             VkBuffer offsets, VkBuffer values, VkBuffer output, VkBuffer counts,
+                             uint32_t count, uint32_t maxSegments, bool deviceSegments)
+{
+	InstanceImpl& impl = recorder.impl;
+	const auto [variant, spirv] = segmented_variant(type);
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const uint32_t threads = detail::div_up(std::size_t(count) + maxSegments, kItemsPerThread);
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(threads, groupSize));
+
+	const auto& mergeKernel = detail::get_builtin_kernel(impl, variant, spirv, 6, sizeof(SegmentedPush), {groupSize, kModeMerge, static_cast<uint32_t>(op)});
+	const auto& fixupKernel = detail::get_builtin_kernel(impl, variant, spirv, 6, sizeof(SegmentedPush), {groupSize, kModeFixup, static_cast<uint32_t>(op)});
+
+	const SegmentedPush push{count, maxSegments, deviceSegments ? 1u : 0u, kItemsPerThread, threads};
+	const VkBuffer carryRows = recorder.scratch(std::size_t(threads) * sizeof(uint32_t));
+	const VkBuffer carryValues = recorder.scratch(std::size_t(threads) * scalar_size(type));
+
+	recorder.dispatch(mergeKernel, {offsets, values, output, counts, carryRows, carryValues}, push, groups.x, groups.y);
+	recorder.barrier();
+	recorder.dispatch(fixupKernel, {offsets, values, output, counts, carryRows, carryValues}, push, groups.x, groups.y);
+}
+
+void detail::segmented_reduce(const Buffer& values, const Buffer& offsets, const Buffer& output, ScalarType type, ReduceOp op)
+{
+	detail::require_same_owner(values, offsets, "segmented_reduce");
+	detail::require_same_owner(values, output, "segmented_reduce");
+	auto& in = detail::buffer_state(values, "segmented_reduce");
+	auto& offsetState = detail::buffer_state(offsets, "segmented_reduce");
+	auto& out = detail::buffer_state(output, "segmented_reduce");
+	InstanceImpl& impl = *values.owner;
+
+	const uint32_t count = value_count(values, in, type, op, impl, "segmented_reduce");
+	if (offsetState.sizeBytes % sizeof(uint32_t) != 0 || offsetState.sizeBytes < sizeof(uint32_t))
+		throw std::runtime_error("FlowVk: segmented_reduce: offsets '" + offsets.name + "' must hold segments + 1 uint32_t");
+	const std::size_t segments = offsetState.sizeBytes / sizeof(uint32_t) - 1;
+	if (segments > UINT32_MAX / 2)
+		throw std::runtime_error("FlowVk: segmented_reduce: too many segments in '" + offsets.name + "'");
+	if (out.sizeBytes < segments * scalar_size(type))
+		throw std::runtime_error("FlowVk: segmented_reduce: output '" + output.name + "' holds fewer than one element per segment");
+	if (segments == 0)
+		return;
+
+	detail::Recorder recorder(impl);
+	record_segmented(recorder, type, op, offsetState.buffer, in.buffer, out.buffer, offsetState.buffer,
+	                 count, static_cast<uint32_t>(segments), false);
+	recorder.submit();
+}
+
+void detail::reduce_by_key(const Buffer& keys, const Buffer& values, const Buffer& keysOut, const Buffer& valuesOut,
+                           const Buffer& count, ScalarType type, ReduceOp op, uint32_t indirectGroupSize)
+{
+	for (const Buffer* other : {&values, &keysOut, &valuesOut, &count})
+		detail::require_same_owner(keys, *other, "reduce_by_key");
+	auto& keyState = detail::buffer_state(keys, "reduce_by_key");
+	auto& valueState = detail::buffer_state(values, "reduce_by_key");
+	auto& keysOutState = detail::buffer_state(keysOut, "reduce_by_key");
+	auto& valuesOutState = detail::buffer_state(valuesOut, "reduce_by_key");
+	auto& countState = detail::buffer_state(count, "reduce_by_key");
+	InstanceImpl& impl = *keys.owner;
+
+	const uint32_t elements = value_count(values, valueState, type, op, impl, "reduce_by_key");
+	if (keyState.sizeBytes < std::size_t(elements) * sizeof(uint32_t))
+		throw std::runtime_error("FlowVk: reduce_by_key: keys '" + keys.name + "' hold fewer than one uint32_t per value");
+	if (keysOutState.sizeBytes < std::size_t(elements) * sizeof(uint32_t))
+		throw std::runtime_error("FlowVk: reduce_by_key: '" + keysOut.name + "' cannot hold one key per value");
+	if (valuesOutState.sizeBytes < valueState.sizeBytes)
+		throw std::runtime_error("FlowVk: reduce_by_key: '" + valuesOut.name + "' is smaller than '" + values.name + "'");
+	if (countState.sizeBytes < sizeof(CompactCount))
+		throw std::runtime_error("FlowVk: reduce_by_key: count buffer '" + count.name + "' is smaller than CompactCount");
+	if (indirectGroupSize == 0)
+		throw std::runtime_error("FlowVk: reduce_by_key: indirectGroupSize must not be 0");
+
+	detail::Recorder recorder(impl);
+
+	if (elements == 0)
+	{
+		recorder.fill(countState.buffer, 0, sizeof(CompactCount), 0);
+		recorder.submit();
+		return;
+	}
+
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(elements, groupSize));
+	const auto& headsKernel = detail::get_builtin_kernel(impl, "key_runs", kKeyRuns, 6, sizeof(KeyRunsPush), {groupSize, kModeHeads});
+	const auto& runsKernel = detail::get_builtin_kernel(impl, "key_runs", kKeyRuns, 6, sizeof(KeyRunsPush), {groupSize, kModeRuns});
+
+	const VkBuffer heads = recorder.scratch(std::size_t(elements) * sizeof(uint32_t));
+	const VkBuffer positions = recorder.scratch(std::size_t(elements) * sizeof(uint32_t));
+	const VkBuffer offsets = recorder.scratch((std::size_t(elements) + 1) * sizeof(uint32_t));
+	const KeyRunsPush push{elements, indirectGroupSize};
+
+	recorder.dispatch(headsKernel, {keyState.buffer, heads, positions, keysOutState.buffer, offsets, countState.buffer}, push, groups.x, groups.y);
+	recorder.barrier();
+	detail::record_scan(recorder, ScalarType::U32, heads, positions, elements, false, detail::supports_lookback(impl));
+	recorder.barrier();
+	recorder.dispatch(runsKernel, {keyState.buffer, heads, positions, keysOutState.buffer, offsets, countState.buffer}, push, groups.x, groups.y);
+	recorder.barrier();
+
+	// The run count only exists on the device; size for one run per element.
+	record_segmented(recorder, type, op, offsets, valueState.buffer, valuesOutState.buffer, countState.buffer,
+	                 elements, elements, true);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,141 @@
+#include "../../include/flowVk/ops/Sort.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kRadixSortU32[] =
+#include "radix_sort_u32.spv.inc"
+;
+static const uint32_t kRadixSortI32[] =
+#include "radix_sort_i32.spv.inc"
+;
+static const uint32_t kRadixSortF32[] =
+#include "radix_sort_f32.spv.inc"
+;
+static const uint32_t kRadixSortU64[] =
+#include "radix_sort_u64.spv.inc"
+;
+
+struct SortPush {
+	uint32_t count;
+	uint32_t shift;
+	uint32_t blockCount;
+	uint32_t payloadWords;
+};
+
+// Must match radix_sort.comp.
+static constexpr uint32_t kModeCount = 0;
+static constexpr uint32_t kModeScatter = 1;
+static constexpr uint32_t kRadixBits = 4;
+static constexpr uint32_t kRadix = 1u << kRadixBits;
+static constexpr uint32_t kItemsPerThread = 8;
+
+static std::pair<const char*, std::span<const uint32_t>> sort_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"radix_sort_u32", std::span<const uint32_t>(kRadixSortU32)};
+		case ScalarType::I32: return {"radix_sort_i32", std::span<const uint32_t>(kRadixSortI32)};
+		case ScalarType::F32: return {"radix_sort_f32", std::span<const uint32_t>(kRadixSortF32)};
+		case ScalarType::U64: return {"radix_sort_u64", std::span<const uint32_t>(kRadixSortU64)};
+	}
+	throw std::runtime_error("FlowVk: radix_sort: unsupported key type");
+}
+
+void detail::record_radix_sort(Recorder& recorder, ScalarType keyType, VkBuffer keys, VkBuffer payload,
+                               uint32_t count, uint32_t payloadWords, uint32_t keyBits)
+{
+	if (count <= 1)
+		return;
+
+	InstanceImpl& impl = recorder.impl;
+	const std::size_t keySize = scalar_size(keyType);
+	const auto [variant, spirv] = sort_variant(keyType);
+	const uint32_t groupSize = detail::workgroup_size(impl, 128);
+	const uint32_t blockCount = detail::div_up(count, groupSize * kItemsPerThread);
+	const detail::GroupCount groups = detail::split_groups(impl, blockCount);
+	const bool lookback = detail::supports_lookback(impl);
+	const bool hasPayload = payloadWords > 0;
+	if (keyBits == 0)
+		keyBits = static_cast<uint32_t>(keySize * 8);
+
+	const auto& countKernel = detail::get_builtin_kernel(impl, variant, spirv, 5, sizeof(SortPush), {groupSize, kModeCount});
+	const auto& scatterKernel = detail::get_builtin_kernel(impl, variant, spirv, 5, sizeof(SortPush), {groupSize, kModeScatter});
+
+	// Keys ping-pong with pooled scratch; an odd pass count is copied back at the end.
+	const VkBuffer histogram = recorder.scratch(std::size_t(kRadix) * blockCount * sizeof(uint32_t));
+	VkBuffer keysIn = keys;
+	VkBuffer keysOut = recorder.scratch(count * keySize);
+	VkBuffer payloadIn = hasPayload ? payload : keysIn;
+	VkBuffer payloadOut = hasPayload ? recorder.scratch(std::size_t(count) * payloadWords * sizeof(uint32_t)) : keysIn;
+
+	for (uint32_t shift = 0; shift < keyBits; shift += kRadixBits)
+	{
+		const SortPush push{count, shift, blockCount, payloadWords};
+
+		if (shift > 0)
+			recorder.barrier();
+		recorder.dispatch(countKernel, {keysIn, payloadIn, histogram, keysOut, payloadOut}, push, groups.x, groups.y);
+		recorder.barrier();
+		detail::record_scan(recorder, ScalarType::U32, histogram, histogram, kRadix * blockCount, false, lookback);
+		recorder.barrier();
+		recorder.dispatch(scatterKernel, {keysIn, payloadIn, histogram, keysOut, payloadOut}, push, groups.x, groups.y);
+
+		std::swap(keysIn, keysOut);
+		if (hasPayload)
+			std::swap(payloadIn, payloadOut);
+		else
+			payloadIn = payloadOut = keysIn;
+	}
+
+	if (keysIn != keys)
+	{
+		recorder.barrier();
+		recorder.copy(keysIn, keys, 0, 0, count * keySize);
+		if (hasPayload)
+			recorder.copy(payloadIn, payload, 0, 0, std::size_t(count) * payloadWords * sizeof(uint32_t));
+	}
+}
+
+void detail::radix_sort(const Buffer& keys, const Buffer* payload, ScalarType keyType)
+{
+	auto& keyState = detail::buffer_state(keys, "radix_sort");
+	InstanceImpl& impl = *keys.owner;
+
+	const std::size_t keySize = scalar_size(keyType);
+	if (keyState.sizeBytes % keySize != 0)
+		throw std::runtime_error("FlowVk: radix_sort: size of '" + keys.name + "' is not a multiple of the key size");
+	const std::size_t count = keyState.sizeBytes / keySize;
+	if (count > UINT32_MAX)
+		throw std::runtime_error("FlowVk: radix_sort: more than 2^32 keys in '" + keys.name + "'");
+	if (keyType == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: radix_sort: 64-bit keys require shaderInt64");
+
+	VkBuffer payloadBuffer = VK_NULL_HANDLE;
+	uint32_t payloadWords = 0;
+	if (payload)
+	{
+		detail::require_same_owner(keys, *payload, "radix_sort");
+		auto& payloadState = detail::buffer_state(*payload, "radix_sort");
+		// Zero keys sort as a no-op whatever the payload holds.
+		if (count != 0 && (payloadState.sizeBytes % count != 0 || (payloadState.sizeBytes / count) % sizeof(uint32_t) != 0))
+			throw std::runtime_error("FlowVk: radix_sort: payload '" + payload->name + "' must hold one 4-byte-multiple element per key");
+		payloadBuffer = payloadState.buffer;
+		payloadWords = count ? static_cast<uint32_t>(payloadState.sizeBytes / count / sizeof(uint32_t)) : 0;
+	}
+
+	if (count <= 1)
+		return;
+
+	detail::Recorder recorder(impl);
+	detail::record_radix_sort(recorder, keyType, keyState.buffer, payloadBuffer, static_cast<uint32_t>(count), payloadWords);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,193 @@
+#include "../../include/flowVk/ops/Spmv.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kSpmv[] =
+#include "spmv.spv.inc"
+;
+
+struct SpmvPush {
+	uint32_t rows;
+	uint32_t nnz;
+	float alpha;
+	float beta;
+	uint32_t itemsPerThread;
+	uint32_t threads;
+	uint32_t sliceHeight;
+};
+
+// Must match SPMV_MODE, MAX_GROUP_SIZE and PADDING in spmv.comp.
+static constexpr uint32_t kModeRowSplit = 0;
+static constexpr uint32_t kModeMerge = 1;
+static constexpr uint32_t kModeFixup = 2;
+static constexpr uint32_t kModeSell = 3;
+static constexpr uint32_t kPadding = 0xFFFFFFFFu;
+
+static constexpr uint32_t kMaxLanes = 32;
+static constexpr uint32_t kMergeItemsPerThread = 16;
+
+// ----- Upload -----
+
+static void validate_csr(const CsrView& csr)
+{
+	if (csr.rowOffsets.size() != std::size_t(csr.rows) + 1)
+		throw std::runtime_error("FlowVk: makeSparseMatrix: rowOffsets must have rows + 1 entries");
+	if (csr.rowOffsets.front() != 0 || !std::is_sorted(csr.rowOffsets.begin(), csr.rowOffsets.end()))
+		throw std::runtime_error("FlowVk: makeSparseMatrix: rowOffsets must start at 0 and not decrease");
+	const std::size_t nnz = csr.rowOffsets.back();
+	if (csr.columns.size() != nnz || csr.values.size() != nnz)
+		throw std::runtime_error("FlowVk: makeSparseMatrix: columns and values must hold rowOffsets[rows] entries");
+	if (std::any_of(csr.columns.begin(), csr.columns.end(), [&](uint32_t c) { return c >= csr.cols; }))
+		throw std::runtime_error("FlowVk: makeSparseMatrix: column index out of range");
+}
+
+// Named buffers cannot be empty; a one-element tail keeps zero-nonzero matrices valid.
+template<class T>
+static Buffer upload(Instance& instance, const std::string& name, std::vector<T> data)
+{
+	if (data.empty())
+		data.push_back(T{});
+	return instance.makeReadOnly(name).fromVector(data);
+}
+
+SparseMatrix makeSparseMatrix(Instance& instance, const std::string& name, const CsrView& csr,
+                              SparseFormat format, uint32_t sliceHeight)
+{
+	if (!instance)
+		throw std::runtime_error("FlowVk: makeSparseMatrix on empty Instance");
+	validate_csr(csr);
+
+	SparseMatrix matrix;
+	matrix.format = format;
+	matrix.rows = csr.rows;
+	matrix.cols = csr.cols;
+	matrix.nnz = csr.rowOffsets.back();
+	for (uint32_t r = 0; r < csr.rows; ++r)
+		matrix.maxRowLength = std::max(matrix.maxRowLength, csr.rowOffsets[r + 1] - csr.rowOffsets[r]);
+
+	if (format == SparseFormat::Csr)
+	{
+		matrix.offsets = upload(instance, name + ".offsets", std::vector<uint32_t>(csr.rowOffsets.begin(), csr.rowOffsets.end()));
+		matrix.columns = upload(instance, name + ".columns", std::vector<uint32_t>(csr.columns.begin(), csr.columns.end()));
+		matrix.values = upload(instance, name + ".values", std::vector<float>(csr.values.begin(), csr.values.end()));
+		return matrix;
+	}
+
+	if (format == SparseFormat::Ell)
+		sliceHeight = std::max(csr.rows, 1u);
+	if (sliceHeight == 0)
+		throw std::runtime_error("FlowVk: makeSparseMatrix: sliceHeight must be positive");
+	matrix.sliceHeight = sliceHeight;
+
+	const uint32_t slices = detail::div_up(csr.rows, sliceHeight);
+	std::vector<uint32_t> sliceOffsets(std::size_t(slices) + 1, 0);
+	for (uint32_t s = 0; s < slices; ++s)
+	{
+		uint32_t width = 0;
+		for (uint32_t r = s * sliceHeight; r < std::min(csr.rows, (s + 1) * sliceHeight); ++r)
+			width = std::max(width, csr.rowOffsets[r + 1] - csr.rowOffsets[r]);
+		const std::size_t next = sliceOffsets[s] + std::size_t(width) * sliceHeight;
+		if (next > UINT32_MAX)
+			throw std::runtime_error("FlowVk: makeSparseMatrix: padded matrix exceeds 2^32 entries");
+		sliceOffsets[s + 1] = static_cast<uint32_t>(next);
+	}
+
+	std::vector<uint32_t> columns(sliceOffsets.back(), kPadding);
+	std::vector<float> values(sliceOffsets.back(), 0.0f);
+	for (uint32_t r = 0; r < csr.rows; ++r)
+	{
+		const uint32_t base = sliceOffsets[r / sliceHeight] + r % sliceHeight;
+		for (uint32_t k = 0; k < csr.rowOffsets[r + 1] - csr.rowOffsets[r]; ++k)
+		{
+			columns[base + k * sliceHeight] = csr.columns[csr.rowOffsets[r] + k];
+			values[base + k * sliceHeight] = csr.values[csr.rowOffsets[r] + k];
+		}
+	}
+
+	matrix.offsets = upload(instance, name + ".offsets", std::move(sliceOffsets));
+	matrix.columns = upload(instance, name + ".columns", std::move(columns));
+	matrix.values = upload(instance, name + ".values", std::move(values));
+	return matrix;
+}
+
+// ----- Multiply -----
+
+void spmv(const SparseMatrix& matrix, const Buffer& x, const Buffer& y, float alpha, float beta, SpmvAlgorithm algorithm)
+{
+	detail::require_same_owner(matrix.offsets, x, "spmv");
+	detail::require_same_owner(matrix.offsets, y, "spmv");
+	auto& offsets = detail::buffer_state(matrix.offsets, "spmv");
+	auto& columns = detail::buffer_state(matrix.columns, "spmv");
+	auto& values = detail::buffer_state(matrix.values, "spmv");
+	auto& xState = detail::buffer_state(x, "spmv");
+	auto& yState = detail::buffer_state(y, "spmv");
+	InstanceImpl& impl = *x.owner;
+
+	if (xState.sizeBytes < std::size_t(matrix.cols) * sizeof(float))
+		throw std::runtime_error("FlowVk: spmv: '" + x.name + "' holds fewer than cols floats");
+	if (yState.sizeBytes < std::size_t(matrix.rows) * sizeof(float))
+		throw std::runtime_error("FlowVk: spmv: '" + y.name + "' holds fewer than rows floats");
+	if (&xState == &yState)
+		throw std::runtime_error("FlowVk: spmv: x and y must be different buffers");
+	if (std::size_t(matrix.rows) + matrix.nnz > UINT32_MAX)
+		throw std::runtime_error("FlowVk: spmv: rows + nonzeros exceed 2^32");
+	if (matrix.rows == 0)
+		return;
+
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	SpmvPush push{matrix.rows, matrix.nnz, alpha, beta, 0, 0, matrix.sliceHeight};
+	detail::Recorder recorder(impl);
+
+	auto kernel = [&](uint32_t mode, uint32_t lanes) -> const InstanceImpl::BuiltinKernelState& {
+		return detail::get_builtin_kernel(impl, "spmv", kSpmv, 7, sizeof(SpmvPush), {groupSize, mode, lanes});
+	};
+
+	if (matrix.format != SparseFormat::Csr)
+	{
+		const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(matrix.rows, groupSize));
+		recorder.dispatch(kernel(kModeSell, 1), {offsets.buffer, columns.buffer, values.buffer, xState.buffer, yState.buffer, yState.buffer, yState.buffer},
+		                  push, groups.x, groups.y);
+		recorder.submit();
+		return;
+	}
+
+	const uint32_t average = std::max(1u, matrix.nnz / matrix.rows);
+	const bool skewed = matrix.maxRowLength > 8 * average + 2 * kMaxLanes;
+	const bool merge = (algorithm == SpmvAlgorithm::MergePath) || (algorithm == SpmvAlgorithm::Auto && skewed);
+
+	if (!merge)
+	{
+		const uint32_t lanes = std::min(std::bit_ceil(std::min(average, kMaxLanes)), groupSize);
+		const uint32_t rowsPerGroup = groupSize / lanes;
+		const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(matrix.rows, rowsPerGroup));
+		recorder.dispatch(kernel(kModeRowSplit, lanes), {offsets.buffer, columns.buffer, values.buffer, xState.buffer, yState.buffer, yState.buffer, yState.buffer},
+		                  push, groups.x, groups.y);
+		recorder.submit();
+		return;
+	}
+
+	const uint32_t threads = detail::div_up(std::size_t(matrix.rows) + matrix.nnz, kMergeItemsPerThread);
+	push.itemsPerThread = kMergeItemsPerThread;
+	push.threads = threads;
+
+	const VkBuffer carryRows = recorder.scratch(std::size_t(threads) * sizeof(uint32_t));
+	const VkBuffer carryValues = recorder.scratch(std::size_t(threads) * sizeof(float));
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(threads, groupSize));
+
+	recorder.dispatch(kernel(kModeMerge, 1), {offsets.buffer, columns.buffer, values.buffer, xState.buffer, yState.buffer, carryRows, carryValues},
+	                  push, groups.x, groups.y);
+	recorder.barrier();
+	recorder.dispatch(kernel(kModeFixup, 1), {offsets.buffer, columns.buffer, values.buffer, xState.buffer, yState.buffer, carryRows, carryValues},
+	                  push, groups.x, groups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
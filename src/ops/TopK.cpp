@@ -0,0 +1,190 @@
+#include "../../include/flowVk/ops/TopK.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kTopKU32[] =
+#include "top_k_u32.spv.inc"
+;
+static const uint32_t kTopKI32[] =
+#include "top_k_i32.spv.inc"
+;
+static const uint32_t kTopKF32[] =
+#include "top_k_f32.spv.inc"
+;
+static const uint32_t kTopKU64[] =
+#include "top_k_u64.spv.inc"
+;
+
+struct TopKPush {
+	uint32_t count;
+	uint32_t k;
+	uint32_t smallest;
+	uint32_t flag;
+	uint32_t shift;
+};
+
+// Must match TOPK_MODE, ITEMS_PER_THREAD and the STATE_* layout in top_k.comp.
+static constexpr uint32_t kModeTile = 0;
+static constexpr uint32_t kModeHistogram = 1;
+static constexpr uint32_t kModeSelect = 2;
+static constexpr uint32_t kModeFlags = 3;
+static constexpr uint32_t kModeScatter = 4;
+static constexpr uint32_t kModeEmit = 5;
+
+static constexpr uint32_t kItemsPerThread = 4;
+static constexpr std::size_t kStateRemaining = 4;
+static constexpr std::size_t kStateWords = 8 + 256;
+
+// Up to this many winners per tile the bitonic path shrinks the input at least
+// fourfold per pass; beyond it radix select is cheaper.
+static constexpr uint32_t kMaxTileK = 256;
+
+static std::pair<const char*, std::span<const uint32_t>> top_k_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"top_k_u32", std::span<const uint32_t>(kTopKU32)};
+		case ScalarType::I32: return {"top_k_i32", std::span<const uint32_t>(kTopKI32)};
+		case ScalarType::F32: return {"top_k_f32", std::span<const uint32_t>(kTopKF32)};
+		case ScalarType::U64: return {"top_k_u64", std::span<const uint32_t>(kTopKU64)};
+	}
+	throw std::runtime_error("FlowVk: top_k: unsupported element type");
+}
+
+void detail::top_k(const Buffer& input, ScalarType type, uint32_t k, const Buffer& values, const Buffer& indices, TopKOrder order)
+{
+	detail::require_same_owner(input, values, "top_k");
+	detail::require_same_owner(input, indices, "top_k");
+	auto& in = detail::buffer_state(input, "top_k");
+	auto& valuesOut = detail::buffer_state(values, "top_k");
+	auto& indicesOut = detail::buffer_state(indices, "top_k");
+	InstanceImpl& impl = *input.owner;
+
+	const std::size_t elementSize = scalar_size(type);
+	if (in.sizeBytes % elementSize != 0)
+		throw std::runtime_error("FlowVk: top_k: size of '" + input.name + "' is not a multiple of the element size");
+	const std::size_t elements = in.sizeBytes / elementSize;
+	if (elements >= UINT32_MAX)
+		throw std::runtime_error("FlowVk: top_k: 2^32 or more elements in '" + input.name + "'");
+	if (type == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: top_k: 64-bit elements require shaderInt64");
+	if (k > elements)
+		throw std::runtime_error("FlowVk: top_k: k exceeds the element count of '" + input.name + "'");
+	if (valuesOut.sizeBytes < std::size_t(k) * elementSize)
+		throw std::runtime_error("FlowVk: top_k: values '" + values.name + "' cannot hold k elements");
+	if (indicesOut.sizeBytes < std::size_t(k) * sizeof(uint32_t))
+		throw std::runtime_error("FlowVk: top_k: indices '" + indices.name + "' cannot hold k indices");
+	if (k == 0)
+		return;
+
+	const auto [variant, spirv] = top_k_variant(type);
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const uint32_t tile = groupSize * kItemsPerThread;
+	const uint32_t count = static_cast<uint32_t>(elements);
+	const std::size_t keySize = (type == ScalarType::U64) ? sizeof(uint64_t) : sizeof(uint32_t);
+	const ScalarType keyType = (type == ScalarType::U64) ? ScalarType::U64 : ScalarType::U32;
+	const uint32_t smallest = (order == TopKOrder::Smallest) ? 1u : 0u;
+
+	auto kernel = [&](uint32_t mode) -> const InstanceImpl::BuiltinKernelState& {
+		return detail::get_builtin_kernel(impl, variant, spirv, 8, sizeof(TopKPush), {groupSize, mode});
+	};
+
+	detail::Recorder recorder(impl);
+	const VkBuffer unused = in.buffer; // bound where the selected mode never reads
+
+	VkBuffer bestKeys = VK_NULL_HANDLE;
+	VkBuffer bestIndices = VK_NULL_HANDLE;
+	uint32_t complemented = 0;
+
+	const uint32_t tileK = std::bit_ceil(k);
+	if (tileK <= kMaxTileK || count <= tile)
+	{
+		// Every tile keeps its best tileK until a single tile is left.
+		const uint32_t firstTiles = detail::div_up(count, tile);
+		const std::size_t candidates = std::size_t(firstTiles) * tileK;
+		const VkBuffer keys[2] = {recorder.scratch(candidates * keySize), recorder.scratch(candidates * keySize)};
+		const VkBuffer sources[2] = {recorder.scratch(candidates * sizeof(uint32_t)), recorder.scratch(candidates * sizeof(uint32_t))};
+
+		uint32_t remaining = count;
+		uint32_t fromCandidates = 0;
+		int ping = 0;
+		while (true)
+		{
+			const uint32_t tiles = detail::div_up(remaining, tile);
+			const detail::GroupCount groups = detail::split_groups(impl, tiles);
+			const TopKPush push{remaining, tileK, smallest, fromCandidates, 0};
+			recorder.dispatch(kernel(kModeTile),
+			                  {in.buffer, keys[ping ^ 1], sources[ping ^ 1], keys[ping], sources[ping], unused, unused, unused},
+			                  push, groups.x, groups.y);
+			bestKeys = keys[ping];
+			bestIndices = sources[ping];
+			if (tiles == 1)
+				break;
+
+			recorder.barrier();
+			remaining = tiles * tileK;
+			fromCandidates = 1;
+			ping ^= 1;
+		}
+	}
+	else
+	{
+		// Radix select finds the k-th key one byte at a time, then the winners are
+		// compacted in index order and sorted.
+		const VkBuffer state = recorder.scratch(kStateWords * sizeof(uint32_t));
+		const VkBuffer greater = recorder.scratch(std::size_t(count) * sizeof(uint32_t));
+		const VkBuffer equal = recorder.scratch(std::size_t(count) * sizeof(uint32_t));
+		bestKeys = recorder.scratch(std::size_t(k) * keySize);
+		bestIndices = recorder.scratch(std::size_t(k) * sizeof(uint32_t));
+		complemented = 1;
+
+		recorder.fill(state, 0, VK_WHOLE_SIZE, 0);
+		recorder.update(state, kStateRemaining * sizeof(uint32_t), &k, sizeof(k));
+		recorder.barrier();
+
+		const uint32_t keyBits = static_cast<uint32_t>(keySize * 8);
+		const detail::GroupCount histogramGroups = detail::split_groups(impl, detail::div_up(count, tile));
+		for (uint32_t shift = keyBits; shift > 0;)
+		{
+			shift -= 8;
+			const TopKPush push{count, k, smallest, 0, shift};
+			recorder.dispatch(kernel(kModeHistogram), {in.buffer, unused, unused, unused, unused, state, unused, unused},
+			                  push, histogramGroups.x, histogramGroups.y);
+			recorder.barrier();
+			recorder.dispatch(kernel(kModeSelect), {in.buffer, unused, unused, unused, unused, state, unused, unused}, push, 1);
+			recorder.barrier();
+		}
+
+		const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(count, groupSize));
+		const TopKPush push{count, k, smallest, 0, 0};
+		recorder.dispatch(kernel(kModeFlags), {in.buffer, unused, unused, unused, unused, state, greater, equal},
+		                  push, groups.x, groups.y);
+		recorder.barrier();
+		const bool lookback = detail::supports_lookback(impl);
+		detail::record_scan(recorder, ScalarType::U32, greater, greater, count, false, lookback);
+		detail::record_scan(recorder, ScalarType::U32, equal, equal, count, false, lookback);
+		recorder.barrier();
+		recorder.dispatch(kernel(kModeScatter), {in.buffer, unused, unused, bestKeys, bestIndices, state, greater, equal},
+		                  push, groups.x, groups.y);
+		recorder.barrier();
+
+		// Keys are complemented, so ascending order is best first; stability keeps ties in index order.
+		detail::record_radix_sort(recorder, keyType, bestKeys, bestIndices, k, 1);
+	}
+
+	recorder.barrier();
+	const detail::GroupCount emitGroups = detail::split_groups(impl, detail::div_up(k, groupSize));
+	recorder.dispatch(kernel(kModeEmit),
+	                  {valuesOut.buffer, bestKeys, bestIndices, unused, indicesOut.buffer, unused, unused, unused},
+	                  TopKPush{count, k, smallest, complemented, 0}, emitGroups.x, emitGroups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,201 @@
+#include "../../include/flowVk/ops/Transfer.hpp"
+#include "../internal/OpsImpl.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Flow::ops {
+
+// ----- Embedded kernels -----
+
+static const uint32_t kFillU32[] =
+#include "fill_u32.spv.inc"
+;
+static const uint32_t kFillI32[] =
+#include "fill_i32.spv.inc"
+;
+static const uint32_t kFillF32[] =
+#include "fill_f32.spv.inc"
+;
+static const uint32_t kFillU64[] =
+#include "fill_u64.spv.inc"
+;
+static const uint32_t kConvert[] =
+#include "convert.spv.inc"
+;
+static const uint32_t kConvertFp64[] =
+#include "convert_fp64.spv.inc"
+;
+
+struct FillPush {
+	uint32_t first;
+	uint32_t count;
+	uint32_t startLo;
+	uint32_t startHi;
+	uint32_t stepLo;
+	uint32_t stepHi;
+};
+
+struct ConvertPush {
+	uint32_t count;
+};
+
+// Must match FILL_MODE in fill.comp.
+static constexpr uint32_t kModeFill = 0;
+static constexpr uint32_t kModeIota = 1;
+
+static std::pair<const char*, std::span<const uint32_t>> fill_variant(ScalarType type)
+{
+	switch (type)
+	{
+		case ScalarType::U32: return {"fill_u32", std::span<const uint32_t>(kFillU32)};
+		case ScalarType::I32: return {"fill_i32", std::span<const uint32_t>(kFillI32)};
+		case ScalarType::F32: return {"fill_f32", std::span<const uint32_t>(kFillF32)};
+		case ScalarType::U64: return {"fill_u64", std::span<const uint32_t>(kFillU64)};
+	}
+	throw std::runtime_error("FlowVk: fill: unsupported element type");
+}
+
+static uint32_t element_count(const Buffer& buffer, const InstanceImpl::BufferState& state, std::size_t elementSize, const char* op)
+{
+	if (state.sizeBytes % elementSize != 0)
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": size of '" + buffer.name + "' is not a multiple of the element size");
+	const std::size_t count = state.sizeBytes / elementSize;
+	if (count > UINT32_MAX)
+		throw std::runtime_error(std::string("FlowVk: ") + op + ": more than 2^32 elements in '" + buffer.name + "'");
+	return static_cast<uint32_t>(count);
+}
+
+static void run_fill_kernel(InstanceImpl& impl, const InstanceImpl::BufferState& state, ScalarType type,
+                            uint32_t mode, uint32_t count, uint64_t startBits, uint64_t stepBits)
+{
+	const auto [variant, spirv] = fill_variant(type);
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(count, groupSize));
+	const auto& kernel = detail::get_builtin_kernel(impl, variant, spirv, 1, sizeof(FillPush), {groupSize, mode});
+
+	const FillPush push{
+		0, count,
+		static_cast<uint32_t>(startBits), static_cast<uint32_t>(startBits >> 32),
+		static_cast<uint32_t>(stepBits), static_cast<uint32_t>(stepBits >> 32)};
+
+	detail::Recorder recorder(impl);
+	recorder.dispatch(kernel, {state.buffer}, push, groups.x, groups.y);
+	recorder.submit();
+}
+
+void detail::fill(const Buffer& buffer, ScalarType type, uint64_t valueBits)
+{
+	auto& state = detail::buffer_state(buffer, "fill");
+	InstanceImpl& impl = *buffer.owner;
+	const uint32_t count = element_count(buffer, state, scalar_size(type), "fill");
+	if (count == 0)
+		return;
+
+	// vkCmdFillBuffer repeats one 32-bit word; 64-bit values qualify when both halves match.
+	const uint32_t low = static_cast<uint32_t>(valueBits);
+	const bool wordPattern = (type != ScalarType::U64) || (low == static_cast<uint32_t>(valueBits >> 32));
+	if (wordPattern)
+	{
+		detail::Recorder recorder(impl);
+		recorder.fill(state.buffer, 0, std::size_t(count) * scalar_size(type), low);
+		recorder.submit();
+		return;
+	}
+
+	if (!impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: fill: 64-bit elements require shaderInt64");
+	run_fill_kernel(impl, state, type, kModeFill, count, valueBits, 0);
+}
+
+void detail::iota(const Buffer& buffer, ScalarType type, uint64_t startBits, uint64_t stepBits)
+{
+	auto& state = detail::buffer_state(buffer, "iota");
+	InstanceImpl& impl = *buffer.owner;
+	const uint32_t count = element_count(buffer, state, scalar_size(type), "iota");
+	if (count == 0)
+		return;
+	if (type == ScalarType::U64 && !impl.caps.shaderInt64)
+		throw std::runtime_error("FlowVk: iota: 64-bit elements require shaderInt64");
+
+	run_fill_kernel(impl, state, type, kModeIota, count, startBits, stepBits);
+}
+
+void copy(const Buffer& src, const Buffer& dst, std::size_t srcOffset, std::size_t dstOffset, std::size_t bytes)
+{
+	detail::require_same_owner(src, dst, "copy");
+	auto& from = detail::buffer_state(src, "copy");
+	auto& to = detail::buffer_state(dst, "copy");
+
+	if (srcOffset > from.sizeBytes)
+		throw std::runtime_error("FlowVk: copy: offset past the end of '" + src.name + "'");
+	if (bytes == WholeBuffer)
+		bytes = from.sizeBytes - srcOffset;
+	if (bytes > from.sizeBytes - srcOffset)
+		throw std::runtime_error("FlowVk: copy: range exceeds '" + src.name + "'");
+	if (dstOffset > to.sizeBytes || bytes > to.sizeBytes - dstOffset)
+		throw std::runtime_error("FlowVk: copy: range exceeds '" + dst.name + "'");
+	if (&from == &to && srcOffset < dstOffset + bytes && dstOffset < srcOffset + bytes)
+		throw std::runtime_error("FlowVk: copy: overlapping ranges in '" + src.name + "'");
+	if (bytes == 0)
+		return;
+
+	detail::Recorder recorder(*src.owner);
+	recorder.copy(from.buffer, to.buffer, srcOffset, dstOffset, bytes);
+	recorder.submit();
+}
+
+void convert(const Buffer& src, ElementFormat from, const Buffer& dst, ElementFormat to)
+{
+	detail::require_same_owner(src, dst, "convert");
+	auto& in = detail::buffer_state(src, "convert");
+	auto& out = detail::buffer_state(dst, "convert");
+	InstanceImpl& impl = *src.owner;
+
+	const std::size_t fromSize = element_format_size(from);
+	const std::size_t toSize = element_format_size(to);
+	if (in.sizeBytes % fromSize != 0)
+		throw std::runtime_error("FlowVk: convert: size of '" + src.name + "' is not a multiple of the element size");
+	const std::size_t count = in.sizeBytes / fromSize;
+	if (count > UINT32_MAX)
+		throw std::runtime_error("FlowVk: convert: more than 2^32 elements in '" + src.name + "'");
+	if (out.sizeBytes < count * toSize)
+		throw std::runtime_error("FlowVk: convert: '" + dst.name + "' cannot hold every element of '" + src.name + "'");
+
+	// Half floats are accessed as whole 32-bit words.
+	if ((from == ElementFormat::F16 && in.sizeBytes % 4 != 0) || (to == ElementFormat::F16 && out.sizeBytes < detail::div_up(count, 2) * 4u))
+		throw std::runtime_error("FlowVk: convert: F16 buffers must span whole 32-bit words");
+
+	if (&in == &out && from != to)
+		throw std::runtime_error("FlowVk: convert: '" + src.name + "' cannot be converted in place");
+
+	const bool fp64 = (from == ElementFormat::F64 || to == ElementFormat::F64);
+	if (fp64 && !impl.caps.shaderFloat64)
+		throw std::runtime_error("FlowVk: convert: F64 elements require shaderFloat64");
+	if (count == 0)
+		return;
+
+	detail::Recorder recorder(impl);
+
+	// Same-width integers and identical formats are a bit-for-bit copy.
+	const bool integers = (from == ElementFormat::U32 || from == ElementFormat::I32) && (to == ElementFormat::U32 || to == ElementFormat::I32);
+	if (from == to || integers)
+	{
+		if (&in == &out)
+			return;
+		recorder.copy(in.buffer, out.buffer, 0, 0, count * toSize);
+		recorder.submit();
+		return;
+	}
+
+	const uint32_t groupSize = detail::workgroup_size(impl, 256);
+	const detail::GroupCount groups = detail::split_groups(impl, detail::div_up(count, 2 * std::size_t(groupSize)));
+	const auto& kernel = fp64
+		? detail::get_builtin_kernel(impl, "convert_fp64", kConvertFp64, 2, sizeof(ConvertPush), {groupSize, uint32_t(from), uint32_t(to)})
+		: detail::get_builtin_kernel(impl, "convert", kConvert, 2, sizeof(ConvertPush), {groupSize, uint32_t(from), uint32_t(to)});
+
+	recorder.dispatch(kernel, {in.buffer, out.buffer}, ConvertPush{static_cast<uint32_t>(count)}, groups.x, groups.y);
+	recorder.submit();
+}
+
+} // namespace Flow::ops
@@ -0,0 +1,32 @@
+// Element type for built-in kernels. FLOW_TYPE is set per variant by the build
+// and matches Flow::ops::ScalarType: 0 = uint, 1 = int, 2 = float, 3 = uint64_t.
+#ifndef FLOW_TYPE
+#error "FlowVk: FLOW_TYPE must be defined"
+#endif
+
+#if FLOW_TYPE == 0
+	#define FLOW_T      uint
+	#define FLOW_ZERO   0u
+	#define FLOW_MAX    0xFFFFFFFFu
+	#define FLOW_LOWEST 0u
+#elif FLOW_TYPE == 1
+	#define FLOW_T      int
+	#define FLOW_ZERO   0
+	#define FLOW_MAX    0x7FFFFFFF
+	#define FLOW_LOWEST (-0x7FFFFFFF - 1)
+#elif FLOW_TYPE == 2
+	#define FLOW_T      float
+	#define FLOW_ZERO   0.0
+	#define FLOW_MAX    uintBitsToFloat(0x7F800000u)
+	#define FLOW_LOWEST uintBitsToFloat(0xFF800000u)
+#elif FLOW_TYPE == 3
+	#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+	#define FLOW_T      uint64_t
+	#define FLOW_ZERO   0ul
+	#define FLOW_MAX    0xFFFFFFFFFFFFFFFFul
+	#define FLOW_LOWEST 0ul
+#else
+	#error "FlowVk: unknown FLOW_TYPE"
+#endif
+
+const uint FLOW_NO_INDEX = 0xFFFFFFFFu;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <iostream>
+#include <string_view>
+
+// Minimal assertions for the FlowVk test programs: a failed CHECK is reported and
+// counted, and main returns flow_test::exit_code() so ctest sees the failure.
+namespace flow_test {
+
+inline int& failures()
+{
+	static int count = 0;
+	return count;
+}
+
+inline void report(bool ok, std::string_view what, const char* file, int line)
+{
+	if (ok)
+		return;
+	++failures();
+	std::cerr << file << ":" << line << ": CHECK failed: " << what << "\n";
+}
+
+inline int exit_code()
+{
+	if (failures() == 0)
+		return 0;
+	std::cerr << failures() << " check(s) failed\n";
+	return 1;
+}
+
+} // namespace flow_test
+
+#define CHECK(expr) ::flow_test::report(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
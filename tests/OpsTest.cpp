@@ -0,0 +1,1412 @@
+// Runs every built-in Flow::ops primitive on a Vulkan device and compares it against a
+// reference computed on the host, at one element, odd counts and counts spanning many
+// workgroups or tiles. Zero-sized work either returns at once or is rejected.
+// Usage: FlowVk_OpsTest
+
+#include "Check.hpp"
+
+#include <FlowVk.hpp>
+#include "internal/InstanceImpl.hpp" // device caps: which optional element types to cover
+#include "internal/OpsImpl.hpp"      // supports_lookback
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace ops = Flow::ops;
+
+// One element, a few under one workgroup, and counts spanning many workgroups and scan tiles.
+static constexpr std::size_t kSizes[] = {1, 7, 1000, 100'003, 1'048'577};
+
+// ----- Helpers -----
+
+// Deterministic pseudo-random words (xorshift64*), so every run checks the same data.
+static std::vector<uint64_t> random_words(std::size_t count, uint64_t seed)
+{
+	std::vector<uint64_t> out(count);
+	uint64_t state = seed ? seed : 0x9E3779B97F4A7C15ull;
+	for (auto& word : out)
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		word = state * 0x2545F4914F6CDD1Dull;
+	}
+	return out;
+}
+
+// `first + word % range` as T, or whole words when range is 0. Small ranges give duplicates,
+// and whole numbers keep float sums exact whatever order the device adds them in.
+template<class T>
+static std::vector<T> random_values(std::size_t count, uint64_t seed, uint64_t range = 0, int64_t first = 0)
+{
+	const auto words = random_words(count, seed);
+	std::vector<T> values(count);
+	for (std::size_t i = 0; i < count; ++i)
+		values[i] = range ? static_cast<T>(first + static_cast<int64_t>(words[i] % range)) : static_cast<T>(words[i]);
+	return values;
+}
+
+// Floats in [-1, 1), multiples of 2^-10.
+static std::vector<float> random_floats(std::size_t count, uint64_t seed)
+{
+	auto values = random_values<float>(count, seed, 2048, -1024);
+	for (auto& value : values)
+		value /= 1024.0f;
+	return values;
+}
+
+static std::vector<uint32_t> iota_values(std::size_t count, uint32_t first = 0)
+{
+	std::vector<uint32_t> values(count);
+	std::iota(values.begin(), values.end(), first);
+	return values;
+}
+
+template<class T>
+static std::vector<T> prefix(const std::vector<T>& values, std::size_t count)
+{
+	return std::vector<T>(values.begin(), values.begin() + std::min(count, values.size()));
+}
+
+// Every expected value matches within `tolerance`, relative to its magnitude above 1.
+static bool close_to(const std::vector<float>& actual, const std::vector<float>& expected, float tolerance)
+{
+	if (actual.size() < expected.size())
+		return false;
+	for (std::size_t i = 0; i < expected.size(); ++i)
+		if (!(std::abs(actual[i] - expected[i]) <= tolerance * (1.0f + std::abs(expected[i]))))
+			return false;
+	return true;
+}
+
+// The first expected.size() bytes of `words` equal `expected`.
+static bool bytes_equal(const std::vector<uint32_t>& words, const std::vector<uint8_t>& expected)
+{
+	return words.size() * sizeof(uint32_t) >= expected.size() &&
+	       std::memcmp(words.data(), expected.data(), expected.size()) == 0;
+}
+
+static std::vector<uint8_t> to_bytes(const std::vector<uint32_t>& words)
+{
+	std::vector<uint8_t> bytes(words.size() * sizeof(uint32_t));
+	std::memcpy(bytes.data(), words.data(), bytes.size());
+	return bytes;
+}
+
+template<class F>
+static bool throws(F&& body)
+{
+	try
+	{
+		body();
+	}
+	catch (const std::runtime_error&)
+	{
+		return true;
+	}
+	return false;
+}
+
+static std::size_t div_up(std::size_t a, std::size_t b)
+{
+	return (a + b - 1) / b;
+}
+
+// ----- reduce -----
+
+template<class T>
+static void check_reduce(Flow::Instance& instance, const std::vector<T>& values)
+{
+	Flow::Buffer input = instance.makeReadWrite("reduce_input").fromVector(values);
+	const auto minIt = std::min_element(values.begin(), values.end()); // first occurrence, as ArgMin
+	const auto maxIt = std::max_element(values.begin(), values.end());
+
+	CHECK(ops::reduce<T>(input).value == std::accumulate(values.begin(), values.end(), T(0)));
+	CHECK(ops::reduce<T>(input, ops::ReduceOp::Min).value == *minIt);
+	CHECK(ops::reduce<T>(input, ops::ReduceOp::Max).value == *maxIt);
+
+	const auto argMin = ops::reduce<T>(input, ops::ReduceOp::ArgMin);
+	const auto argMax = ops::reduce<T>(input, ops::ReduceOp::ArgMax);
+	CHECK(argMin.value == *minIt && argMin.index == static_cast<uint32_t>(minIt - values.begin()));
+	CHECK(argMax.value == *maxIt && argMax.index == static_cast<uint32_t>(maxIt - values.begin()));
+}
+
+static void test_reduce(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		check_reduce(instance, random_values<uint32_t>(count, count, 1000));
+		check_reduce(instance, random_values<uint32_t>(count, count + 1)); // the sum wraps
+		check_reduce(instance, random_values<int32_t>(count, count + 2, 1000, -500));
+		check_reduce(instance, random_values<float>(count, count + 3, 8, -4));
+		if (instance.pimpl->caps.shaderInt64)
+			check_reduce(instance, random_values<uint64_t>(count, count + 4));
+	}
+}
+
+// ----- scan -----
+
+template<class T>
+static void check_scan(Flow::Instance& instance, const std::vector<T>& values, ops::ScanAlgorithm algorithm)
+{
+	std::vector<T> exclusive(values.size());
+	std::vector<T> inclusive(values.size());
+	std::exclusive_scan(values.begin(), values.end(), exclusive.begin(), T(0));
+	std::inclusive_scan(values.begin(), values.end(), inclusive.begin());
+
+	Flow::Buffer input = instance.makeReadWrite("scan_input").fromVector(values);
+	Flow::Buffer output = instance.makeReadWrite("scan_output").withSizeBytes(values.size() * sizeof(T));
+	ops::scan<T>(input, output, ops::ScanKind::Exclusive, algorithm);
+	CHECK(output.getValues<T>() == exclusive);
+
+	ops::scan<T>(input, input, ops::ScanKind::Inclusive, algorithm);
+	CHECK(input.getValues<T>() == inclusive);
+}
+
+// Lookback is only requested where Auto would pick it: elsewhere its spinning workgroups may never finish.
+static void test_scan(Flow::Instance& instance)
+{
+	std::vector<ops::ScanAlgorithm> algorithms{ops::ScanAlgorithm::ReduceThenScan};
+	if (ops::detail::supports_lookback(*instance.pimpl))
+		algorithms.push_back(ops::ScanAlgorithm::DecoupledLookback);
+
+	for (ops::ScanAlgorithm algorithm : algorithms)
+	{
+		for (std::size_t count : kSizes)
+		{
+			check_scan(instance, random_values<uint32_t>(count, count), algorithm);
+			check_scan(instance, random_values<int32_t>(count, count + 1, 100, -50), algorithm);
+			check_scan(instance, random_values<float>(count, count + 2, 4), algorithm);
+			if (instance.pimpl->caps.shaderInt64)
+				check_scan(instance, random_values<uint64_t>(count, count + 3), algorithm);
+		}
+	}
+}
+
+// ----- radix_sort -----
+
+template<class K>
+static void check_sort(Flow::Instance& instance, const std::vector<K>& input)
+{
+	auto expected = input;
+	std::stable_sort(expected.begin(), expected.end());
+
+	Flow::Buffer keys = instance.makeReadWrite("sort_keys").fromVector(input);
+	ops::radix_sort<K>(keys);
+	CHECK(keys.getValues<K>() == expected);
+}
+
+// Keys with duplicates carry their index as a one-word payload, then as a two-word one;
+// the expected order is a stable sort of the indices by key.
+static void check_sort_pairs(Flow::Instance& instance, std::size_t count)
+{
+	const auto input = random_values<uint32_t>(count, count + 7, count / 4 + 1);
+	auto order = iota_values(count);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return input[a] < input[b]; });
+
+	std::vector<uint32_t> sortedKeys(count);
+	std::vector<uint32_t> pairs(2 * count);
+	std::vector<uint32_t> sortedPairs(2 * count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		sortedKeys[i] = input[order[i]];
+		pairs[2 * i] = static_cast<uint32_t>(i);
+		pairs[2 * i + 1] = ~static_cast<uint32_t>(i);
+		sortedPairs[2 * i] = order[i];
+		sortedPairs[2 * i + 1] = ~order[i];
+	}
+
+	Flow::Buffer keys = instance.makeReadWrite("sort_keys").fromVector(input);
+	Flow::Buffer payload = instance.makeReadWrite("sort_payload").fromVector(iota_values(count));
+	ops::radix_sort<uint32_t>(keys, payload);
+	CHECK(keys.getValues<uint32_t>() == sortedKeys);
+	CHECK(payload.getValues<uint32_t>() == order);
+
+	keys.setValues(input);
+	payload = instance.makeReadWrite("sort_payload").fromVector(pairs);
+	ops::radix_sort<uint32_t>(keys, payload);
+	CHECK(keys.getValues<uint32_t>() == sortedKeys);
+	CHECK(payload.getValues<uint32_t>() == sortedPairs);
+}
+
+static void test_radix_sort(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		check_sort(instance, random_values<uint32_t>(count, count));
+		check_sort(instance, random_values<int32_t>(count, count + 1, 2'000'001, -1'000'000));
+		check_sort(instance, random_values<float>(count, count + 2, 2'000'001, -1'000'000));
+		if (instance.pimpl->caps.shaderInt64)
+			check_sort(instance, random_values<uint64_t>(count, count + 3));
+		check_sort_pairs(instance, count);
+	}
+}
+
+// ----- gemm -----
+
+static std::size_t matrix_index(ops::MatrixLayout layout, uint32_t rows, uint32_t cols, uint32_t row, uint32_t col)
+{
+	return (layout == ops::MatrixLayout::RowMajor) ? std::size_t(row) * cols + col : std::size_t(col) * rows + row;
+}
+
+static std::vector<float> gemm_reference(const std::vector<float>& a, const std::vector<float>& b, std::vector<float> c,
+                                         const ops::GemmDesc& desc)
+{
+	const std::size_t sizeA = std::size_t(desc.m) * desc.k;
+	const std::size_t sizeB = std::size_t(desc.k) * desc.n;
+	const std::size_t sizeC = std::size_t(desc.m) * desc.n;
+	for (uint32_t batch = 0; batch < desc.batch; ++batch)
+		for (uint32_t i = 0; i < desc.m; ++i)
+			for (uint32_t j = 0; j < desc.n; ++j)
+			{
+				double sum = 0.0;
+				for (uint32_t l = 0; l < desc.k; ++l)
+					sum += double(a[batch * sizeA + matrix_index(desc.layoutA, desc.m, desc.k, i, l)]) *
+					       b[batch * sizeB + matrix_index(desc.layoutB, desc.k, desc.n, l, j)];
+				float& out = c[batch * sizeC + matrix_index(desc.layoutC, desc.m, desc.n, i, j)];
+				out = static_cast<float>(desc.alpha * sum + (desc.beta != 0.0f ? double(desc.beta) * out : 0.0));
+			}
+	return c;
+}
+
+static void test_gemm(Flow::Instance& instance)
+{
+	constexpr auto row = ops::MatrixLayout::RowMajor;
+	constexpr auto col = ops::MatrixLayout::ColumnMajor;
+	const ops::GemmDesc cases[] = {
+		{1, 1, 1},
+		{37, 53, 29},
+		{64, 64, 64, row, col, row, 1.0f, -1.0f, 2},
+		{130, 70, 257, col, row, col, 0.5f, 2.0f, 3},
+		{65, 129, 0, row, row, row, 1.0f, 0.5f}, // k = 0 only scales C
+		{0, 5, 5},                               // nothing to compute: C is untouched
+	};
+
+	for (const ops::GemmDesc& desc : cases)
+	{
+		// Named buffers cannot be empty, so zero-sized operands keep one element.
+		auto elements = [&](uint32_t rows, uint32_t cols) { return std::max<std::size_t>(std::size_t(rows) * cols * desc.batch, 1); };
+		const auto a = random_floats(elements(desc.m, desc.k), desc.m * 3 + 1);
+		const auto b = random_floats(elements(desc.k, desc.n), desc.n * 5 + 2);
+		const auto c = random_floats(elements(desc.m, desc.n), desc.k * 7 + 3);
+
+		Flow::Buffer bufferA = instance.makeReadWrite("gemm_a").fromVector(a);
+		Flow::Buffer bufferB = instance.makeReadWrite("gemm_b").fromVector(b);
+		Flow::Buffer bufferC = instance.makeReadWrite("gemm_c").fromVector(c);
+		ops::gemm(bufferA, bufferB, bufferC, desc);
+		CHECK(close_to(bufferC.getValues<float>(), gemm_reference(a, b, c, desc), 1e-5f * float(desc.k + 1)));
+	}
+}
+
+// ----- histogram -----
+
+// `bins` equal bins over [lower, upper] in exact integer arithmetic; the last bin takes `upper`.
+static std::vector<uint32_t> uniform_histogram(const std::vector<uint32_t>& values, uint32_t lower, uint32_t upper, uint32_t bins)
+{
+	std::vector<uint32_t> counts(bins);
+	for (uint32_t value : values)
+		if (value >= lower && value <= upper)
+			++counts[std::min<uint64_t>(uint64_t(value - lower) * bins / (upper - lower), bins - 1)];
+	return counts;
+}
+
+static void test_histogram(Flow::Instance& instance)
+{
+	const ops::HistogramAlgorithm algorithms[] = {ops::HistogramAlgorithm::SharedAtomics, ops::HistogramAlgorithm::Sort};
+	const std::vector<uint32_t> edges{0, 1, 10, 100, 1000, 1200};
+
+	for (std::size_t count : kSizes)
+	{
+		const auto words = random_values<uint32_t>(count, count, 1300);
+		Flow::Buffer input = instance.makeReadWrite("histogram_input").fromVector(words);
+		Flow::Buffer counts = instance.makeReadWrite("histogram_counts").withSizeBytes(5000 * sizeof(uint32_t));
+		Flow::Buffer edgeBuffer = instance.makeReadWrite("histogram_edges").fromVector(edges);
+
+		// Values below 0 (as floats) or above the last edge are ignored.
+		auto floats = random_values<float>(count, count + 1, 70, -10);
+		std::vector<uint32_t> floatCounts(50);
+		for (float value : floats)
+			if (value >= 0.0f && value <= 50.0f)
+				++floatCounts[std::min(static_cast<uint32_t>(value), 49u)];
+		Flow::Buffer floatInput = instance.makeReadWrite("histogram_floats").fromVector(floats);
+
+		std::vector<uint32_t> edgeCounts(edges.size() - 1);
+		for (uint32_t value : words)
+			if (value >= edges.front() && value <= edges.back())
+				++edgeCounts[std::min<std::size_t>(std::upper_bound(edges.begin(), edges.end(), value) - edges.begin() - 1, edgeCounts.size() - 1)];
+
+		for (ops::HistogramAlgorithm algorithm : algorithms)
+		{
+			ops::histogram<uint32_t>(input, counts, ops::UniformBins<uint32_t>{100, 1100, 37}, algorithm);
+			CHECK(prefix(counts.getValues<uint32_t>(), 37) == uniform_histogram(words, 100, 1100, 37));
+
+			ops::histogram<float>(floatInput, counts, ops::UniformBins<float>{0.0f, 50.0f, 50}, algorithm);
+			CHECK(prefix(counts.getValues<uint32_t>(), 50) == floatCounts);
+
+			ops::histogram<uint32_t>(input, counts, edgeBuffer, algorithm);
+			CHECK(prefix(counts.getValues<uint32_t>(), edgeCounts.size()) == edgeCounts);
+		}
+
+		// More bins than fit in shared memory.
+		ops::histogram<uint32_t>(input, counts, ops::UniformBins<uint32_t>{0, 1299, 5000});
+		CHECK(counts.getValues<uint32_t>() == uniform_histogram(words, 0, 1299, 5000));
+	}
+}
+
+// ----- compact -----
+
+template<class T>
+static bool compare(ops::CompareOp op, T a, T b)
+{
+	switch (op)
+	{
+		case ops::CompareOp::Equal:        return a == b;
+		case ops::CompareOp::NotEqual:     return a != b;
+		case ops::CompareOp::Less:         return a < b;
+		case ops::CompareOp::LessEqual:    return a <= b;
+		case ops::CompareOp::Greater:      return a > b;
+		case ops::CompareOp::GreaterEqual: return a >= b;
+	}
+	return false;
+}
+
+static void check_compact_count(const Flow::Instance& instance, const Flow::Buffer& count, std::size_t kept, uint32_t groupSize)
+{
+	const auto counts = count.getValues<uint32_t>();
+	CHECK(counts[3] == kept);
+	CHECK(counts[0] == std::min<std::size_t>(div_up(kept, groupSize), instance.pimpl->caps.maxGroupCountX));
+}
+
+template<class T>
+static void check_compact(Flow::Instance& instance, const std::vector<T>& values, const ops::Predicate<T>& keep)
+{
+	std::vector<T> keptValues;
+	std::vector<uint32_t> keptIndices;
+	for (std::size_t i = 0; i < values.size(); ++i)
+		if (compare(keep.op, values[i], keep.value))
+		{
+			keptValues.push_back(values[i]);
+			keptIndices.push_back(static_cast<uint32_t>(i));
+		}
+
+	Flow::Buffer input = instance.makeReadWrite("compact_input").fromVector(values);
+	Flow::Buffer output = instance.makeReadWrite("compact_output").withSizeBytes(values.size() * sizeof(T));
+	Flow::Buffer count = instance.makeReadWrite("compact_count").withSizeBytes(sizeof(ops::CompactCount));
+
+	ops::compact<T>(input, keep, output, count);
+	check_compact_count(instance, count, keptValues.size(), 256);
+	CHECK(prefix(output.getValues<T>(), keptValues.size()) == keptValues);
+
+	ops::compact<T>(input, keep, output, count, ops::CompactOutput::Indices, 64);
+	check_compact_count(instance, count, keptIndices.size(), 64);
+	CHECK(prefix(output.getValues<uint32_t>(), keptIndices.size()) == keptIndices);
+}
+
+static void test_compact(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		const auto words = random_values<uint32_t>(count, count, 10);
+		check_compact(instance, words, ops::Predicate<uint32_t>{ops::CompareOp::Less, 3u});
+		check_compact(instance, words, ops::Predicate<uint32_t>{ops::CompareOp::Equal, 99u}); // keeps nothing
+		check_compact(instance, random_values<int32_t>(count, count + 1, 100, -50), ops::Predicate<int32_t>{ops::CompareOp::GreaterEqual, -10});
+		check_compact(instance, random_values<float>(count, count + 2, 8, -4), ops::Predicate<float>{ops::CompareOp::NotEqual, 0.0f});
+
+		// Flags from an own kernel: keep every element with a non-zero flag.
+		const auto flags = random_values<uint32_t>(count, count + 3, 2);
+		std::vector<uint32_t> expected;
+		for (std::size_t i = 0; i < count; ++i)
+			if (flags[i] != 0)
+				expected.push_back(words[i]);
+
+		Flow::Buffer input = instance.makeReadWrite("compact_input").fromVector(words);
+		Flow::Buffer flagBuffer = instance.makeReadWrite("compact_flags").fromVector(flags);
+		Flow::Buffer output = instance.makeReadWrite("compact_output").withSizeBytes(count * sizeof(uint32_t));
+		Flow::Buffer counts = instance.makeReadWrite("compact_count").withSizeBytes(sizeof(ops::CompactCount));
+		ops::compact<uint32_t>(input, flagBuffer, output, counts);
+		check_compact_count(instance, counts, expected.size(), 256);
+		CHECK(prefix(output.getValues<uint32_t>(), expected.size()) == expected);
+	}
+}
+
+// ----- fill, iota, copy, convert -----
+
+static void test_transfer(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		Flow::Buffer words = instance.makeReadWrite("transfer_words").withSizeBytes(count * sizeof(uint32_t), false);
+
+		ops::fill<uint32_t>(words, 0xDEADBEEFu);
+		CHECK(words.getValues<uint32_t>() == std::vector<uint32_t>(count, 0xDEADBEEFu));
+		ops::fill<float>(words, -1.5f);
+		CHECK(words.getValues<float>() == std::vector<float>(count, -1.5f));
+
+		ops::iota<uint32_t>(words, 5u, 3u);
+		std::vector<uint32_t> expectedU32(count);
+		std::vector<int32_t> expectedI32(count);
+		std::vector<float> expectedF32(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			expectedU32[i] = 5u + 3u * static_cast<uint32_t>(i);
+			expectedI32[i] = 100 - 7 * static_cast<int32_t>(i);
+			expectedF32[i] = -2.5f + 0.25f * static_cast<float>(i); // exact below 2^22
+		}
+		CHECK(words.getValues<uint32_t>() == expectedU32);
+		ops::iota<int32_t>(words, 100, -7);
+		CHECK(words.getValues<int32_t>() == expectedI32);
+		ops::iota<float>(words, -2.5f, 0.25f);
+		CHECK(words.getValues<float>() == expectedF32);
+
+		if (instance.pimpl->caps.shaderInt64)
+		{
+			Flow::Buffer wide = instance.makeReadWrite("transfer_wide").withSizeBytes(count * sizeof(uint64_t), false);
+			ops::fill<uint64_t>(wide, 0x0123456789ABCDEFull); // halves differ: needs the kernel
+			CHECK(wide.getValues<uint64_t>() == std::vector<uint64_t>(count, 0x0123456789ABCDEFull));
+
+			std::vector<uint64_t> expected(count);
+			for (std::size_t i = 0; i < count; ++i)
+				expected[i] = (1ull << 40) + 3ull * i;
+			ops::iota<uint64_t>(wide, 1ull << 40, 3ull);
+			CHECK(wide.getValues<uint64_t>() == expected);
+		}
+
+		// copy: everything, then all but the first word shifted by two words.
+		const auto source = random_values<uint32_t>(count, count);
+		Flow::Buffer src = instance.makeReadWrite("transfer_src").fromVector(source);
+		Flow::Buffer dst = instance.makeReadWrite("transfer_dst").withSizeBytes((count + 3) * sizeof(uint32_t));
+		ops::copy(src, dst);
+		CHECK(prefix(dst.getValues<uint32_t>(), count) == source);
+
+		dst.zeroFill();
+		ops::copy(src, dst, sizeof(uint32_t), 2 * sizeof(uint32_t), (count - 1) * sizeof(uint32_t));
+		std::vector<uint32_t> shifted(count + 3, 0);
+		std::copy(source.begin() + 1, source.end(), shifted.begin() + 2);
+		CHECK(dst.getValues<uint32_t>() == shifted);
+
+		// convert, with values every format represents exactly.
+		const auto small = random_values<uint32_t>(count, count + 1, 1u << 24);
+		const auto halves = random_values<float>(count, count + 2, 4000, -2000);
+		std::vector<float> smallAsFloat(small.begin(), small.end());
+		std::vector<float> halvesF32(count);
+		std::vector<int32_t> truncated(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			halvesF32[i] = halves[i] / 2.0f;
+			truncated[i] = static_cast<int32_t>(halvesF32[i]);
+		}
+
+		Flow::Buffer from = instance.makeReadWrite("convert_from").fromVector(small);
+		Flow::Buffer to = instance.makeReadWrite("convert_to").withSizeBytes(count * sizeof(float));
+		ops::convert(from, ops::ElementFormat::U32, to, ops::ElementFormat::F32);
+		CHECK(to.getValues<float>() == smallAsFloat);
+
+		from.setValues(halvesF32);
+		ops::convert(from, ops::ElementFormat::F32, to, ops::ElementFormat::I32);
+		CHECK(to.getValues<int32_t>() == truncated);
+
+		// Half floats come in whole words, so an odd count converts back with one extra element.
+		Flow::Buffer half = instance.makeReadWrite("convert_half").withSizeBytes(div_up(count, 2) * sizeof(uint32_t));
+		Flow::Buffer back = instance.makeReadWrite("convert_back").withSizeBytes(div_up(count, 2) * 2 * sizeof(float));
+		ops::convert(from, ops::ElementFormat::F32, half, ops::ElementFormat::F16);
+		ops::convert(half, ops::ElementFormat::F16, back, ops::ElementFormat::F32);
+		CHECK(prefix(back.getValues<float>(), count) == halvesF32);
+
+		if (instance.pimpl->caps.shaderFloat64)
+		{
+			Flow::Buffer wide = instance.makeReadWrite("convert_wide").withSizeBytes(count * sizeof(double));
+			ops::convert(from, ops::ElementFormat::F32, wide, ops::ElementFormat::F64);
+			CHECK(wide.getValues<double>() == std::vector<double>(halvesF32.begin(), halvesF32.end()));
+		}
+	}
+}
+
+// ----- fft -----
+
+using Complex = std::complex<double>;
+
+static std::vector<Complex> to_complex(const std::vector<float>& interleaved)
+{
+	std::vector<Complex> values(interleaved.size() / 2);
+	for (std::size_t i = 0; i < values.size(); ++i)
+		values[i] = Complex(interleaved[2 * i], interleaved[2 * i + 1]);
+	return values;
+}
+
+// X[k] = sum_j x[first + j * stride] e^(-2 pi i jk / n).
+static Complex dft_bin(const std::vector<Complex>& x, std::size_t first, std::size_t stride, std::size_t n, std::size_t k)
+{
+	Complex sum = 0.0;
+	for (std::size_t j = 0; j < n; ++j)
+	{
+		const double angle = -2.0 * std::numbers::pi * double((j * k) % n) / double(n);
+		sum += x[first + j * stride] * Complex(std::cos(angle), std::sin(angle));
+	}
+	return sum;
+}
+
+// Full forward transform of `batch` row-major nx x ny arrays: rows, then columns.
+static std::vector<Complex> dft_2d(const std::vector<Complex>& x, uint32_t nx, uint32_t ny, uint32_t batch)
+{
+	std::vector<Complex> rows(x.size());
+	std::vector<Complex> result(x.size());
+	for (std::size_t r = 0; r < std::size_t(batch) * ny; ++r)
+		for (uint32_t k = 0; k < nx; ++k)
+			rows[r * nx + k] = dft_bin(x, r * nx, 1, nx, k);
+	for (uint32_t b = 0; b < batch; ++b)
+		for (uint32_t column = 0; column < nx; ++column)
+			for (uint32_t k = 0; k < ny; ++k)
+				result[(std::size_t(b) * ny + k) * nx + column] = dft_bin(rows, std::size_t(b) * ny * nx + column, nx, ny, k);
+	return result;
+}
+
+// Float error grows with the magnitude of the bins (about sqrt(n) for inputs in [-1, 1]) and the pass count.
+static double fft_tolerance(std::size_t n)
+{
+	return 1e-4 * std::sqrt(double(n)) * std::log2(double(n) + 1.0) + 1e-5;
+}
+
+static bool bin_matches(const std::vector<float>& spectrum, std::size_t index, Complex expected, double tolerance)
+{
+	return std::abs(Complex(spectrum[2 * index], spectrum[2 * index + 1]) - expected) <= tolerance;
+}
+
+// Inverse transforms are unnormalized: a round trip scales by the transform size.
+static bool round_trip_matches(const Flow::Buffer& result, const std::vector<float>& signal, std::size_t n)
+{
+	auto values = result.getValues<float>();
+	for (auto& value : values)
+		value /= static_cast<float>(n);
+	return close_to(values, signal, static_cast<float>(fft_tolerance(n) / std::sqrt(double(n))));
+}
+
+static void test_fft(Flow::Instance& instance)
+{
+	// 1D complex transforms covering every radix; large ones are spot-checked on about a hundred bins.
+	for (uint32_t nx : {1u, 7u, 1000u, 30030u})
+	{
+		const uint32_t batch = 2;
+		const auto signal = random_floats(std::size_t(2) * nx * batch, nx);
+		const auto x = to_complex(signal);
+		const ops::FftDesc desc{nx, 1, batch};
+
+		Flow::Buffer input = instance.makeReadWrite("fft_input").fromVector(signal);
+		Flow::Buffer spectrum = instance.makeReadWrite("fft_spectrum").withSizeBytes(signal.size() * sizeof(float));
+		Flow::Buffer result = instance.makeReadWrite("fft_result").withSizeBytes(signal.size() * sizeof(float));
+		ops::fft(input, spectrum, desc);
+
+		const auto bins = spectrum.getValues<float>();
+		const std::size_t step = std::max<std::size_t>(1, nx / 97);
+		bool match = true;
+		for (uint32_t b = 0; b < batch; ++b)
+			for (std::size_t k = 0; k < nx; k += step)
+				match = match && bin_matches(bins, std::size_t(b) * nx + k, dft_bin(x, std::size_t(b) * nx, 1, nx, k), fft_tolerance(nx));
+		CHECK(match);
+
+		ops::fft(spectrum, result, desc, ops::FftDirection::Inverse);
+		CHECK(round_trip_matches(result, signal, nx));
+	}
+
+	// 2D complex transform.
+	{
+		const ops::FftDesc desc{12, 35, 2};
+		const auto signal = random_floats(std::size_t(2) * 12 * 35 * 2, 1235);
+		const auto expected = dft_2d(to_complex(signal), desc.nx, desc.ny, desc.batch);
+
+		Flow::Buffer input = instance.makeReadWrite("fft_input").fromVector(signal);
+		Flow::Buffer spectrum = instance.makeReadWrite("fft_spectrum").withSizeBytes(signal.size() * sizeof(float));
+		Flow::Buffer result = instance.makeReadWrite("fft_result").withSizeBytes(signal.size() * sizeof(float));
+		ops::fft(input, spectrum, desc);
+
+		const auto bins = spectrum.getValues<float>();
+		bool match = true;
+		for (std::size_t i = 0; i < expected.size(); ++i)
+			match = match && bin_matches(bins, i, expected[i], fft_tolerance(12 * 35));
+		CHECK(match);
+
+		ops::fft(spectrum, result, desc, ops::FftDirection::Inverse);
+		CHECK(round_trip_matches(result, signal, 12 * 35));
+	}
+
+	// Real transforms keep the nx / 2 + 1 non-redundant bins of each row.
+	const ops::FftDesc realCases[] = {
+		{1, 1, 3, ops::FftKind::RealToComplex},
+		{2, 1, 3, ops::FftKind::RealToComplex},
+		{90, 1, 3, ops::FftKind::RealToComplex},
+		{1000, 1, 3, ops::FftKind::RealToComplex},
+		{30030, 1, 1, ops::FftKind::RealToComplex},
+		{20, 9, 2, ops::FftKind::RealToComplex},
+	};
+	for (const ops::FftDesc& desc : realCases)
+	{
+		const std::size_t points = std::size_t(desc.nx) * desc.ny;
+		const uint32_t rowLength = desc.nx / 2 + 1;
+		const auto signal = random_floats(points * desc.batch, points + desc.batch);
+		const std::vector<Complex> x(signal.begin(), signal.end());
+
+		Flow::Buffer input = instance.makeReadWrite("fft_input").fromVector(signal);
+		Flow::Buffer spectrum = instance.makeReadWrite("fft_spectrum").withSizeBytes(std::size_t(2) * rowLength * desc.ny * desc.batch * sizeof(float));
+		Flow::Buffer result = instance.makeReadWrite("fft_result").withSizeBytes(signal.size() * sizeof(float));
+		ops::fft(input, spectrum, desc);
+
+		const auto bins = spectrum.getValues<float>();
+		bool match = true;
+		if (desc.ny == 1)
+		{
+			const std::size_t step = std::max<std::size_t>(1, rowLength / 97);
+			for (uint32_t b = 0; b < desc.batch; ++b)
+				for (std::size_t k = 0; k < rowLength; k += step)
+					match = match && bin_matches(bins, std::size_t(b) * rowLength + k, dft_bin(x, std::size_t(b) * desc.nx, 1, desc.nx, k),
+					                             fft_tolerance(desc.nx));
+		}
+		else
+		{
+			const auto expected = dft_2d(x, desc.nx, desc.ny, desc.batch);
+			for (std::size_t r = 0; r < std::size_t(desc.ny) * desc.batch; ++r)
+				for (uint32_t k = 0; k < rowLength; ++k)
+					match = match && bin_matches(bins, r * rowLength + k, expected[r * desc.nx + k], fft_tolerance(points));
+		}
+		CHECK(match);
+
+		ops::fft(spectrum, result, desc, ops::FftDirection::Inverse);
+		CHECK(round_trip_matches(result, signal, points));
+	}
+
+	Flow::Buffer input = instance.makeReadWrite("fft_input").fromVector(random_floats(16, 16));
+	CHECK(throws([&] { ops::fft(input, input, ops::FftDesc{0}); }));
+	CHECK(throws([&] { ops::fft(input, input, ops::FftDesc{17}); })); // prime factor above 13
+}
+
+// ----- spmv -----
+
+struct HostCsr {
+	uint32_t rows = 0;
+	uint32_t cols = 0;
+	std::vector<uint32_t> offsets{0};
+	std::vector<uint32_t> columns;
+	std::vector<float> values;
+
+	ops::CsrView view() const { return {rows, cols, offsets, columns, values}; }
+};
+
+// Row lengths in [minLength, maxLength]; row `longRow` (when longLength is set) gets longLength nonzeros.
+static HostCsr random_csr(uint32_t rows, uint32_t cols, uint32_t minLength, uint32_t maxLength,
+                          uint32_t longRow = 0, uint32_t longLength = 0)
+{
+	HostCsr csr;
+	csr.rows = rows;
+	csr.cols = cols;
+	const auto lengths = random_values<uint32_t>(rows, rows * 31 + cols, maxLength - minLength + 1, minLength);
+	for (uint32_t r = 0; r < rows; ++r)
+	{
+		const uint32_t length = (longLength && r == longRow) ? longLength : lengths[r];
+		const auto columns = random_values<uint32_t>(length, r + 1, cols);
+		const auto values = random_floats(length, r + rows + 2);
+		csr.columns.insert(csr.columns.end(), columns.begin(), columns.end());
+		csr.values.insert(csr.values.end(), values.begin(), values.end());
+		csr.offsets.push_back(static_cast<uint32_t>(csr.columns.size()));
+	}
+	return csr;
+}
+
+// y = alpha * A * x + beta * y, with each row's tolerance scaled by the magnitude of its terms.
+static bool spmv_matches(const HostCsr& csr, const std::vector<float>& x, const std::vector<float>& y0,
+                         float alpha, float beta, const std::vector<float>& y)
+{
+	for (uint32_t r = 0; r < csr.rows; ++r)
+	{
+		double sum = 0.0;
+		double magnitude = 0.0;
+		for (uint32_t i = csr.offsets[r]; i < csr.offsets[r + 1]; ++i)
+		{
+			sum += double(csr.values[i]) * x[csr.columns[i]];
+			magnitude += std::abs(double(csr.values[i]) * x[csr.columns[i]]);
+		}
+		const double expected = alpha * sum + (beta != 0.0f ? double(beta) * y0[r] : 0.0);
+		const double tolerance = 1e-5 * (std::abs(alpha) * magnitude + std::abs(beta * y0[r]) + 1.0);
+		if (!(std::abs(y[r] - expected) <= tolerance))
+			return false;
+	}
+	return true;
+}
+
+static void check_spmv(Flow::Instance& instance, const HostCsr& csr, ops::SparseFormat format, uint32_t sliceHeight,
+                       ops::SpmvAlgorithm algorithm)
+{
+	const ops::SparseMatrix matrix = ops::makeSparseMatrix(instance, "spmv_matrix", csr.view(), format, sliceHeight);
+	const auto x = random_floats(std::max(csr.cols, 1u), csr.cols + 5);
+	const auto y0 = random_floats(std::max(csr.rows, 1u), csr.rows + 6);
+	Flow::Buffer xBuffer = instance.makeReadWrite("spmv_x").fromVector(x);
+	Flow::Buffer yBuffer = instance.makeReadWrite("spmv_y").fromVector(y0);
+
+	ops::spmv(matrix, xBuffer, yBuffer, 1.5f, 0.5f, algorithm);
+	CHECK(spmv_matches(csr, x, y0, 1.5f, 0.5f, yBuffer.getValues<float>()));
+
+	// With beta == 0, y is not read: NaNs in it must not leak into the result.
+	yBuffer.setValues(std::vector<float>(y0.size(), std::numeric_limits<float>::quiet_NaN()));
+	ops::spmv(matrix, xBuffer, yBuffer, 1.0f, 0.0f, algorithm);
+	CHECK(spmv_matches(csr, x, y0, 1.0f, 0.0f, yBuffer.getValues<float>()));
+}
+
+static void test_spmv(Flow::Instance& instance)
+{
+	struct Case {
+		HostCsr csr;
+		bool padded; // small enough to pad every row to the longest for Ell
+	};
+	const Case cases[] = {
+		{random_csr(1, 1, 1, 1), true},
+		{random_csr(7, 5, 0, 0), true},                 // no nonzeros
+		{random_csr(1000, 777, 0, 40), true},           // empty rows in between
+		{random_csr(20000, 3000, 0, 8, 123, 2500), false}, // one long row: Auto picks merge path
+	};
+	for (const Case& c : cases)
+	{
+		for (ops::SpmvAlgorithm algorithm : {ops::SpmvAlgorithm::Auto, ops::SpmvAlgorithm::RowSplit, ops::SpmvAlgorithm::MergePath})
+			check_spmv(instance, c.csr, ops::SparseFormat::Csr, 32, algorithm);
+		check_spmv(instance, c.csr, ops::SparseFormat::Sell, 32, ops::SpmvAlgorithm::Auto);
+		check_spmv(instance, c.csr, ops::SparseFormat::Sell, 5, ops::SpmvAlgorithm::Auto);
+		if (c.padded)
+			check_spmv(instance, c.csr, ops::SparseFormat::Ell, 32, ops::SpmvAlgorithm::Auto);
+	}
+
+	// A matrix without rows leaves y untouched.
+	const HostCsr empty = random_csr(0, 4, 0, 0);
+	const ops::SparseMatrix matrix = ops::makeSparseMatrix(instance, "spmv_matrix", empty.view());
+	Flow::Buffer x = instance.makeReadWrite("spmv_x").fromVector(random_floats(4, 4));
+	Flow::Buffer y = instance.makeReadWrite("spmv_y").fromVector(std::vector<float>{42.0f});
+	ops::spmv(matrix, x, y);
+	CHECK(y.getValues<float>() == std::vector<float>{42.0f});
+}
+
+// ----- segmented_reduce, reduce_by_key -----
+
+template<class T>
+static T reduce_identity(ops::ReduceOp op)
+{
+	if (op == ops::ReduceOp::Sum)
+		return T(0);
+	if constexpr (std::numeric_limits<T>::has_infinity)
+		return (op == ops::ReduceOp::Min) ? std::numeric_limits<T>::infinity() : -std::numeric_limits<T>::infinity();
+	else
+		return (op == ops::ReduceOp::Min) ? std::numeric_limits<T>::max() : std::numeric_limits<T>::lowest();
+}
+
+template<class T>
+static T reduce_combine(ops::ReduceOp op, T a, T b)
+{
+	switch (op)
+	{
+		case ops::ReduceOp::Min: return std::min(a, b);
+		case ops::ReduceOp::Max: return std::max(a, b);
+		default:                 return a + b;
+	}
+}
+
+// Segments of 1 to 599 elements with every fourth one empty, and a trailing empty segment.
+static std::vector<uint32_t> random_offsets(std::size_t count, uint64_t seed)
+{
+	const auto words = random_words(count + 1, seed);
+	std::vector<uint32_t> offsets{0};
+	for (std::size_t i = 0; offsets.back() < count; ++i)
+	{
+		const uint64_t length = (i % 4 == 3) ? 0 : 1 + words[i % words.size()] % 599;
+		offsets.push_back(static_cast<uint32_t>(std::min<uint64_t>(offsets.back() + length, count)));
+	}
+	offsets.push_back(static_cast<uint32_t>(count));
+	return offsets;
+}
+
+template<class T>
+static void check_segmented_reduce(Flow::Instance& instance, const std::vector<T>& values, const std::vector<uint32_t>& offsets, ops::ReduceOp op)
+{
+	const std::size_t segments = offsets.size() - 1;
+	std::vector<T> expected(segments, reduce_identity<T>(op));
+	for (std::size_t s = 0; s < segments; ++s)
+		for (uint32_t i = offsets[s]; i < offsets[s + 1]; ++i)
+			expected[s] = reduce_combine(op, expected[s], values[i]);
+
+	Flow::Buffer input = instance.makeReadWrite("segmented_values").fromVector(values);
+	Flow::Buffer offsetBuffer = instance.makeReadWrite("segmented_offsets").fromVector(offsets);
+	Flow::Buffer output = instance.makeReadWrite("segmented_output").withSizeBytes(std::max<std::size_t>(segments, 1) * sizeof(T));
+	ops::segmented_reduce<T>(input, offsetBuffer, output, op);
+	CHECK(prefix(output.getValues<T>(), segments) == expected);
+}
+
+template<class T>
+static void check_reduce_by_key(Flow::Instance& instance, const std::vector<uint32_t>& keys, const std::vector<T>& values, ops::ReduceOp op)
+{
+	std::vector<uint32_t> runKeys;
+	std::vector<T> runValues;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+	{
+		if (i == 0 || keys[i] != keys[i - 1])
+		{
+			runKeys.push_back(keys[i]);
+			runValues.push_back(values[i]);
+		}
+		else
+			runValues.back() = reduce_combine(op, runValues.back(), values[i]);
+	}
+
+	Flow::Buffer keyBuffer = instance.makeReadWrite("by_key_keys").fromVector(keys);
+	Flow::Buffer valueBuffer = instance.makeReadWrite("by_key_values").fromVector(values);
+	Flow::Buffer keysOut = instance.makeReadWrite("by_key_keys_out").withSizeBytes(keys.size() * sizeof(uint32_t));
+	Flow::Buffer valuesOut = instance.makeReadWrite("by_key_values_out").withSizeBytes(values.size() * sizeof(T));
+	Flow::Buffer count = instance.makeReadWrite("by_key_count").withSizeBytes(sizeof(ops::CompactCount));
+	ops::reduce_by_key<T>(keyBuffer, valueBuffer, keysOut, valuesOut, count, op);
+
+	CHECK(count.getValues<uint32_t>()[3] == runKeys.size());
+	CHECK(prefix(keysOut.getValues<uint32_t>(), runKeys.size()) == runKeys);
+	CHECK(prefix(valuesOut.getValues<T>(), runValues.size()) == runValues);
+}
+
+static void test_segmented_reduce(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		const auto offsets = random_offsets(count, count);
+		const auto words = random_values<uint32_t>(count, count + 1, 1000);
+		const auto ints = random_values<int32_t>(count, count + 2, 1000, -500);
+		const auto floats = random_values<float>(count, count + 3, 8, -4);
+		for (ops::ReduceOp op : {ops::ReduceOp::Sum, ops::ReduceOp::Min, ops::ReduceOp::Max})
+		{
+			check_segmented_reduce(instance, words, offsets, op);
+			check_segmented_reduce(instance, ints, offsets, op);
+			check_segmented_reduce(instance, floats, offsets, op);
+		}
+
+		// Sorted keys in runs of 1 to 300.
+		std::vector<uint32_t> keys(count);
+		const auto runs = random_words(count, count + 4);
+		uint32_t key = 0;
+		for (std::size_t i = 0, run = 0; i < count; ++run)
+		{
+			const std::size_t length = std::min<std::size_t>(1 + runs[run] % 300, count - i);
+			std::fill_n(keys.begin() + i, length, key);
+			key += 1 + static_cast<uint32_t>(runs[run] % 3);
+			i += length;
+		}
+		check_reduce_by_key(instance, keys, words, ops::ReduceOp::Sum);
+		check_reduce_by_key(instance, keys, floats, ops::ReduceOp::Max);
+	}
+
+	// No segments: nothing to write.
+	Flow::Buffer values = instance.makeReadWrite("segmented_values").fromVector(iota_values(16));
+	Flow::Buffer offsets = instance.makeReadWrite("segmented_offsets").fromVector(std::vector<uint32_t>{0});
+	Flow::Buffer output = instance.makeReadWrite("segmented_output").fromVector(std::vector<uint32_t>{7});
+	ops::segmented_reduce<uint32_t>(values, offsets, output);
+	CHECK(output.getValues<uint32_t>() == std::vector<uint32_t>{7});
+}
+
+// ----- conv2d, stencil2d -----
+
+// Maps a coordinate outside [0, size) as BorderMode does; -1 reads as zero.
+static int resolve_border(int c, int size, ops::BorderMode border)
+{
+	if (c >= 0 && c < size)
+		return c;
+	switch (border)
+	{
+		case ops::BorderMode::Zero:
+			return -1;
+		case ops::BorderMode::Clamp:
+			return std::clamp(c, 0, size - 1);
+		case ops::BorderMode::Wrap:
+			return ((c % size) + size) % size;
+		case ops::BorderMode::Mirror:
+		{
+			const int period = std::max(2 * size - 2, 1);
+			c = ((c % period) + period) % period;
+			return (c >= size) ? period - c : c;
+		}
+	}
+	return -1;
+}
+
+// Full (not factored) kernelWidth x kernelHeight weights applied desc.steps times.
+static std::vector<float> filter_reference(std::vector<float> image, const std::vector<float>& weights, const ops::Conv2dDesc& desc, bool flip)
+{
+	const int width = static_cast<int>(desc.width);
+	const int height = static_cast<int>(desc.height);
+	const int kw = static_cast<int>(desc.kernelWidth);
+	const int kh = static_cast<int>(desc.kernelHeight);
+	std::vector<float> out(image.size());
+	for (uint32_t step = 0; step < desc.steps; ++step)
+	{
+		for (uint32_t b = 0; b < desc.batch; ++b)
+		{
+			const std::size_t base = std::size_t(b) * width * height;
+			for (int y = 0; y < height; ++y)
+				for (int x = 0; x < width; ++x)
+				{
+					double sum = 0.0;
+					for (int ky = 0; ky < kh; ++ky)
+						for (int kx = 0; kx < kw; ++kx)
+						{
+							const int sx = resolve_border(x + kx - kw / 2, width, desc.border);
+							const int sy = resolve_border(y + ky - kh / 2, height, desc.border);
+							if (sx < 0 || sy < 0)
+								continue;
+							const int w = flip ? kw * kh - 1 - (ky * kw + kx) : ky * kw + kx;
+							sum += double(weights[w]) * image[base + std::size_t(sy) * width + sx];
+						}
+					out[base + std::size_t(y) * width + x] = static_cast<float>(sum);
+				}
+		}
+		std::swap(image, out);
+	}
+	return image;
+}
+
+static void test_conv2d(Flow::Instance& instance)
+{
+	using ops::BorderMode;
+	const ops::Conv2dDesc cases[] = {
+		{1, 1, 1, 3, 3, BorderMode::Clamp},
+		{1, 5, 1, 3, 5, BorderMode::Mirror},
+		{37, 23, 2, 5, 3, BorderMode::Mirror},
+		{300, 170, 1, 3, 3, BorderMode::Zero},
+		{64, 48, 1, 7, 7, BorderMode::Wrap, 3},
+		{45, 33, 3, 1, 9, BorderMode::Clamp, 2},
+	};
+
+	for (const ops::Conv2dDesc& desc : cases)
+	{
+		const std::size_t pixels = std::size_t(desc.width) * desc.height * desc.batch;
+		const auto image = random_floats(pixels, pixels);
+		// Weights summing to at most 1 keep repeated steps in range.
+		auto weights = random_floats(std::size_t(desc.kernelWidth) * desc.kernelHeight, pixels + 1);
+		for (auto& weight : weights)
+			weight /= static_cast<float>(weights.size());
+		const float tolerance = 1e-5f * static_cast<float>(desc.steps * weights.size());
+
+		Flow::Buffer input = instance.makeReadWrite("conv_input").fromVector(image);
+		Flow::Buffer output = instance.makeReadWrite("conv_output").withSizeBytes(pixels * sizeof(float));
+		Flow::Buffer weightBuffer = instance.makeReadWrite("conv_weights").fromVector(weights);
+
+		ops::conv2d(input, output, weightBuffer, desc);
+		CHECK(close_to(output.getValues<float>(), filter_reference(image, weights, desc, true), tolerance));
+		ops::stencil2d(input, output, weightBuffer, desc);
+		CHECK(close_to(output.getValues<float>(), filter_reference(image, weights, desc, false), tolerance));
+
+		// In place, and as the two passes of a rank-1 kernel.
+		ops::stencil2d(input, input, weightBuffer, desc);
+		CHECK(close_to(input.getValues<float>(), filter_reference(image, weights, desc, false), tolerance));
+
+		const auto rowFactor = random_floats(desc.kernelWidth, pixels + 2);
+		const auto columnFactor = random_floats(desc.kernelHeight, pixels + 3);
+		std::vector<float> outer(weights.size());
+		for (uint32_t ky = 0; ky < desc.kernelHeight; ++ky)
+			for (uint32_t kx = 0; kx < desc.kernelWidth; ++kx)
+				outer[ky * desc.kernelWidth + kx] = columnFactor[ky] * rowFactor[kx] / static_cast<float>(weights.size());
+		std::vector<float> factors;
+		CHECK(ops::factor_separable(outer, desc.kernelWidth, desc.kernelHeight, factors));
+
+		ops::Conv2dDesc separable = desc;
+		separable.separable = true;
+		input.setValues(image);
+		weightBuffer = instance.makeReadWrite("conv_weights").fromVector(factors);
+		ops::conv2d(input, output, weightBuffer, separable);
+		CHECK(close_to(output.getValues<float>(), filter_reference(image, outer, desc, true), 10 * tolerance));
+	}
+
+	// A rank-2 kernel has no factors.
+	std::vector<float> factors;
+	CHECK(!ops::factor_separable({1, 0, 0, 0, 1, 0, 0, 0, 1}, 3, 3, factors));
+
+	// Empty images leave the output untouched.
+	Flow::Buffer input = instance.makeReadWrite("conv_input").fromVector(std::vector<float>{1.0f});
+	Flow::Buffer output = instance.makeReadWrite("conv_output").fromVector(std::vector<float>{2.0f});
+	Flow::Buffer weights = instance.makeReadWrite("conv_weights").fromVector(std::vector<float>(9, 1.0f));
+	ops::conv2d(input, output, weights, ops::Conv2dDesc{0, 10});
+	CHECK(output.getValues<float>() == std::vector<float>{2.0f});
+}
+
+// ----- top_k -----
+
+template<class T>
+static void check_top_k_once(Flow::Instance& instance, const Flow::Buffer& input, const std::vector<T>& values, uint32_t k, ops::TopKOrder order)
+{
+	auto ranking = iota_values(values.size());
+	std::stable_sort(ranking.begin(), ranking.end(), [&](uint32_t a, uint32_t b) {
+		return (order == ops::TopKOrder::Largest) ? values[a] > values[b] : values[a] < values[b];
+	});
+	ranking.resize(k);
+	std::vector<T> best(k);
+	for (uint32_t i = 0; i < k; ++i)
+		best[i] = values[ranking[i]];
+
+	Flow::Buffer bestValues = instance.makeReadWrite("top_k_values").withSizeBytes(std::max(k, 1u) * sizeof(T));
+	Flow::Buffer bestIndices = instance.makeReadWrite("top_k_indices").withSizeBytes(std::max(k, 1u) * sizeof(uint32_t));
+	ops::top_k<T>(input, k, bestValues, bestIndices, order);
+	CHECK(prefix(bestValues.getValues<T>(), k) == best);
+	CHECK(prefix(bestIndices.getValues<uint32_t>(), k) == ranking);
+}
+
+template<class T>
+static void check_top_k(Flow::Instance& instance, const std::vector<T>& values)
+{
+	Flow::Buffer input = instance.makeReadWrite("top_k_input").fromVector(values);
+	// Up to 256 winners per tile take the tile path; 300 and more use radix select.
+	for (std::size_t k : {std::size_t(0), std::size_t(1), std::size_t(37), std::size_t(300), std::size_t(1000), values.size()})
+		if (k <= values.size())
+			for (ops::TopKOrder order : {ops::TopKOrder::Largest, ops::TopKOrder::Smallest})
+				check_top_k_once(instance, input, values, static_cast<uint32_t>(k), order);
+
+	Flow::Buffer scratch = instance.makeReadWrite("top_k_values").withSizeBytes((values.size() + 1) * sizeof(T));
+	CHECK(throws([&] { ops::top_k<T>(input, static_cast<uint32_t>(values.size() + 1), scratch, scratch); }));
+}
+
+static void test_top_k(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		check_top_k(instance, random_values<uint32_t>(count, count, count / 3 + 1));
+		check_top_k(instance, random_values<int32_t>(count, count + 1, 2001, -1000));
+		check_top_k(instance, random_values<float>(count, count + 2, 2001, -1000));
+		if (instance.pimpl->caps.shaderInt64)
+			check_top_k(instance, random_values<uint64_t>(count, count + 3));
+	}
+}
+
+// ----- gather, scatter, scatter_add -----
+
+static void check_gather(Flow::Instance& instance, std::size_t count, std::size_t elementBytes)
+{
+	const auto inputWords = random_values<uint32_t>(div_up((count + 3) * elementBytes, 4), count * elementBytes);
+	const auto inputBytes = to_bytes(inputWords);
+	const std::size_t inputElements = inputBytes.size() / elementBytes;
+
+	// About one index in nine is past the end and gathers zeros.
+	const auto indices = random_values<uint32_t>(count, count + elementBytes, inputElements + inputElements / 8 + 1);
+	std::vector<uint8_t> expected(count * elementBytes, 0);
+	for (std::size_t i = 0; i < count; ++i)
+		if (indices[i] < inputElements)
+			std::memcpy(&expected[i * elementBytes], &inputBytes[indices[i] * elementBytes], elementBytes);
+
+	Flow::Buffer input = instance.makeReadWrite("gather_input").fromVector(inputWords);
+	Flow::Buffer indexBuffer = instance.makeReadWrite("gather_indices").fromVector(indices);
+	Flow::Buffer output = instance.makeReadWrite("gather_output").fromVector(std::vector<uint32_t>(div_up(count * elementBytes, 4), ~0u));
+	ops::gather(input, indexBuffer, output, elementBytes);
+	CHECK(bytes_equal(output.getValues<uint32_t>(), expected));
+}
+
+static void check_scatter(Flow::Instance& instance, std::size_t count, std::size_t elementBytes)
+{
+	const auto initialWords = random_values<uint32_t>(div_up((count + 5) * elementBytes, 4), count + elementBytes);
+	std::vector<uint8_t> expected = to_bytes(initialWords);
+	const std::size_t outputElements = expected.size() / elementBytes;
+
+	// Distinct targets; every seventh index is past the end and skipped.
+	auto indices = iota_values(outputElements);
+	std::shuffle(indices.begin(), indices.end(), std::mt19937(static_cast<uint32_t>(count)));
+	indices.resize(count);
+	for (std::size_t i = 3; i < count; i += 7)
+		indices[i] = static_cast<uint32_t>(outputElements + i);
+
+	const auto inputWords = random_values<uint32_t>(div_up(count * elementBytes, 4), count * 3 + elementBytes);
+	const auto inputBytes = to_bytes(inputWords);
+	for (std::size_t i = 0; i < count; ++i)
+		if (indices[i] < outputElements)
+			std::memcpy(&expected[indices[i] * elementBytes], &inputBytes[i * elementBytes], elementBytes);
+
+	Flow::Buffer input = instance.makeReadWrite("gather_input").fromVector(inputWords);
+	Flow::Buffer indexBuffer = instance.makeReadWrite("gather_indices").fromVector(indices);
+	Flow::Buffer output = instance.makeReadWrite("gather_output").fromVector(initialWords);
+	ops::scatter(input, indexBuffer, output, elementBytes);
+	CHECK(bytes_equal(output.getValues<uint32_t>(), expected));
+}
+
+// Repeated indices accumulate; elements are `components` consecutive T values.
+template<class T>
+static void check_scatter_add(Flow::Instance& instance, std::size_t count, uint32_t components, uint64_t range)
+{
+	const std::size_t outputElements = std::max<std::size_t>(count / 10, 1);
+	const auto indices = random_values<uint32_t>(count, count, outputElements);
+	const auto values = random_values<T>(count * components, count + 1, range);
+	auto expected = random_values<T>(outputElements * components, count + 2, range);
+
+	Flow::Buffer input = instance.makeReadWrite("scatter_add_input").fromVector(values);
+	Flow::Buffer indexBuffer = instance.makeReadWrite("scatter_add_indices").fromVector(indices);
+	Flow::Buffer output = instance.makeReadWrite("scatter_add_output").fromVector(expected);
+	for (std::size_t i = 0; i < count; ++i)
+		for (uint32_t c = 0; c < components; ++c)
+			expected[std::size_t(indices[i]) * components + c] += values[i * components + c];
+
+	ops::scatter_add<T>(input, indexBuffer, output, components);
+	CHECK(output.getValues<T>() == expected);
+}
+
+static void test_gather(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		for (std::size_t elementBytes : {1u, 2u, 4u, 12u, 16u})
+		{
+			check_gather(instance, count, elementBytes);
+			check_scatter(instance, count, elementBytes);
+		}
+		check_scatter_add<uint32_t>(instance, count, 3, 1000);
+		check_scatter_add<float>(instance, count, 1, 8); // whole numbers: exact in any order
+		if (instance.pimpl->caps.shaderInt64 && instance.pimpl->caps.shaderBufferInt64Atomics)
+			check_scatter_add<uint64_t>(instance, count, 2, 0);
+	}
+}
+
+// ----- random -----
+
+// Refilling gives the same values, and so does filling the stream in two pieces.
+template<class T>
+static std::vector<T> check_random_stream(Flow::Instance& instance, std::size_t count, const ops::RandomDesc& desc)
+{
+	Flow::Buffer whole = instance.makeReadWrite("random_whole").withSizeBytes(count * sizeof(T), false);
+	ops::random<T>(whole, desc);
+	const auto values = whole.getValues<T>();
+	ops::random<T>(whole, desc);
+	CHECK(whole.getValues<T>() == values);
+
+	const std::size_t split = count / 3;
+	if (split > 0)
+	{
+		Flow::Buffer head = instance.makeReadWrite("random_head").withSizeBytes(split * sizeof(T), false);
+		Flow::Buffer tail = instance.makeReadWrite("random_tail").withSizeBytes((count - split) * sizeof(T), false);
+		ops::RandomDesc tailDesc = desc;
+		tailDesc.offset += split;
+		ops::random<T>(head, desc);
+		ops::random<T>(tail, tailDesc);
+
+		auto joined = head.getValues<T>();
+		const auto rest = tail.getValues<T>();
+		joined.insert(joined.end(), rest.begin(), rest.end());
+		CHECK(joined == values);
+	}
+	return values;
+}
+
+static void test_random(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		ops::RandomDesc desc;
+		desc.seed = 1234;
+		desc.offset = 77;
+		const auto words = check_random_stream<uint32_t>(instance, count, desc);
+		ops::RandomDesc otherSeed = desc;
+		otherSeed.seed = 1235;
+		if (count >= 7)
+			CHECK(check_random_stream<uint32_t>(instance, count, otherSeed) != words);
+		if (instance.pimpl->caps.shaderInt64)
+			check_random_stream<uint64_t>(instance, count, desc);
+
+		desc.lower = -2.0f;
+		desc.upper = 3.0f;
+		const auto uniform = check_random_stream<float>(instance, count, desc);
+		CHECK(std::all_of(uniform.begin(), uniform.end(), [](float v) { return v >= -2.0f && v < 3.0f; }));
+
+		desc.distribution = ops::Distribution::Normal;
+		desc.mean = 1.0f;
+		desc.stddev = 2.0f;
+		const auto normal = check_random_stream<float>(instance, count, desc);
+
+		// Moments within five standard errors.
+		if (count >= 1000)
+		{
+			const double n = static_cast<double>(count);
+			const double uniformMean = std::accumulate(uniform.begin(), uniform.end(), 0.0) / n;
+			CHECK(std::abs(uniformMean - 0.5) < 5.0 * (5.0 / std::sqrt(12.0)) / std::sqrt(n));
+
+			const double mean = std::accumulate(normal.begin(), normal.end(), 0.0) / n;
+			double squares = 0.0;
+			for (float v : normal)
+				squares += (v - mean) * (v - mean);
+			const double stddev = std::sqrt(squares / (n - 1.0));
+			CHECK(std::abs(mean - 1.0) < 5.0 * 2.0 / std::sqrt(n));
+			CHECK(std::abs(stddev - 2.0) < 5.0 * 2.0 / std::sqrt(2.0 * n));
+		}
+	}
+}
+
+// ----- transpose, aos_to_soa, soa_to_aos -----
+
+static void check_transpose(Flow::Instance& instance, uint32_t rows, uint32_t cols, std::size_t elementBytes, uint32_t batch)
+{
+	const std::size_t words = elementBytes / sizeof(uint32_t);
+	const std::size_t elements = std::size_t(rows) * cols * batch;
+	const auto input = random_values<uint32_t>(std::max<std::size_t>(elements * words, 1), elements + elementBytes);
+	std::vector<uint32_t> expected(std::max<std::size_t>(elements * words, 1), 0);
+	for (uint32_t b = 0; b < batch; ++b)
+		for (uint32_t r = 0; r < rows; ++r)
+			for (uint32_t c = 0; c < cols; ++c)
+			{
+				const std::size_t from = (std::size_t(b) * rows * cols + std::size_t(r) * cols + c) * words;
+				const std::size_t to = (std::size_t(b) * rows * cols + std::size_t(c) * rows + r) * words;
+				std::copy_n(input.begin() + from, words, expected.begin() + to);
+			}
+
+	Flow::Buffer in = instance.makeReadWrite("transpose_input").fromVector(input);
+	Flow::Buffer out = instance.makeReadWrite("transpose_output").withSizeBytes(expected.size() * sizeof(uint32_t));
+	ops::transpose(in, out, rows, cols, elementBytes, batch);
+	CHECK(out.getValues<uint32_t>() == expected);
+}
+
+static void check_aos_soa(Flow::Instance& instance, std::size_t count)
+{
+	// struct { vec2 position; float mass; uint padding; uint id; }, with id skipped.
+	constexpr uint32_t strideWords = 5;
+	const Flow::shader_meta::ElementField layout[] = {
+		{"position", "vec2", 0, 8},
+		{"mass", "float", 8, 4},
+		{"id", "uint", 16, 4},
+	};
+
+	const auto structs = random_values<uint32_t>(count * strideWords, count);
+	std::vector<uint32_t> positions(2 * count);
+	std::vector<uint32_t> masses(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		positions[2 * i] = structs[i * strideWords];
+		positions[2 * i + 1] = structs[i * strideWords + 1];
+		masses[i] = structs[i * strideWords + 2];
+	}
+
+	Flow::Buffer aos = instance.makeReadWrite("layout_aos").fromVector(structs);
+	std::array<Flow::Buffer, 3> fields{
+		instance.makeReadWrite("layout_position").withSizeBytes(positions.size() * sizeof(uint32_t)),
+		instance.makeReadWrite("layout_mass").withSizeBytes(masses.size() * sizeof(uint32_t)),
+		Flow::Buffer{},
+	};
+	ops::aos_to_soa(aos, strideWords * sizeof(uint32_t), layout, fields);
+	CHECK(fields[0].getValues<uint32_t>() == positions);
+	CHECK(fields[1].getValues<uint32_t>() == masses);
+
+	// Back the other way: position and mass change, padding and the skipped id keep their words.
+	const auto newPositions = random_values<uint32_t>(positions.size(), count + 1);
+	const auto newMasses = random_values<uint32_t>(masses.size(), count + 2);
+	auto expected = structs;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		expected[i * strideWords] = newPositions[2 * i];
+		expected[i * strideWords + 1] = newPositions[2 * i + 1];
+		expected[i * strideWords + 2] = newMasses[i];
+	}
+	fields[0].setValues(newPositions);
+	fields[1].setValues(newMasses);
+	ops::soa_to_aos(fields, strideWords * sizeof(uint32_t), layout, aos);
+	CHECK(aos.getValues<uint32_t>() == expected);
+}
+
+static void test_layout(Flow::Instance& instance)
+{
+	for (std::size_t elementBytes : {4u, 8u, 16u})
+	{
+		check_transpose(instance, 1, 1, elementBytes, 1);
+		check_transpose(instance, 7, 5, elementBytes, 1);
+		check_transpose(instance, 33, 65, elementBytes, 3);
+		check_transpose(instance, 300, 1000, elementBytes, 1);
+		check_transpose(instance, 0, 9, elementBytes, 1);
+	}
+	for (std::size_t count : kSizes)
+		check_aos_soa(instance, count);
+}
+
+// ----- evaluate -----
+
+static void test_evaluate(Flow::Instance& instance)
+{
+	for (std::size_t count : kSizes)
+	{
+		const auto a = random_floats(count, count);
+		const auto b = random_floats(count, count + 1);
+		const auto c = random_floats(count, count + 2);
+		Flow::Buffer bufferA = instance.makeReadWrite("evaluate_a").fromVector(a);
+		Flow::Buffer bufferB = instance.makeReadWrite("evaluate_b").fromVector(b);
+		Flow::Buffer bufferC = instance.makeReadWrite("evaluate_c").fromVector(c);
+		Flow::Buffer out = instance.makeReadWrite("evaluate_out").withSizeBytes(count * sizeof(float));
+
+		std::vector<float> expected(count);
+		for (std::size_t i = 0; i < count; ++i)
+			expected[i] = std::max(a[i] * b[i] + c[i], 0.0f);
+		ops::evaluate(out, ops::relu(bufferA * bufferB + bufferC));
+		CHECK(close_to(out.getValues<float>(), expected, 1e-6f));
+
+		for (std::size_t i = 0; i < count; ++i)
+			expected[i] = (a[i] > 0.0f ? std::sqrt(std::abs(b[i])) : -a[i]) * 2.0f + std::exp(c[i]);
+		ops::evaluate(out, ops::select(ops::greater(bufferA, 0.0f), ops::sqrt(ops::abs(bufferB)), -bufferA) * 2.0f + ops::exp(bufferC));
+		CHECK(close_to(out.getValues<float>(), expected, 1e-5f));
+
+		// The output may also be an input.
+		for (std::size_t i = 0; i < count; ++i)
+			expected[i] = expected[i] * 0.5f - a[i];
+		ops::evaluate(out, out * 0.5f - bufferA);
+		CHECK(close_to(out.getValues<float>(), expected, 1e-5f));
+	}
+}
+
+// ----- Zero elements -----
+
+// Named buffers cannot be empty, so zero-element data reaches the ops as an unallocated
+// buffer, which every op rejects rather than dispatching over garbage.
+static void test_unallocated_buffers(Flow::Instance& instance)
+{
+	const Flow::Buffer empty = instance.makeReadWrite("unallocated");
+	Flow::Buffer data = instance.makeReadWrite("allocated").fromVector(iota_values(16));
+	Flow::Buffer other = instance.makeReadWrite("allocated_other").fromVector(iota_values(16));
+
+	CHECK(throws([&] { ops::reduce<uint32_t>(empty); }));
+	CHECK(throws([&] { ops::scan<uint32_t>(empty, data); }));
+	CHECK(throws([&] { ops::radix_sort<uint32_t>(empty); }));
+	CHECK(throws([&] { ops::histogram<uint32_t>(empty, data, ops::UniformBins<uint32_t>{0, 10, 4}); }));
+	CHECK(throws([&] { ops::compact<uint32_t>(empty, ops::Predicate<uint32_t>{}, data, other); }));
+	CHECK(throws([&] { ops::fill<uint32_t>(empty, 1u); }));
+	CHECK(throws([&] { ops::copy(empty, data); }));
+	CHECK(throws([&] { ops::fft(empty, data, ops::FftDesc{4}); }));
+	CHECK(throws([&] { ops::segmented_reduce<uint32_t>(empty, data, other); }));
+	CHECK(throws([&] { ops::conv2d(empty, data, other, ops::Conv2dDesc{2, 2}); }));
+	CHECK(throws([&] { ops::top_k<uint32_t>(empty, 0, data, other); }));
+	CHECK(throws([&] { ops::gather(data, empty, other, 4); }));
+	CHECK(throws([&] { ops::random<uint32_t>(empty); }));
+	CHECK(throws([&] { ops::transpose(empty, data, 2, 2); }));
+	CHECK(throws([&] { ops::evaluate(empty, data * 2.0f); }));
+}
+
+int main()
+{
+	try
+	{
+		Flow::Instance instance = Flow::makeInstance();
+		test_reduce(instance);
+		test_scan(instance);
+		test_radix_sort(instance);
+		test_gemm(instance);
+		test_histogram(instance);
+		test_compact(instance);
+		test_transfer(instance);
+		test_fft(instance);
+		test_spmv(instance);
+		test_segmented_reduce(instance);
+		test_conv2d(instance);
+		test_top_k(instance);
+		test_gather(instance);
+		test_random(instance);
+		test_layout(instance);
+		test_evaluate(instance);
+		test_unallocated_buffers(instance);
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "FlowVk_OpsTest: " << error.what() << "\n";
+		return 1;
+	}
+
+	return flow_test::exit_code();
+}
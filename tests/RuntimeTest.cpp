@@ -0,0 +1,210 @@
+// Runs the kernels in tests/kernels on a Vulkan device and checks submission modes,
+// recordings and iteration helpers against results computed on the host.
+// Usage: FlowVk_RuntimeTest <spv dir>
+
+#include "Check.hpp"
+
+#include <FlowVk.hpp>
+#include "internal/InstanceImpl.hpp" // white-box checks of deferred submission
+
+#include <filesystem>
+#include <numeric>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static fs::path g_spvDir;
+
+static Flow::Instance make_test_instance(const Flow::InstanceConfig& config = {})
+{
+	Flow::Instance instance = Flow::makeInstance(config);
+	for (const char* kernel : {"add_one", "step", "count_down"})
+		instance.addKernel(kernel, g_spvDir / (std::string(kernel) + ".spv"));
+	return instance;
+}
+
+static std::vector<uint32_t> iota_values(std::size_t count, uint32_t first = 0)
+{
+	std::vector<uint32_t> values(count);
+	std::iota(values.begin(), values.end(), first);
+	return values;
+}
+
+static uint32_t groups_for(std::size_t count)
+{
+	return static_cast<uint32_t>((count + 63) / 64);
+}
+
+// The same dispatches give the same results whether they are submitted one by one
+// or queued and submitted by flush() or by a read of a buffer they use.
+static void test_deferred_matches_immediate()
+{
+	const auto input = iota_values(1000);
+	const uint32_t groups = groups_for(input.size());
+
+	Flow::Instance immediate = make_test_instance();
+	auto immediateValues = immediate.makeReadWrite("values").fromVector(input);
+	for (int i = 0; i < 3; ++i)
+		immediate.runSingleKernel("add_one", groups);
+	const auto immediateResult = immediateValues.getValues<uint32_t>();
+
+	Flow::InstanceConfig config;
+	config.deferred_submission = true;
+	Flow::Instance deferred = make_test_instance(config);
+	auto deferredValues = deferred.makeReadWrite("values").fromVector(input);
+	for (int i = 0; i < 3; ++i)
+		deferred.runSingleKernel("add_one", groups);
+	deferred.flush();
+	const auto deferredResult = deferredValues.getValues<uint32_t>();
+
+	CHECK(immediateResult == iota_values(input.size(), 3));
+	CHECK(deferredResult == immediateResult);
+
+	// Without flush(), reading the buffer submits the queued dispatch.
+	deferred.runSingleKernel("add_one", groups);
+	CHECK(deferredValues.getValues<uint32_t>() == iota_values(input.size(), 4));
+}
+
+// resizeBytes reallocates a buffer the recording bound, so the next submit records again.
+static void test_replay_rerecords_after_resize()
+{
+	Flow::Instance instance = make_test_instance();
+	auto values = instance.makeReadWrite("values").fromVector(std::vector<uint32_t>(256, 0));
+
+	Flow::Replay replay(instance);
+	replay.addKernel("add_one", groups_for(1024));
+	CHECK(!replay.isRecorded());
+	replay.submit();
+	CHECK(replay.isRecorded());
+	replay.submit();
+	CHECK(values.getValues<uint32_t>() == std::vector<uint32_t>(256, 2));
+
+	values.resizeBytes(1024 * sizeof(uint32_t), /*zeroInit*/ true);
+	CHECK(!replay.isRecorded());
+	replay.submit();
+	CHECK(replay.isRecorded());
+	CHECK(values.getValues<uint32_t>() == std::vector<uint32_t>(1024, 1));
+}
+
+// Swapping the storage of `current` and `next` after each step feeds every step the
+// previous one's output, for single dispatches and for a recording alike.
+static void test_swap_storage_ping_pong()
+{
+	constexpr int steps = 5;
+	const auto input = iota_values(300);
+	auto expected = input;
+	for (int s = 0; s < steps; ++s)
+		for (auto& v : expected)
+			v = v * 2u + 1u;
+
+	Flow::Instance instance = make_test_instance();
+	auto current = instance.makeReadWrite("current").fromVector(input);
+	auto next = instance.makeReadWrite("next").withSizeBytes(input.size() * sizeof(uint32_t));
+
+	for (int s = 0; s < steps; ++s)
+	{
+		instance.runSingleKernel("step", groups_for(input.size()));
+		Flow::swapStorage(current, next);
+	}
+	CHECK(current.getValues<uint32_t>() == expected);
+
+	current.setValues(input);
+	Flow::Replay replay(instance);
+	replay.addKernel("step", groups_for(input.size()));
+	for (int s = 0; s < steps; ++s)
+	{
+		replay.submit();
+		Flow::swapStorage(current, next);
+	}
+	CHECK(current.getValues<uint32_t>() == expected);
+}
+
+// In deferred mode swapStorage keeps the queued steps queued: the pending command buffer
+// survives every swap and the steps are only submitted by the read at the end.
+static void test_deferred_swap_submits_nothing()
+{
+	constexpr int steps = 4;
+	const auto input = iota_values(200);
+	auto expected = input;
+	for (int s = 0; s < steps; ++s)
+		for (auto& v : expected)
+			v = v * 2u + 1u;
+
+	Flow::InstanceConfig config;
+	config.deferred_submission = true;
+	Flow::Instance instance = make_test_instance(config);
+	auto current = instance.makeReadWrite("current").fromVector(input);
+	auto next = instance.makeReadWrite("next").withSizeBytes(input.size() * sizeof(uint32_t));
+	instance.flush();
+
+	VkCommandBuffer queued = VK_NULL_HANDLE;
+	for (int s = 0; s < steps; ++s)
+	{
+		instance.runSingleKernel("step", groups_for(input.size()));
+		if (s == 0)
+			queued = instance.pimpl->pendingCmd;
+		Flow::swapStorage(current, next);
+		CHECK(instance.pimpl->pendingCmd == queued);
+	}
+	CHECK(queued != VK_NULL_HANDLE);
+	CHECK(instance.pimpl->is_pending("current") && instance.pimpl->is_pending("next"));
+
+	CHECK(current.getValues<uint32_t>() == expected);
+	CHECK(instance.pimpl->pendingCmd == VK_NULL_HANDLE);
+}
+
+// runUntil stops at the first check that sees the counter at zero, and gives up
+// after maxIterations when it never gets there.
+static void test_run_until_stops()
+{
+	Flow::Instance instance = make_test_instance();
+	auto counter = instance.makeReadWrite("counter").fromVector(std::vector<uint32_t>{37});
+	auto remaining = instance.makeReadWrite("remaining").withSizeBytes(sizeof(uint32_t));
+
+	Flow::ConvergenceOptions options;
+	options.value = remaining;
+	options.stop = Flow::ConvergenceOptions::Stop::WhenZero;
+	options.maxIterations = 1000;
+
+	const auto done = instance.runUntil("count_down", 1, 1, 1, options);
+	CHECK(done.converged);
+	CHECK(done.flag == 0);
+	CHECK(done.iterations >= 37);
+	CHECK(done.iterations < options.maxIterations);
+	CHECK(done.checks < done.iterations);
+	CHECK(counter.getValues<uint32_t>() == std::vector<uint32_t>{0});
+
+	counter.setValues(std::vector<uint32_t>{1'000'000});
+	options.maxIterations = 50;
+	const auto capped = instance.runUntil("count_down", 1, 1, 1, options);
+	CHECK(!capped.converged);
+	CHECK(capped.iterations == 50);
+	CHECK(capped.flag == 1'000'000 - 50);
+	CHECK(counter.getValues<uint32_t>() == std::vector<uint32_t>{1'000'000 - 50});
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2)
+	{
+		std::cerr << "Usage: FlowVk_RuntimeTest <spv dir>\n";
+		return 2;
+	}
+	g_spvDir = argv[1];
+
+	try
+	{
+		test_deferred_matches_immediate();
+		test_replay_rerecords_after_resize();
+		test_swap_storage_ping_pong();
+		test_deferred_swap_submits_nothing();
+		test_run_until_stops();
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "FlowVk_RuntimeTest: " << error.what() << "\n";
+		return 1;
+	}
+
+	return flow_test::exit_code();
+}
@@ -0,0 +1,159 @@
+// Runs FlowVk_ShaderPP on the shaders in tests/shaders and checks the GLSL and metadata it emits.
+// Usage: FlowVk_ShaderPPTest <FlowVk_ShaderPP> <shader dir> <output dir>
+
+#include "Check.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+struct Output {
+	int status = -1;
+	std::string glsl;
+	std::string hpp;
+};
+
+static std::string read_text(const fs::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::ostringstream text;
+	text << file.rdbuf();
+	return text.str();
+}
+
+static Output run_tool(const fs::path& tool, const fs::path& shader, const fs::path& outDir, const std::string& buffers)
+{
+	const fs::path glsl = outDir / (shader.stem().string() + "." + buffers + ".glsl");
+	const fs::path hpp = outDir / (shader.stem().string() + "." + buffers + ".hpp");
+	const std::string command = "\"" + tool.string() + "\" --in \"" + shader.string() + "\" --out-glsl \"" + glsl.string() +
+	                            "\" --out-hpp \"" + hpp.string() + "\" --buffers " + buffers;
+
+	Output out;
+	out.status = std::system(command.c_str());
+	out.glsl = read_text(glsl);
+	out.hpp = read_text(hpp);
+	return out;
+}
+
+static bool contains(const std::string& text, std::string_view part)
+{
+	return text.find(part) != std::string::npos;
+}
+
+// BUFFERS descriptors: one SSBO per @buffer at set 0, consecutive bindings, no push constants.
+static void test_descriptors(const fs::path& tool, const fs::path& shaders, const fs::path& outDir)
+{
+	const Output out = run_tool(tool, shaders / "axpy.comp", outDir, "descriptors");
+	CHECK(out.status == 0);
+
+	CHECK(contains(out.glsl, "layout(set = 0, binding = 0, std430) readonly buffer XBuffer {\n  float data[];\n} x;"));
+	CHECK(contains(out.glsl, "layout(set = 0, binding = 1, std430) buffer YBuffer {\n  float data[];\n} y;"));
+	CHECK(contains(out.glsl, "y.data[i] += 2.0 * x.data[i];"));
+	CHECK(!contains(out.glsl, "push_constant"));
+	CHECK(!contains(out.glsl, "@buffer"));
+
+	CHECK(contains(out.hpp, "namespace Flow::shader_meta::axpy {"));
+	CHECK(contains(out.hpp, "BufferBinding{\"x\", \"float\", Flow::shader_meta::Access::ReadOnly, Flow::shader_meta::Layout::Std430, 0u, 0u, 4u}"));
+	CHECK(contains(out.hpp, "BufferBinding{\"y\", \"float\", Flow::shader_meta::Access::ReadWrite, Flow::shader_meta::Layout::Std430, 0u, 1u, 4u}"));
+	CHECK(!contains(out.hpp, "buffer_model"));
+}
+
+// BUFFERS device_address: buffer_reference blocks whose 8-byte addresses fill the push constants,
+// followed by the element counts that replace data.length().
+static void test_device_address(const fs::path& tool, const fs::path& shaders, const fs::path& outDir)
+{
+	const Output out = run_tool(tool, shaders / "axpy.comp", outDir, "device_address");
+	CHECK(out.status == 0);
+
+	CHECK(contains(out.glsl, "#extension GL_EXT_buffer_reference : require"));
+	CHECK(contains(out.glsl, "layout(buffer_reference, std430) readonly buffer XBuffer {"));
+	CHECK(contains(out.glsl, "layout(push_constant) uniform FlowVkBufferAddresses {"));
+	CHECK(contains(out.glsl, "layout(offset = 0) XBuffer x;"));
+	CHECK(contains(out.glsl, "layout(offset = 8) YBuffer y;"));
+	CHECK(contains(out.glsl, "layout(offset = 16) uint flowvk_count_x;"));
+	CHECK(contains(out.glsl, "layout(offset = 20) uint flowvk_count_y;"));
+	CHECK(contains(out.glsl, "if (i < int(flowvk_count_y))"));
+	CHECK(!contains(out.glsl, ".length()"));
+	CHECK(contains(out.glsl, "y.data[i] += 2.0 * x.data[i];"));
+	CHECK(!contains(out.glsl, "layout(set"));
+
+	CHECK(contains(out.hpp, "Flow::shader_meta::BufferModel::DeviceAddress"));
+	CHECK(contains(out.hpp, ".push_bytes = 24u"));
+	CHECK(contains(out.hpp, "Flow::shader_meta::Layout::Std430, 0u, 0u, 4u, {}, 0u, 16u}"));
+	CHECK(contains(out.hpp, "Flow::shader_meta::Layout::Std430, 0u, 1u, 4u, {}, 8u, 20u}"));
+}
+
+// BUFFERS device_address cannot count the elements of a type it cannot lay out, so reading
+// such a buffer's length is rejected instead of emitting an unusable length().
+static void test_device_address_unsized_length(const fs::path& tool, const fs::path& shaders, const fs::path& outDir)
+{
+	CHECK(run_tool(tool, shaders / "rejected" / "unsized_length.comp", outDir, "device_address").status != 0);
+	CHECK(run_tool(tool, shaders / "rejected" / "unsized_length.comp", outDir, "descriptors").status == 0);
+}
+
+// BUFFERS bindless: every buffer indexes the table at set 0, binding 0 through a 4-byte handle.
+static void test_bindless(const fs::path& tool, const fs::path& shaders, const fs::path& outDir)
+{
+	const Output out = run_tool(tool, shaders / "axpy.comp", outDir, "bindless");
+	CHECK(out.status == 0);
+
+	CHECK(contains(out.glsl, "layout(set = 0, binding = 0, std430) readonly buffer XBuffer {"));
+	CHECK(contains(out.glsl, "layout(set = 0, binding = 0, std430) buffer YBuffer {"));
+	CHECK(contains(out.glsl, "} flowvk_table_y[];"));
+	CHECK(contains(out.glsl, "layout(offset = 0) uint flowvk_handle_x;"));
+	CHECK(contains(out.glsl, "flowvk_table_y[flowvk_handle_y].data[i] += 2.0 * flowvk_table_x[flowvk_handle_x].data[i];"));
+
+	CHECK(contains(out.hpp, "Flow::shader_meta::BufferModel::Bindless"));
+	CHECK(contains(out.hpp, ".push_bytes = 8u"));
+}
+
+// Only `name.data` becomes a table access; a parameter, a struct member and comments
+// sharing the buffer's name stay as written.
+static void test_bindless_scope(const fs::path& tool, const fs::path& shaders, const fs::path& outDir)
+{
+	const Output out = run_tool(tool, shaders / "bindless_scope.comp", outDir, "bindless");
+	CHECK(out.status == 0);
+
+	CHECK(contains(out.glsl, "#extension GL_EXT_nonuniform_qualifier : require"));
+	CHECK(contains(out.glsl, "layout(set = 0, binding = 0, std430) readonly buffer SrcBuffer"));
+	CHECK(contains(out.glsl, "} flowvk_table_src[];"));
+	CHECK(contains(out.glsl, "layout(offset = 4) uint flowvk_handle_dst;"));
+
+	CHECK(contains(out.glsl, "float helper(float src) { return src * 2.0; }"));
+	CHECK(contains(out.glsl, "struct Pair { float src; float dst; };"));
+	CHECK(contains(out.glsl, "p.src = flowvk_table_src[flowvk_handle_src] . data[i];"));
+	CHECK(contains(out.glsl, "p.dst = helper(p.src);"));
+	CHECK(contains(out.glsl, "flowvk_table_dst[flowvk_handle_dst].data[i] = p.dst + float(flowvk_table_src[flowvk_handle_src].data.length());"));
+	CHECK(contains(out.glsl, "// src.data is read and dst.data written; comments stay as written."));
+	CHECK(contains(out.glsl, "/* dst.data */"));
+	CHECK(!contains(out.glsl, "ERROR"));
+
+	CHECK(contains(out.hpp, "Flow::shader_meta::BufferModel::Bindless"));
+	CHECK(contains(out.hpp, ".push_bytes = 8u"));
+	CHECK(contains(out.hpp, "Flow::shader_meta::Layout::Std430, 0u, 0u, 4u, {}, 4u}"));
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 4)
+	{
+		std::cerr << "Usage: FlowVk_ShaderPPTest <FlowVk_ShaderPP> <shader dir> <output dir>\n";
+		return 2;
+	}
+	const fs::path tool = argv[1];
+	const fs::path shaders = argv[2];
+	const fs::path outDir = argv[3];
+	fs::create_directories(outDir);
+
+	test_descriptors(tool, shaders, outDir);
+	test_device_address(tool, shaders, outDir);
+	test_device_address_unsized_length(tool, shaders, outDir);
+	test_bindless(tool, shaders, outDir);
+	test_bindless_scope(tool, shaders, outDir);
+
+	return flow_test::exit_code();
+}